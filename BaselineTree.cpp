@@ -0,0 +1,104 @@
+#include "BaselineTree.hpp"
+#include "StatementTree.hpp"
+#include <cstring>
+
+using std::list;
+
+//Parses the given string into a tree, splitting at the top-level operator
+BaselineTree::BaselineTree(const char* input) : is_affirmed(true)
+{
+  //Copy the input to modify it during parsing
+  atom_name = new char[strlen(input)+1];
+  strcpy(atom_name, input);
+
+  stripParens(atom_name);
+  int operator_pos = findOperator(atom_name);
+  node_type = StatementTree::operatorType(atom_name[operator_pos]);
+  if(node_type == StatementTree::ATOM) return;
+
+  //Extract the substrings for the child nodes
+  char* left = new char[operator_pos+1];
+  char* right = new char[strlen(atom_name)-operator_pos];
+  strncpy(left, atom_name, operator_pos);
+  left[operator_pos] = '\0';
+  strcpy(right, atom_name+operator_pos+1);
+  delete [] atom_name;
+  atom_name = NULL;
+
+  children.push_front(new BaselineTree(right));
+  if(strlen(left) != 0 && node_type != StatementTree::NOT)
+    children.push_front(new BaselineTree(left));
+  delete [] left;
+  delete [] right;
+
+  consolidateNegation();
+}
+
+BaselineTree::~BaselineTree()
+{
+  delete [] atom_name;
+  for(list<BaselineTree*>::iterator itr = children.begin(); itr != children.end(); itr++)
+    delete *itr;
+}
+
+//Takes the only child's place, with the inverse of its negation flag.
+void BaselineTree::consolidateNegation()
+{
+  if(node_type != StatementTree::NOT) return;
+
+  BaselineTree* old_child = children.front();
+  children.pop_front();
+  children.splice(children.end(), old_child->children);
+  node_type = old_child->node_type;
+  is_affirmed = !old_child->is_affirmed;
+  atom_name = old_child->atom_name;
+  old_child->atom_name = NULL;
+  delete old_child;
+}
+
+//((a&c)|(b&c)) -> (a&c)|(b&c)
+void BaselineTree::stripParens(char* input)
+{
+  int len = strlen(input);
+  if(len == 0) return;
+
+  int strip_count = 0;
+  while(true)
+  {
+    if(input[0] != '(') break;
+
+    int paren_depth = 1;
+    int close_index;
+    for(close_index = strip_count+1; close_index < len; close_index++)
+    {
+      if(input[close_index] == '(') paren_depth++;
+      else if(input[close_index] == ')') paren_depth--;
+
+      if(paren_depth == 0) break;
+    }
+
+    if(close_index != len-strip_count-1) break;
+    else strip_count++;
+  }
+
+  input[len-strip_count] = '\0';
+  for(int i = strip_count; i <= len-strip_count; i++)
+    input[i-strip_count] = input[i];
+}
+
+//a&b&c -> 3, a&b|c -> 3, (a&b)&c -> 5
+int BaselineTree::findOperator(char* input)
+{
+  int len = strlen(input);
+  for(int type = StatementTree::OP_START; type <= StatementTree::OP_END; type++)
+  {
+    int paren_depth = 0;
+    for(int i = len-1; i >= 0; i--)
+    {
+      if(input[i] == ')') paren_depth++;
+      else if(input[i] == '(') paren_depth--;
+      else if(paren_depth == 0 && StatementTree::operatorType(input[i]) == type) return i;
+    }
+  }
+  return len;
+}
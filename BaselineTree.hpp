@@ -0,0 +1,51 @@
+#ifndef __BASELINE_TREE_H_
+#define __BASELINE_TREE_H_
+
+#include <list>
+
+/// <summary>
+/// The sentence parser StatementTree used before it parsed in a single pass,
+/// kept for parseBenchmark to time against. Each node copies its input,
+/// strips enclosing parentheses, scans the string once per operator type
+/// for the split point and parses each half into a new node, which takes
+/// time quadratic in the length of the sentence. Only used for timing, not
+/// for checking proofs.
+/// </summary>
+class BaselineTree
+{
+  private:
+  int node_type;
+  std::list<BaselineTree*> children;
+  char* atom_name;
+  bool is_affirmed;
+
+  /// <summary>
+  /// Makes a negation node into a negation flag on its only child, which
+  /// this node takes the place of.
+  /// </summary>
+  void consolidateNegation();
+
+  /// <summary>
+  /// Removes any parentheses which enclose the whole string, in place.
+  /// </summary>
+  /// <param name="input">Sentence to strip</param>
+  static void stripParens(char* input);
+
+  /// <summary>
+  /// Finds the last instance of the lowest precedence operator outside of
+  /// any parentheses.
+  /// </summary>
+  /// <param name="input">Sentence to split</param>
+  /// <returns>Position of the operator, or the length if there is none</returns>
+  static int findOperator(char* input);
+
+  public:
+  /// <summary>
+  /// Parses an infix notation sentence into a tree.
+  /// </summary>
+  /// <param name="input">Logical sentence to parse</param>
+  BaselineTree(const char* input);
+  ~BaselineTree();
+};
+
+#endif
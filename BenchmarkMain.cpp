@@ -0,0 +1,164 @@
+#include "BaselineTree.hpp"
+#include "StatementTree.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using std::cerr;
+using std::cout;
+using std::string;
+
+#define BASELINE_RUN_LIMIT (64 * 1024) //Longer runs take the baseline parser minutes
+
+/// <summary>
+/// Small deterministic generator, so every run parses the same sentences.
+/// </summary>
+class SentenceGenerator
+{
+  private:
+  unsigned long long state;
+
+  int next(int limit)
+  {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (int)((state >> 33) % limit);
+  }
+
+  public:
+  SentenceGenerator() : state(1)
+  {}
+
+  /// <summary>
+  /// Appends a run of about length characters like "a1&!a2|a3", with no
+  /// parentheses, so it relies on precedence.
+  /// </summary>
+  void appendRun(string& sentence, int length)
+  {
+    //About four characters per atom
+    int atoms = (length < 8) ? 1 : length / 4;
+    for(int i = 0; i < atoms; i++)
+    {
+      if(i > 0) sentence += (next(2) == 0) ? '&' : '|';
+      if(next(3) == 0) sentence += '!';
+      sentence += 'a';
+      sentence += std::to_string(next(100));
+    }
+  }
+
+  /// <summary>
+  /// Appends a sentence of about length characters: parenthesized halves
+  /// joined by a random operator, some negated, down to short runs.
+  /// </summary>
+  void append(string& sentence, int length)
+  {
+    static const char operators[] = { '&', '|', '>', '=' };
+    if(next(4) == 0) sentence += '!';
+    if(length < 16)
+    {
+      appendRun(sentence, length);
+      return;
+    }
+    //Parentheses and the operator take five characters
+    int left = (length - 5) / 2;
+    sentence += '(';
+    append(sentence, left);
+    sentence += ')';
+    sentence += operators[next(4)];
+    sentence += '(';
+    append(sentence, length - 5 - left);
+    sentence += ')';
+  }
+};
+
+/// <summary>
+/// Parses a sentence into a tree and releases it again, with one of the
+/// parsers being timed.
+/// </summary>
+typedef void (*parse_function)(const string& sentence);
+
+void parseSinglePass(const string& sentence)
+{ StatementTree::release(StatementTree::create(sentence.c_str())); }
+
+void parseBaseline(const string& sentence)
+{ delete new BaselineTree(sentence.c_str()); }
+
+/// <summary>
+/// Times parsing a sentence over and over, for enough repetitions to parse
+/// about 4 MB of text, or about a second at most for a slow parser.
+/// </summary>
+/// <param name="parse">Parser to time</param>
+/// <param name="sentence">Sentence to parse</param>
+/// <returns>Average seconds per parse</returns>
+double timeParse(parse_function parse, const string& sentence)
+{
+  int repetitions = 1 + (4 * 1024 * 1024) / (int)sentence.size();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed(0);
+  int done = 0;
+  while(done < repetitions && elapsed.count() < 1)
+  {
+    parse(sentence);
+    done++;
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+  return elapsed.count() / done;
+}
+
+/// <summary>
+/// Times parsing long generated sentences, with StatementTree::create and
+/// with the parser it replaced (see BaselineTree). Each size is generated
+/// two ways: nested in parentheses, and as one long run without any. For
+/// each, prints the length of the sentence, then for each parser the average
+/// time to parse and release it and the time per character. Times should be
+/// taken from an optimized build. The baseline parser isn't timed on runs
+/// longer than BASELINE_RUN_LIMIT. Sizes in bytes may be given as arguments;
+/// they default to 6, 34 and 149 KB.
+/// </summary>
+int main(int nargs, char** args)
+{
+  int default_sizes[] = { 6 * 1024, 34 * 1024, 149 * 1024 };
+  int size_count = (nargs > 1) ? nargs - 1 : 3;
+  for(int i = 0; i < size_count; i++)
+  {
+    int size = (nargs > 1) ? atoi(args[i + 1]) : default_sizes[i];
+    if(size < 1)
+    {
+      cerr << "Usage: " << args[0] << " [<sentence size in bytes>...]\n";
+      return 1;
+    }
+
+    for(int shape = 0; shape < 2; shape++)
+    {
+      string sentence;
+      SentenceGenerator generator;
+      if(shape == 0) generator.append(sentence, size);
+      else generator.appendRun(sentence, size);
+
+      StatementTree* tree = StatementTree::create(sentence.c_str());
+      bool valid = tree->isValid();
+      StatementTree::release(tree);
+      if(!valid)
+      {
+        cerr << "Error: generated sentence is not well-formed\n";
+        return 1;
+      }
+
+      cout << sentence.size() << " bytes, " << (shape == 0 ? "nested" : "one run") << ":\n";
+      const char* names[] = { "  baseline:    ", "  single pass: " };
+      parse_function parsers[] = { parseBaseline, parseSinglePass };
+      for(int j = 0; j < 2; j++)
+      {
+        if(parsers[j] == parseBaseline && shape == 1 && sentence.size() > BASELINE_RUN_LIMIT)
+        {
+          cout << names[j] << "not timed, run is longer than " << BASELINE_RUN_LIMIT << " bytes\n";
+          continue;
+        }
+        double seconds = timeParse(parsers[j], sentence);
+        cout << names[j] << (seconds * 1e3) << " ms per parse, "
+          << (seconds * 1e9 / sentence.size()) << " ns per byte\n";
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include "Proof.hpp"
+#include "ProofReader.hpp"
+#include "ProofRules.hpp"
+#include "BinaryProof.hpp"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#if defined(EMBED_DEFAULT_RULES)
+#include "DefaultRules.hpp"
+#endif
+
+using std::cerr;
+
+/// <summary>
+/// Converts a proof file to the binary format (see BinaryProof). Expects the
+/// name of the proof file to convert and the name of the binary file to
+/// write. The proof is read but not verified; lemma proofs are verified as
+/// usual while reading, but their printout is left out. With -r first, the
+/// rules file is read as well as the built in rules, as for logicVerifier.
+/// </summary>
+int main(int nargs, char** args)
+{
+#if defined(EMBED_DEFAULT_RULES)
+  ProofRules::setBuiltInRules(default_rule_pack, default_rule_pack_size);
+#endif
+  if(nargs == 4 && strcmp(args[1], "-r") == 0)
+  {
+    ProofRules::setExternalRules(true);
+    args++;
+    nargs--;
+  }
+  if(nargs != 3)
+  {
+    cerr << "Usage: " << args[0] << " [-r] <input filename> <output filename>\n";
+    return 1;
+  }
+
+  Proof p;
+  ProofReader r;
+  std::stringstream lemma_output;
+  p.setOutput(lemma_output);
+  r.setOutput(lemma_output, cerr);
+  r.setTarget(&p);
+  if(!r.readFile(args[1]))
+  {
+    cerr << "Program terminated: errors encountered while reading file(s)\n";
+    return 1;
+  }
+
+  BinaryProof binary;
+  return binary.write(p, r.getLemmaLines(), args[2]) ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+#ifndef __DEFAULT_RULES_H_
+#define __DEFAULT_RULES_H_
+
+#include <cstddef>
+
+/// <summary>
+/// The rules in rules.xml, compiled to a rule pack (see RulePack) when the
+/// program is built and given to ProofRules::setBuiltInRules. Only defined
+/// when EMBED_DEFAULT_RULES is; the source is generated by the build (see
+/// cmake/EmbedRulePack.cmake).
+/// </summary>
+extern const unsigned char default_rule_pack[];
+extern const size_t default_rule_pack_size;
+
+#endif
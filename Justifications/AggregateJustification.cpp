@@ -30,10 +30,30 @@ bool AggregateJustification::isJustified(StatementTree& consequent,
   return false;
 }
 
+tree_hash AggregateJustification::fingerprint()
+{
+  tree_hash hash = Justification::fingerprint();
+  list<Justification*>::iterator itr = rules.begin();
+  for(; itr != rules.end(); itr++)
+    hash = StatementTree::mixHash(hash, (*itr)->fingerprint());
+  return hash;
+}
+
+bool AggregateJustification::checkSoundness()
+{
+  list<Justification*>::iterator itr = rules.begin();
+  for(; itr != rules.end(); itr++)
+    if(!(*itr)->isSound()) return false;
+  return true;
+}
+
 //Adds a subrule to check for.
 void AggregateJustification::addRule(Justification* new_rule)
 {
   if(new_rule == NULL) return;
   rules.push_back(new_rule);
+  soundnessChanged();
 }
 
+const list<Justification*>& AggregateJustification::getRules()
+{ return rules; }
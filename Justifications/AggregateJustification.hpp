@@ -17,6 +17,13 @@ class AggregateJustification : public Justification
 {
   private:
   std::list<Justification*> rules;
+
+  protected:
+  /// <summary>
+  /// An aggregate rule is sound if every one of its subrules is.
+  /// </summary>
+  /// <returns>True if all the subrules are sound</returns>
+  bool checkSoundness();
   
   public:
   AggregateJustification(const char* name) : Justification(name)
@@ -38,6 +45,12 @@ class AggregateJustification : public Justification
   ///   application.
   /// </returns>
   bool isJustified(StatementTree& consequent, antecedent_list& antecedents);
+
+  /// <summary>
+  /// Hash of the rule's name and the fingerprints of each of its subrules.
+  /// </summary>
+  /// <returns>Hash of the rule</returns>
+  tree_hash fingerprint();
   
   /// <summary>
   /// Adds a possible form of this rule.
@@ -46,6 +59,12 @@ class AggregateJustification : public Justification
   ///   New justification rule to try for applicablility.
   /// </param>
   void addRule(Justification* new_rule);
+
+  /// <summary>
+  /// The subrules of this rule, in the order they were added.
+  /// </summary>
+  /// <returns>Subrules</returns>
+  const std::list<Justification*>& getRules();
 };
 
 #endif
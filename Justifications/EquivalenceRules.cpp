@@ -1,4 +1,6 @@
 #include "EquivalenceRules.hpp"
+#include "TruthTable.hpp"
+#include <algorithm>
 #include <list>
 #include <utility>
 #include <iostream>
@@ -6,50 +8,204 @@
 using std::map;
 using std::list;
 using std::pair;
+using std::unordered_map;
+using std::vector;
 using std::cout;
 using std::endl;
 
 EquivalenceRule::~EquivalenceRule()
 {
-  list<equiv_pair>::iterator itr = equivalent_pairs.begin();
+  list<equiv_variants>::iterator itr = equivalent_pairs.begin();
   for(; itr != equivalent_pairs.end(); itr++)
   {
-    delete itr->first;
-    delete itr->second;
+    for(int i = 0; i < 2; i++)
+    {
+      StatementTree::release(itr->variants[i].first);
+      StatementTree::release(itr->variants[i].second);
+    }
   }
 }
 
 //Adds a pair of equivalent sentences which can be applied.
 void EquivalenceRule::addEquivalentPair(const char* form1, const char* form2)
 {
-  equiv_pair new_equivalence(new StatementTree(form1), new StatementTree(form2));
+  equiv_pair new_equivalence(StatementTree::create(form1), StatementTree::create(form2));
   if(!new_equivalence.first->isValid() || !new_equivalence.second->isValid())
   {
-    delete new_equivalence.first;
-    delete new_equivalence.second;
+    StatementTree::release(new_equivalence.first);
+    StatementTree::release(new_equivalence.second);
     return;
   }
-  equivalent_pairs.push_back(new_equivalence);
+  
+  //Also make the variant with both roots negated
+  equiv_pair negated(StatementTree::create(*new_equivalence.first, false),
+    StatementTree::create(*new_equivalence.second, false));
+  equiv_variants variants;
+  variants.variants[new_equivalence.first->isAffirmed()] = new_equivalence;
+  variants.variants[negated.first->isAffirmed()] = negated;
+  equivalent_pairs.push_back(variants);
+  indexLastPair();
+  soundnessChanged();
+}
+
+void EquivalenceRule::addEquivalentVariants(const equiv_variants& variants)
+{
+  equiv_variants added;
+  for(int i = 0; i < 2; i++)
+  {
+    added.variants[i].first = StatementTree::create(*variants.variants[i].first);
+    added.variants[i].second = StatementTree::create(*variants.variants[i].second);
+  }
+  equivalent_pairs.push_back(added);
+  indexLastPair();
+  soundnessChanged();
+}
+
+//Both ways of trying the pair go under the root type of the form the first
+//sentence is matched with, which is the same in both variants.
+void EquivalenceRule::indexLastPair()
+{
+  const equiv_variants& variants = equivalent_pairs.back();
+  for(int reversed = 0; reversed < 2; reversed++)
+  {
+    pair_attempt attempt;
+    attempt.pair = &variants;
+    attempt.reversed = reversed != 0;
+    for(int i = 0; i < 2; i++)
+    {
+      const equiv_pair& forms = variants.variants[i];
+      attempt.shapes[i][0] = shapeOf(reversed ? forms.second : forms.first, false, true);
+      attempt.shapes[i][1] = shapeOf(reversed ? forms.first : forms.second, false, true);
+    }
+
+    StatementTree* first_form = reversed ? variants.variants[0].second : variants.variants[0].first;
+    for(int type = 0; type < FORM_SHAPE_NODE_TYPES; type++)
+      if(first_form->nodeType() == StatementTree::ATOM || first_form->nodeType() == type)
+        attempts_by_root[type].push_back(attempt);
+  }
+}
+
+//Each node's code combines its type and negation flag.
+form_shape EquivalenceRule::shapeOf(StatementTree* tree, bool flip_root, bool is_form)
+{
+  form_shape shape;
+  shape.codes[0] = shape.codes[1] = shape.codes[2] = FORM_SHAPE_ANY;
+  if(is_form && tree->nodeType() == StatementTree::ATOM) return shape;
+
+  shape.codes[0] = tree->nodeType() * 2 + ((tree->isAffirmed() != flip_root) ? 1 : 0);
+  int child_index = 1;
+  for(child_itr itr = tree->begin(); itr != tree->end(); itr++, child_index++)
+  {
+    StatementTree* child = *itr;
+    if(!is_form || child->nodeType() != StatementTree::ATOM)
+      shape.codes[child_index] = child->nodeType() * 2 + (child->isAffirmed() ? 1 : 0);
+  }
+  return shape;
+}
+
+bool EquivalenceRule::shapeFits(const form_shape& target, const form_shape& form)
+{
+  for(int i = 0; i < 3; i++)
+    if(form.codes[i] != FORM_SHAPE_ANY && form.codes[i] != target.codes[i]) return false;
+  return true;
+}
+
+//Each form must entail the other. Both polarity variants are equivalent if
+//one is.
+bool EquivalenceRule::formsEquivalent(const equiv_pair& forms)
+{
+  TruthTable table;
+  vector<int> first(1, table.addSentence(forms.first));
+  vector<int> second(1, table.addSentence(forms.second));
+  if(table.atomCount() > TRUTH_TABLE_MAX_ATOMS) return false;
+  return table.entails(first, second[0]) && table.entails(second, first[0]);
+}
+
+bool EquivalenceRule::checkSoundness()
+{
+  list<equiv_variants>::iterator itr = equivalent_pairs.begin();
+  for(; itr != equivalent_pairs.end(); itr++)
+    if(!formsEquivalent(itr->variants[0])) return false;
+  return true;
 }
 
+const list<equiv_variants>& EquivalenceRule::getEquivalentPairs()
+{ return equivalent_pairs; }
+
 bool EquivalenceRule::isJustified(StatementTree& consequent, 
   antecedent_list& antecedents)
 {
   if(antecedents.size() != 1) return false;
-  return areEquivalent(&consequent, antecedents.front()->getStatementData());
+  equiv_memo memo;
+  return areEquivalent(&consequent, antecedents.front()->getStatementData(), memo);
+}
+
+//Trees are interned from their text, so their structural hashes identify the
+//forms.
+tree_hash EquivalenceRule::fingerprint()
+{
+  tree_hash hash = Justification::fingerprint();
+  list<equiv_variants>::iterator itr = equivalent_pairs.begin();
+  for(; itr != equivalent_pairs.end(); itr++)
+  {
+    for(int i = 0; i < 2; i++)
+    {
+      hash = StatementTree::mixHash(hash, itr->variants[i].first->structureHash());
+      hash = StatementTree::mixHash(hash, itr->variants[i].second->structureHash());
+    }
+  }
+  return hash;
+}
+
+//Looks up whether the given sentences have already been compared, and if not
+//works it out.
+bool EquivalenceRule::areEquivalent(StatementTree* tree1, StatementTree* tree2,
+  equiv_memo& memo, bool flip_first) const
+{
+  if(tree1 == NULL || tree2 == NULL) return false;
+  
+  equiv_memo_key key = { tree1, tree2, flip_first };
+  pair<unordered_map<equiv_memo_key, int, equiv_memo_hash>::iterator, bool> entry =
+    memo.results.insert(pair<equiv_memo_key, int>(key, memo.depth));
+  if(!entry.second)
+  {
+    int state = entry.first->second;
+    if(state == EQUIV_MEMO_TRUE) return true;
+    if(state == EQUIV_MEMO_FALSE) return false;
+    memo.lowest_pending = std::min(memo.lowest_pending, state);
+    return false;
+  }
+  
+  //The entry is pending while this comparison is under way, so if it comes up
+  //again further down it's not repeated. A failure is only kept if nothing
+  //pending from further up was relied on.
+  int outer_lowest = memo.lowest_pending;
+  memo.lowest_pending = INT_MAX;
+  memo.depth++;
+  bool result = findEquivalence(tree1, tree2, memo, flip_first);
+  memo.depth--;
+  if(result)
+    memo.results[key] = EQUIV_MEMO_TRUE; //entry may have been invalidated by rehashing
+  else if(memo.lowest_pending >= memo.depth)
+    memo.results[key] = EQUIV_MEMO_FALSE;
+  else
+    memo.results.erase(key);
+  memo.lowest_pending = std::min(outer_lowest, memo.lowest_pending);
+  return result;
 }
 
 //Checks if the given sentences are equivalent using only the equivalences given to
 //this rule.
-bool EquivalenceRule::areEquivalent(StatementTree* tree1, StatementTree* tree2)
+bool EquivalenceRule::findEquivalence(StatementTree* tree1, StatementTree* tree2,
+  equiv_memo& memo, bool flip_first) const
 {
-  if(tree1 == NULL || tree2 == NULL) return false;
-  bind_map binds;
+  BindTable binds;
+  bool affirmed1 = tree1->isAffirmed() != flip_first;
   
   //Root is the same, check equivalence of children
-  if(tree1->nodeType() == tree2->nodeType() && tree1->isAffirmed() == tree2->isAffirmed())
+  if(tree1->nodeType() == tree2->nodeType() && affirmed1 == tree2->isAffirmed())
   {
-    if(tree1->nodeType() == StatementTree::ATOM) return tree1->equals(*tree2);
+    if(tree1->nodeType() == StatementTree::ATOM) return tree1->atomId() == tree2->atomId();
     //Atoms must be equal to be equivalent
     
     child_itr itr1 = tree1->begin();
@@ -57,7 +213,7 @@ bool EquivalenceRule::areEquivalent(StatementTree* tree1, StatementTree* tree2)
     bool all_children_equiv = true; //Might be unneeded; itrs wont reach end if break happens
     for(; itr1 != tree1->end(), itr2 != tree2->end(); itr1++, itr2++)
     {
-      if(!areEquivalent(*itr1, *itr2))
+      if(!areEquivalent(*itr1, *itr2, memo))
       {
         all_children_equiv = false;
         break;
@@ -71,20 +227,23 @@ bool EquivalenceRule::areEquivalent(StatementTree* tree1, StatementTree* tree2)
     //slower with buried equivalence.
   }
   
-  //Check the equivalent pairs
-  list<equiv_pair>::iterator itr = equivalent_pairs.begin();
-  for(; itr != equivalent_pairs.end(); itr++)
+  //Check the equivalent pairs that could apply to sentences of these shapes
+  form_shape shape1 = shapeOf(tree1, flip_first, false);
+  form_shape shape2 = shapeOf(tree2, false, false);
+  const vector<pair_attempt>& attempts = attempts_by_root[tree1->nodeType()];
+  for(vector<pair_attempt>::const_iterator itr = attempts.begin(); itr != attempts.end(); itr++)
   {
-    //tree1 is of first form & tree2 is of second
-    matchFormOneNegation(tree1, *itr);
-    bool result = match(tree1, itr->first, binds) && match(tree2, itr->second, binds);
-    removeBoundForms(binds);
-    if(result) return true;
-    
-    //tree1 is of second form & tree2 is of first
-    matchFormOneNegation(tree2, *itr);
-    result = match(tree1, itr->second, binds) && match(tree2, itr->first, binds);
-    removeBoundForms(binds);
+    //Pick the variant whose negation matches the tree matched with form 1
+    bool variant = itr->reversed ? tree2->isAffirmed() : affirmed1;
+    if(!shapeFits(shape1, itr->shapes[variant][0]) || !shapeFits(shape2, itr->shapes[variant][1]))
+      continue;
+
+    //tree1 is of first form & tree2 is of second, or the reverse
+    const equiv_pair* forms = &matchFormOneNegation(variant, *itr->pair);
+    bool result = itr->reversed ?
+      match(tree1, forms->second, binds, memo, flip_first) && match(tree2, forms->first, binds, memo) :
+      match(tree1, forms->first, binds, memo, flip_first) && match(tree2, forms->second, binds, memo);
+    binds.clear();
     if(result) return true;
   }
   
@@ -94,45 +253,38 @@ bool EquivalenceRule::areEquivalent(StatementTree* tree1, StatementTree* tree2)
 
 //Returns whether or not target can fit the given form while maintaining any previous
 //sentence variable bindings.
-bool EquivalenceRule::match(StatementTree* target, StatementTree* form, bind_map& binds)
+bool EquivalenceRule::match(StatementTree* target, StatementTree* form, BindTable& binds,
+  equiv_memo& memo, bool flip_target) const
 {
   //The form is a sentence variable; if it's unbound, bind & return. Else return whether
   //the target is equivalent to the bound sentence.
   if(form->nodeType() == StatementTree::ATOM)
   {
-    StatementTree* sentence = new StatementTree(*target, form->isAffirmed());
-    pair<bind_map::iterator, bool> retval = 
-      binds.insert(pair<char, StatementTree*>(form->atomName()[0], sentence));
-    
-    if(retval.second) return true;
-    else
+    //A negated variable binds the target with its root negation inverted
+    bool flipped = flip_target == form->isAffirmed();
+    bound_form* bound = binds.find(form->atomName()[0]);
+    if(bound == NULL)
     {
-      bool result = areEquivalent(sentence, retval.first->second);
-      delete sentence;
-      return result;
+      binds.bind(form->atomName()[0], target, flipped);
+      return true;
     }
+    return areEquivalent(target, bound->tree, memo, flipped != bound->flipped);
   }
   
   //The form is not a sentence variable, return true if target matches form's type &
   //affirmation & corresponding children also match.
-  if(target->nodeType() != form->nodeType() || target->isAffirmed() != form->isAffirmed())
+  if(target->nodeType() != form->nodeType() ||
+    (target->isAffirmed() != flip_target) != form->isAffirmed())
     return false;
   child_itr itr1 = target->begin();
   child_itr itr2 = form->begin();
   for(; itr1 != target->end(), itr2 != form->end(); itr1++, itr2++)
-    if(!match(*itr1, *itr2, binds)) return false;
+    if(!match(*itr1, *itr2, binds, memo)) return false;
   return itr1 == target->end() && itr2 == form->end();
 }
 
-//Simultaneously toggles form negation to ensure form 1's negation
-//matches the target. (note a == !b <==> !a == b).
-void EquivalenceRule::matchFormOneNegation(StatementTree* target, equiv_pair& source)
-{
-  if(target->isAffirmed() != source.first->isAffirmed())
-  {
-    //form 1 negation doesn't match target negation, so flip both forms.
-    source.first->negate();
-    source.second->negate();
-  }
-}
-
+//Picks the variant of the pair whose form 1 negation matches the target.
+//(note a == !b <==> !a == b).
+const equiv_pair& EquivalenceRule::matchFormOneNegation(bool target_affirmed,
+  const equiv_variants& source) const
+{ return source.variants[target_affirmed]; }
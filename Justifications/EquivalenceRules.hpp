@@ -8,12 +8,110 @@ class EquivalenceRule;
 #include "ProofStatement.hpp"
 #include <utility>
 #include <list>
+#include <climits>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#define FORM_SHAPE_ANY -1
+#define FORM_SHAPE_NODE_TYPES (StatementTree::OP_END + 1)
+#define EQUIV_MEMO_TRUE -1
+#define EQUIV_MEMO_FALSE -2
 
 /// <summary>
 /// Represents a pair of syntax trees which are logically equivalent.
 /// </summary>
 typedef std::pair<StatementTree*, StatementTree*> equiv_pair;
 
+/// <summary>
+/// An equivalent pair in both polarities: as given, and with the negation
+/// flag at the root of both forms inverted (a == b <==> !a == !b). Indexed by
+/// whether the first form's root is affirmed, so the variant to match a
+/// target with is variants[target->isAffirmed()].
+/// </summary>
+struct equiv_variants
+{
+  equiv_pair variants[2];
+};
+
+/// <summary>
+/// The top of a form or sentence: the node type and negation flag of the
+/// root and of each of its children, as one code per node (see
+/// EquivalenceRule::shapeOf). In a form, a sentence variable can match
+/// anything, so its code is FORM_SHAPE_ANY. A sentence can only match a form
+/// if every code in the form's shape that isn't FORM_SHAPE_ANY is the same
+/// in the sentence's.
+/// </summary>
+struct form_shape
+{
+  int codes[3]; //Root, left child, right child
+};
+
+/// <summary>
+/// One way of trying an equivalent pair against two sentences: the first
+/// sentence with form 1 and the second with form 2, or reversed. The shapes
+/// of the forms the first and second sentences are matched with are kept
+/// for both polarity variants of the pair.
+/// </summary>
+struct pair_attempt
+{
+  const equiv_variants* pair;
+  bool reversed;
+  form_shape shapes[2][2]; //By variant, then by which sentence it's matched with
+};
+
+/// <summary>
+/// A pair of sentences compared by areEquivalent, with the root negation
+/// flag of the first one possibly inverted. Trees are interned, so they're
+/// identified by address.
+/// </summary>
+struct equiv_memo_key
+{
+  StatementTree* tree1;
+  StatementTree* tree2;
+  bool flip_first;
+
+  bool operator==(const equiv_memo_key& other) const
+  {
+    return tree1 == other.tree1 && tree2 == other.tree2 &&
+      flip_first == other.flip_first;
+  }
+};
+
+/// <summary>
+/// Hash function for equiv_memo_key
+/// </summary>
+struct equiv_memo_hash
+{
+  size_t operator()(const equiv_memo_key& key) const
+  {
+    size_t hash = (size_t)key.tree1 * 31 + (size_t)key.tree2;
+    return (hash ^ (hash >> 17)) * 2 + (key.flip_first ? 1 : 0);
+  }
+};
+
+/// <summary>
+/// Results of areEquivalent for the pairs of subtrees examined while checking
+/// one proof line. The same pairs come up again and again when variables are
+/// bound to overlapping subtrees, so each pair is only worked out once.
+///
+/// Each entry is EQUIV_MEMO_TRUE or EQUIV_MEMO_FALSE, or for a comparison
+/// still under way, its depth among the comparisons under way (pending). A
+/// pending comparison that comes up again is taken as not equivalent, so it
+/// isn't repeated forever, but that only holds within the comparison it's
+/// part of. A comparison that failed after coming across a pending one
+/// outside of itself isn't kept, as it might work out when tried again.
+/// </summary>
+struct equiv_memo
+{
+  std::unordered_map<equiv_memo_key, int, equiv_memo_hash> results;
+  int depth; //Number of comparisons under way
+  int lowest_pending; //Shallowest depth of a pending comparison come across
+
+  equiv_memo() : depth(0), lowest_pending(INT_MAX)
+  {}
+};
+
 //Checks justification using an equivalence rule, i.e. can be applied
 //to subsentences and can be used in either direction.
 
@@ -29,7 +127,48 @@ typedef std::pair<StatementTree*, StatementTree*> equiv_pair;
 class EquivalenceRule : public Justification
 {
   private:
-  std::list<equiv_pair> equivalent_pairs;
+  std::list<equiv_variants> equivalent_pairs;
+
+  /// <summary>
+  /// Every way of trying each equivalent pair, in the order they're tried,
+  /// by the node type that the root of the first sentence must have. An
+  /// attempt whose first form is a sentence variable is under every type.
+  /// </summary>
+  std::vector<pair_attempt> attempts_by_root[FORM_SHAPE_NODE_TYPES];
+
+  /// <summary>
+  /// Adds the ways of trying the equivalent pair most recently added to
+  /// equivalent_pairs to attempts_by_root.
+  /// </summary>
+  void indexLastPair();
+
+  /// <summary>
+  /// Checks by truth table that the forms of a pair are logically
+  /// equivalent, taking each sentence variable as an atom.
+  /// </summary>
+  /// <param name="forms">Pair to check</param>
+  /// <returns>False if they aren't, or have too many variables to check</returns>
+  static bool formsEquivalent(const equiv_pair& forms);
+
+  /// <summary>
+  /// Works out the shape of a form or sentence.
+  /// </summary>
+  /// <param name="tree">Form or sentence</param>
+  /// <param name="flip_root">Whether the negation flag at the root is inverted</param>
+  /// <param name="is_form">
+  ///   True if the tree is a form, so atoms are sentence variables that match
+  ///   anything.
+  /// </param>
+  /// <returns>The shape</returns>
+  static form_shape shapeOf(StatementTree* tree, bool flip_root, bool is_form);
+
+  /// <summary>
+  /// Whether a sentence with one shape could match a form with another.
+  /// </summary>
+  /// <param name="target">Shape of the sentence</param>
+  /// <param name="form">Shape of the form</param>
+  /// <returns>False if the sentence certainly can't match the form</returns>
+  static bool shapeFits(const form_shape& target, const form_shape& form);
   
   /// <summary>
   /// Checks whether two logical sentences are equivalent by way of application
@@ -42,11 +181,25 @@ class EquivalenceRule : public Justification
   /// </summary>
   /// <param name="tree1">The first sentence</param>
   /// <param name="tree2">The second sentence</param>
+  /// <param name="memo">
+  ///   Results of previous comparisons made while checking the same line.
+  /// </param>
+  /// <param name="flip_first">
+  ///   If true, the first sentence is taken with the negation flag at its
+  ///   root inverted. Used to compare bound sentence views.
+  /// </param>
   /// <returns>
   ///   True if the first and second sentences are logically equivalent by
   ///   use of this rule.
   /// </returns>
-  bool areEquivalent(StatementTree* tree1, StatementTree* tree2);
+  bool areEquivalent(StatementTree* tree1, StatementTree* tree2, equiv_memo& memo,
+    bool flip_first=false) const;
+
+  /// <summary>
+  /// Does the work of areEquivalent when the result isn't memoized yet.
+  /// </summary>
+  bool findEquivalence(StatementTree* tree1, StatementTree* tree2, equiv_memo& memo,
+    bool flip_first) const;
 
   /// <summary>
   /// Determines whether a statement tree can be considered to be an instance
@@ -66,6 +219,10 @@ class EquivalenceRule : public Justification
   /// </summary>
   /// <param name="target">Sentence to try to match with the form</param>
   /// <param name="form">Form from an equivalent pair to match against</param>
+  /// <param name="flip_target">
+  ///   If true, the target is taken with the negation flag at its root
+  ///   inverted.
+  /// </param>
   /// <param name="binds">
   ///   Contains existing bindings between sentence variables and statement
   ///   trees which must be respected when looking for a match. If a match is
@@ -75,19 +232,23 @@ class EquivalenceRule : public Justification
   /// <returns>
   ///   True if a match between the target and the form can be made
   /// </returns>
-  bool match(StatementTree* target, StatementTree* form, bind_map& binds);
+  bool match(StatementTree* target, StatementTree* form, BindTable& binds,
+    equiv_memo& memo, bool flip_target=false) const;
 
   /// <summary>
-  /// Toggles the negation flag on the root node of both forms of an 
-  /// equivalent pair so that the root node negation of form 1 of the pair
-  /// matches the root node negation of a target statement tree which we are
-  /// trying to match with the pair.
+  /// Picks the polarity variant of an equivalent pair in which the root node
+  /// negation of form 1 matches the root node negation of a target statement
+  /// tree which we are trying to match with the pair. Both variants are made
+  /// when the pair is added, so rule data is never changed while checking and
+  /// one rule can be used from several threads at once.
   /// </summary>
-  /// <param name="target">Statement tree to match the root negation of</param>
-  /// <param name="source">
-  ///   Equivalent pair to potentially toggle the negation of.
+  /// <param name="target_affirmed">
+  ///   Root negation flag of the statement tree to match
   /// </param>
-  void matchFormOneNegation(StatementTree* target, equiv_pair& source);
+  /// <param name="source">Equivalent pair to pick the variant of</param>
+  /// <returns>Variant of the pair to match against</returns>
+  const equiv_pair& matchFormOneNegation(bool target_affirmed,
+    const equiv_variants& source) const;
   
   public:
   EquivalenceRule(const char* name) : Justification(name)
@@ -101,6 +262,20 @@ class EquivalenceRule : public Justification
   /// <param name="form1">First equivalent form</param>
   /// <param name="form2">Second equivalent form</param>
   void addEquivalentPair(const char* form1, const char* form2);
+
+  /// <summary>
+  /// Adds a pair of equivalent sentences that has already been parsed, in
+  /// both polarities (as read from a rule pack). The rule takes its own
+  /// references to the trees.
+  /// </summary>
+  /// <param name="variants">Both polarity variants of the pair</param>
+  void addEquivalentVariants(const equiv_variants& variants);
+
+  /// <summary>
+  /// The equivalent pairs of this rule, in the order they were added.
+  /// </summary>
+  /// <returns>Each pair in both polarities</returns>
+  const std::list<equiv_variants>& getEquivalentPairs();
   
   /// <summary>
   /// Application of an equivalence rule is considered justified if there is
@@ -119,6 +294,21 @@ class EquivalenceRule : public Justification
   ///   application.
   /// </returns>
   bool isJustified(StatementTree& consequent, antecedent_list& antecedents);
+
+  /// <summary>
+  /// Hash of the rule's name and each of its equivalent pairs, in order.
+  /// </summary>
+  /// <returns>Hash of the rule</returns>
+  tree_hash fingerprint();
+
+  protected:
+  /// <summary>
+  /// An equivalence rule is sound if the forms of each of its pairs are
+  /// logically equivalent, since replacing a subsentence with an equivalent
+  /// one gives an equivalent sentence.
+  /// </summary>
+  /// <returns>True if every pair was checked to be equivalent</returns>
+  bool checkSoundness();
 };
 
 #endif
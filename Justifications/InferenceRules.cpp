@@ -1,25 +1,37 @@
 #include "InferenceRules.hpp"
 #include "SubProof.hpp"
+#include "TruthTable.hpp"
+#include <algorithm>
 #include <utility>
 #include <iostream>
 
+#define ROOT_CODE_COUNT ((StatementTree::OP_END + 1) * 2)
+
 using std::list;
 using std::pair;
+using std::vector;
 using std::cout;
 using std::cerr;
 using std::endl;
 
+//Node type and negation of a tree's root, as one number under ROOT_CODE_COUNT.
+static int rootCode(StatementTree* tree)
+{ return tree->nodeType() * 2 + (tree->isAffirmed() ? 1 : 0); }
+
+//Orders forms with fewer candidate antecedents first.
+static bool fewerCandidates(const form_candidates& first, const form_candidates& second)
+{ return first.antecedents.size() < second.antecedents.size(); }
+
 InferenceRule::~InferenceRule()
 {
-  for each (required_form* form in required_forms)
+  for(required_form_list::iterator itr = required_forms.begin(); itr != required_forms.end(); itr++)
   {
-    delete form->statementForm;
-    if (form->subproofAssumptionForm != NULL)
-    {
-      delete form->subproofAssumptionForm;
-    }
-
+    required_form* form = *itr;
+    StatementTree::release(form->statementForm);
+    StatementTree::release(form->subproofAssumptionForm);
+    delete form;
   }
+  StatementTree::release(result_form);
 }
 
 //Adds a statement form that some antecedent must match for this inference rule
@@ -27,15 +39,65 @@ InferenceRule::~InferenceRule()
 void InferenceRule::addRequiredForm(const char* statement, const char* assumption)
 {
   required_form* new_form = new required_form;
-  new_form->statementForm = new StatementTree(statement);
+  new_form->statementForm = StatementTree::create(statement);
 
   //Set the assumption form if there is one, otherwise set it to null
   if (assumption != NULL)
-    new_form->subproofAssumptionForm = new StatementTree(assumption);
+    new_form->subproofAssumptionForm = StatementTree::create(assumption);
   else
     new_form->subproofAssumptionForm = NULL;
 
   required_forms.push_back(new_form);
+  soundnessChanged();
+}
+
+//Adds an already parsed required form.
+void InferenceRule::addRequiredForm(StatementTree* statement, StatementTree* assumption)
+{
+  required_form* new_form = new required_form;
+  new_form->statementForm = StatementTree::create(*statement);
+  new_form->subproofAssumptionForm = (assumption == NULL) ? NULL : StatementTree::create(*assumption);
+  required_forms.push_back(new_form);
+  soundnessChanged();
+}
+
+//Sentence variables are atoms to the truth table, so this checks that every
+//substitution into the required forms entails the same substitution into the
+//consequent form.
+bool InferenceRule::checkSoundness()
+{
+  TruthTable table;
+  vector<int> premises;
+  for(required_form_list::iterator itr = required_forms.begin(); itr != required_forms.end(); itr++)
+  {
+    if((*itr)->subproofAssumptionForm != NULL) return false;
+    premises.push_back(table.addSentence((*itr)->statementForm));
+  }
+  int conclusion = table.addSentence(result_form);
+  if(table.atomCount() > TRUTH_TABLE_MAX_ATOMS) return false;
+  return table.entails(premises, conclusion);
+}
+
+StatementTree* InferenceRule::getResultForm()
+{ return result_form; }
+
+const required_form_list& InferenceRule::getRequiredForms()
+{ return required_forms; }
+
+//A required form that isn't a subproof mixes in 0 for its assumption, so it
+//can't be confused with one that is.
+tree_hash InferenceRule::fingerprint()
+{
+  tree_hash hash = StatementTree::mixHash(Justification::fingerprint(),
+    result_form->structureHash());
+  for(required_form_list::iterator itr = required_forms.begin(); itr != required_forms.end(); itr++)
+  {
+    required_form* form = *itr;
+    hash = StatementTree::mixHash(hash, form->statementForm->structureHash());
+    hash = StatementTree::mixHash(hash, (form->subproofAssumptionForm == NULL)?0:
+      form->subproofAssumptionForm->structureHash());
+  }
+  return hash;
 }
 
 //Returns true if and only if the given consequent & antecedents can be matched
@@ -51,103 +113,121 @@ bool InferenceRule::isJustified(StatementTree& con, antecedent_list& ant)
     if(*itr == NULL) return false;
   
   //Checking that the consequent is of the correct form.
-  bind_map binds;
-  if(!match(&con, &result_form, binds))
-  {
-    removeBoundForms(binds);
+  BindTable binds;
+  if(!match(&con, result_form, binds))
     return false;
-  }
   
-  //Initializing the map of antecedent usage, for determining if there are any
-  //unused antecedents.
-  statement_usage_map ant_usage;
+  //Group the distinct antecedents by the root of their sentence, or of their
+  //assumption for a subproof, so each form only looks at those it could match.
+  antecedent_search search;
+  vector<int> basic_by_root[ROOT_CODE_COUNT], subproofs_by_root[ROOT_CODE_COUNT];
+  vector<int> all_basic, all_subproofs;
   for(antecedent_list::iterator itr = ant.begin(); itr != ant.end(); itr++)
-    ant_usage[*itr] = 0;
-  
-  //Check for matching forms
-  bool result = findAntecedentsForForms(required_forms.begin(), ant, binds,
-    ant_usage);
-  removeBoundForms(binds); //Cleanup
-  return result;
+  {
+    if(std::find(search.antecedents.begin(), search.antecedents.end(), *itr) != search.antecedents.end())
+      continue; //Listed more than once
+    int index = search.antecedents.size();
+    search.antecedents.push_back(*itr);
+    StatementTree* statement = (*itr)->getStatementData();
+    StatementTree* assumption = (*itr)->getAssumption();
+    if(statement != NULL)
+    {
+      basic_by_root[rootCode(statement)].push_back(index);
+      all_basic.push_back(index);
+    }
+    if(assumption != NULL)
+    {
+      subproofs_by_root[rootCode(assumption)].push_back(index);
+      all_subproofs.push_back(index);
+    }
+  }
+
+  //A form whose root is a sentence variable could match any antecedent of its
+  //kind. If some form has no candidates at all, the rule can't apply.
+  for(required_form_list::iterator itr = required_forms.begin(); itr != required_forms.end(); itr++)
+  {
+    form_candidates candidates;
+    candidates.form = *itr;
+    bool is_subproof = (*itr)->subproofAssumptionForm != NULL;
+    StatementTree* root_form = is_subproof ? (*itr)->subproofAssumptionForm : (*itr)->statementForm;
+    if(root_form->nodeType() == StatementTree::ATOM)
+      candidates.antecedents = is_subproof ? all_subproofs : all_basic;
+    else
+      candidates.antecedents = (is_subproof ? subproofs_by_root : basic_by_root)[rootCode(root_form)];
+    if(candidates.antecedents.empty()) return false;
+    search.order.push_back(candidates);
+  }
+  std::stable_sort(search.order.begin(), search.order.end(), fewerCandidates);
+
+  search.used.assign((search.antecedents.size() + 63) / 64, 0);
+  search.unused_count = search.antecedents.size();
+  return findAntecedentsForForms(search, 0, binds);
 }
 
-//Attempts to match the given required antecedent form to some actual antecedent,
-//contingent on previously bound sentence variables. On a successful match,
-//continues to the next required form. If all required forms have a corresponding
-//antecedent, returns true iff there are no unused antecedents.
-bool InferenceRule::findAntecedentsForForms(required_form_list::iterator form,
-  antecedent_list& ant, bind_map& binds, statement_usage_map& ant_usage)
+//Attempts to match the required antecedent form at the given position to some
+//actual antecedent, contingent on previously bound sentence variables. On a
+//successful match, continues to the next required form. If all required forms
+//have a corresponding antecedent, returns true iff there are no unused
+//antecedents.
+bool InferenceRule::findAntecedentsForForms(antecedent_search& search, size_t position,
+  BindTable& binds)
 {
-  //At the end, check if any antecedents were unused.
-  if(form == required_forms.end()) return checkAntecedentRelevance(ant_usage);
+  //Each remaining form can use up at most one more antecedent.
+  if(search.unused_count > (int)(search.order.size() - position)) return false;
+  if(position == search.order.size()) return true;
   
-  if((*form)->subproofAssumptionForm==NULL)
-    return findAntecedentsForBasicForm(form, ant, binds, ant_usage);
+  if(search.order[position].form->subproofAssumptionForm == NULL)
+    return findAntecedentsForBasicForm(search, position, binds);
   else
-    return findAntecedentsForSubProof(form, ant, binds, ant_usage);
+    return findAntecedentsForSubProof(search, position, binds);
 }
 
 //Helper function for findAntecedentsForForms for when the form is not a
 //subproof form.
-bool InferenceRule::findAntecedentsForBasicForm(required_form_list::iterator form,
-  antecedent_list& ant, bind_map& binds, statement_usage_map& ant_usage)
+bool InferenceRule::findAntecedentsForBasicForm(antecedent_search& search, size_t position,
+  BindTable& binds)
 {
-  //The copy of the variable binding map is so new bindings can be removed if
-  //a branch doesn't work out.
-  bind_map temp_binds(binds);
-  required_form_list::iterator next_form = form;
-  next_form++;
+  //New bindings are undone back to this mark if a branch doesn't work out.
+  int binds_mark = binds.mark();
+  const form_candidates& candidates = search.order[position];
   
-  //Try each antecedent for this form.
-  for(antecedent_list::iterator itr = ant.begin(); itr != ant.end(); itr++)
+  //Try each candidate antecedent for this form.
+  for(vector<int>::const_iterator itr = candidates.antecedents.begin(); itr != candidates.antecedents.end(); itr++)
   {
-    if(*itr == NULL) return false;
-    StatementTree* ant_data = (*itr)->getStatementData();
-    if(ant_data == NULL) continue; //Statement was a subproof
-    
-    //Attempt to match
-    bool result = match(ant_data, (*form)->statementForm, temp_binds);
-    if(result)
-    {
-      //If successful, move on to the next required form.
-      ant_usage[*itr]++;
-      result = findAntecedentsForForms(next_form, ant, temp_binds, ant_usage);
-      ant_usage[*itr]--;
-    }
+    StatementTree* ant_data = search.antecedents[*itr]->getStatementData();
     
-    removeNewlyBoundForms(temp_binds, binds);
+    //If the match works, move on to the next required form.
+    bool result = match(ant_data, candidates.form->statementForm, binds) &&
+      useAntecedent(search, position, *itr, binds);
+    binds.undoTo(binds_mark);
     if(result) return true;
   }
   return false;
 }
 
 //Helper function for findAntecedentsForForms for a subproof form.
-bool InferenceRule::findAntecedentsForSubProof(required_form_list::iterator form,
-  antecedent_list& ant, bind_map& binds, statement_usage_map& ant_usage)
+bool InferenceRule::findAntecedentsForSubProof(antecedent_search& search, size_t position,
+  BindTable& binds)
 {
-  //The copy of the variable binding map is so new bindings can be removed if
-  //a branch doesn't work out.
-  bind_map statement_binds(binds);
-  required_form_list::iterator next_form = form;
-  next_form++;
+  //New bindings are undone back to this mark if a branch doesn't work out.
+  int binds_mark = binds.mark();
+  const form_candidates& candidates = search.order[position];
   
-  for(antecedent_list::iterator itr = ant.begin(); itr != ant.end(); itr++)
+  for(vector<int>::const_iterator itr = candidates.antecedents.begin(); itr != candidates.antecedents.end(); itr++)
   {
-    //Iterate over antecedents
-    if(*itr == NULL) return false;
-    StatementTree* assumption = (*itr)->getAssumption();
-    statement_set* contents = (*itr)->getSubproofContents();
-    if(assumption == NULL) continue; //Statement wasn't a subproof
+    //Iterate over candidate subproofs
+    ProofStatement* subproof = search.antecedents[*itr];
+    statement_set* contents = subproof->getSubproofContents();
     
     //Check if the assumption matches
-    bool result = match(assumption, (*form)->subproofAssumptionForm, statement_binds);
+    bool result = match(subproof->getAssumption(), candidates.form->subproofAssumptionForm, binds);
     if(!result)
     {
-      removeNewlyBoundForms(statement_binds, binds);
+      binds.undoTo(binds_mark);
       continue;
     }
     
-    bind_map substatement_binds(statement_binds);
+    int assumption_mark = binds.mark();
     statement_set::iterator sub_itr = contents->begin();
     result = false;
     for(; sub_itr != contents->end(); sub_itr++)
@@ -156,56 +236,59 @@ bool InferenceRule::findAntecedentsForSubProof(required_form_list::iterator form
       StatementTree* sub_statement = (*sub_itr)->getStatementData();
       if(sub_statement == NULL) continue; //Child is a sub-subproof
       
-      result = match(sub_statement, (*form)->statementForm, substatement_binds);
-      if(result)
-      {
-        //Required subproof line found, continue to the next form required 
-        //by the rule.
-        ant_usage[*itr]++;
-        result = findAntecedentsForForms(next_form, ant, substatement_binds,
-          ant_usage);
-        ant_usage[*itr]--;
-      }
-      
-      //If all remaining required forms work, the match worked.
-      removeNewlyBoundForms(substatement_binds, statement_binds);
+      //Required subproof line found, continue to the next form required 
+      //by the rule. If all remaining required forms work, the match worked.
+      result = match(sub_statement, candidates.form->statementForm, binds) &&
+        useAntecedent(search, position, *itr, binds);
+      binds.undoTo(assumption_mark);
       if(result) break;
     }
     
-    removeNewlyBoundForms(statement_binds, binds);
+    binds.undoTo(binds_mark);
     if(result) return true;
   }
   return false;
 }
 
-//Returns true if all stored antecedents have been used at least once, false
-//otherwise.
-bool InferenceRule::checkAntecedentRelevance(statement_usage_map& ant_usage)
+//Sets the antecedent's bit while the remaining forms are matched, unless an
+//earlier form already set it.
+bool InferenceRule::useAntecedent(antecedent_search& search, size_t position, int antecedent,
+  BindTable& binds)
 {
-  statement_usage_map::iterator itr = ant_usage.begin();
-  for(; itr != ant_usage.end(); itr++)
-    if(itr->second <= 0)
-      return false;
-  return true;
+  unsigned long long bit = 1ULL << (antecedent % 64);
+  bool was_used = (search.used[antecedent / 64] & bit) != 0;
+  if(!was_used)
+  {
+    search.used[antecedent / 64] |= bit;
+    search.unused_count--;
+  }
+  bool result = findAntecedentsForForms(search, position + 1, binds);
+  if(!was_used)
+  {
+    search.used[antecedent / 64] &= ~bit;
+    search.unused_count++;
+  }
+  return result;
 }
 
-bool InferenceRule::match(StatementTree* target, StatementTree* form, bind_map& binds)
+bool InferenceRule::match(StatementTree* target, StatementTree* form, BindTable& binds)
 {
   if(form->nodeType() == StatementTree::ATOM)
   {
     //The form is a sentence variable; if it's unbound, bind & return. Else return whether
-    //the target is equivalent to the bound sentence.
-    StatementTree* sentence = new StatementTree(*target, form->isAffirmed());
-    pair<bind_map::iterator, bool> retval = 
-      binds.insert(pair<char, StatementTree*>(form->atomName()[0], sentence));
-    
-    if(retval.second) return true;
-    else
+    //the target is the same as the bound sentence. A negated variable binds the target
+    //with its root negation inverted.
+    bool flipped = !form->isAffirmed();
+    bound_form* bound = binds.find(form->atomName()[0]);
+    if(bound == NULL)
     {
-      bool result = sentence->equals(*(retval.first->second)); //Here's where it differs from Equiv
-      delete sentence;
-      return result;
+      binds.bind(form->atomName()[0], target, flipped);
+      return true;
     }
+    
+    //Here's where it differs from Equiv
+    if(flipped == bound->flipped) return target->equals(*bound->tree);
+    return target->equalsNegated(*bound->tree);
   }
   
   //The form is not a sentence variable, return true if target matches form's type &
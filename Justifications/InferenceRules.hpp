@@ -8,6 +8,8 @@ class InferenceRule;
 #include "ProofStatement.hpp"
 #include <utility>
 #include <list>
+#include <vector>
+#include <cstddef>
 
 /// <summary>
 /// Stores the format which must be matched by one of a line's antecedents for
@@ -24,6 +26,32 @@ struct required_form
 };
 typedef std::list<required_form*> required_form_list;
 
+/// <summary>
+/// A required form, and the antecedents it could possibly be matched with
+/// when checking one line: those whose root node (or whose assumption's root
+/// node, for a subproof form) has the type and negation the form requires.
+/// Antecedents are given by index in antecedent_search.antecedents.
+/// </summary>
+struct form_candidates
+{
+  required_form* form;
+  std::vector<int> antecedents;
+};
+
+/// <summary>
+/// State of matching a line's antecedents with the required forms of an
+/// inference rule. Forms are matched in order of how few candidates they
+/// have, so a form that can only go one way is settled before branching on
+/// the others. Which antecedents have been used is kept as a bit mask.
+/// </summary>
+struct antecedent_search
+{
+  std::vector<ProofStatement*> antecedents; //Each distinct listed antecedent
+  std::vector<form_candidates> order;
+  std::vector<unsigned long long> used; //Bit i set when antecedent i is matched
+  int unused_count;
+};
+
 //Checks justification based on an inference rule
 
 /// <summary>
@@ -41,7 +69,7 @@ typedef std::list<required_form*> required_form_list;
 class InferenceRule : public Justification
 {
   private:
-  StatementTree result_form;
+  StatementTree* result_form;
   required_form_list required_forms;
   
   /// <summary>
@@ -73,130 +101,109 @@ class InferenceRule : public Justification
   ///   bindings which are required to make that match.
   /// </param>
   /// <returns>True if a match can be made, false otherwise</returns>
-  bool match(StatementTree* target, StatementTree* form, bind_map& binds);
+  bool match(StatementTree* target, StatementTree* form, BindTable& binds);
   
   /// <summary>
-  /// Attempts to match a required form and all subsequent required forms in
-  /// the list with actual antecedents, while maintaining any existing bindings
-  /// between sentence variables and syntax trees. Called on required_forms.begin()
-  /// to match all required forms. When the end of the list is reached, checks
-  /// that there are no antecedents that aren't matched to any required forms.
+  /// Attempts to match the required forms from a position in the search order
+  /// onwards with antecedents, while maintaining any existing bindings
+  /// between sentence variables and syntax trees. Called with position 0 to
+  /// match all required forms. When every form has been matched, checks that
+  /// there are no antecedents that aren't matched to any required form.
   /// 
-  /// This will match the required form with the first antecedent it can, but if
-  /// that doesn't allow all the subsequent forms to match then it will
-  /// backtrack and match with a later antecedent.
+  /// This will match the required form with the first candidate it can, but
+  /// if that doesn't allow all the subsequent forms to match then it will
+  /// backtrack and match with a later candidate.
   /// </summary>
-  /// <param name="form">
-  ///   Iterator into the list of required forms. Attempts to match that form,
-  ///   then findAntecedentsForForms will be recursively called for the next
-  ///   entry. If this is required_forms.end(), the function will just check
-  ///   that statement_usage_map records a match for all antecedents.
-  /// </param>
-  /// <param name="ant">
-  ///   The list of antecedents to match required forms with.
+  /// <param name="search">
+  ///   The forms in the order to match them, their candidate antecedents, and
+  ///   which antecedents have been matched so far.
   /// </param>
+  /// <param name="position">Position in search.order of the form to match</param>
   /// <param name="binds">
   ///   Stores bindings between sentence variables and syntax trees. For the
   ///   initial call this should the bindings to match the consequent form
   ///   with the proof line to be justified. On recursive calls, will also
   ///   contain any additional bindings for the previously matched forms.
   /// </param>
-  /// <param name="ant_usage">
-  ///   Maintains a count of how many required forms are matched to each
-  ///   antecedent. If matching all required forms is successful, then this
-  ///   will return true if this count is at least one for all antecedents.
-  /// </param>
   /// <returns>
   ///   True if all required forms can be concurrently matched with antecedents
   ///   and all antecedents are matched with at least one required form.
   /// </returns>
-  bool findAntecedentsForForms(required_form_list::iterator form, antecedent_list& ant,
-    bind_map& binds, statement_usage_map& ant_usage);
+  bool findAntecedentsForForms(antecedent_search& search, size_t position, BindTable& binds);
 
   /// <summary>
   /// Helper function for findAntecedentsForForms to match a required form
-  /// which is not a subproof with an antecedent. Looks through antecedent_list
-  /// for one which can match, then calls findAntecedentsForForms for the
-  /// successor to the form iterator. If that recursive call succeeds, this has
-  /// succeeded. If not, keep looking through the antecedents for another that
-  /// matches. If none of them work out, matching has failed.
+  /// which is not a subproof with one of its candidate antecedents. For each
+  /// one that matches, calls findAntecedentsForForms for the next position.
+  /// If that recursive call succeeds, this has succeeded. If none of them
+  /// work out, matching has failed.
   /// </summary>
-  /// <param name="form">
-  ///   Iterator into the list of required forms, to the one we are trying to
-  ///   match. Should not be the end iterator, and subproofAssumptionForm at
-  ///   this value should be NULL.
-  /// </param>
-  /// <param name="ant">
-  ///   The list of antecedents to match required forms with.
+  /// <param name="search">State of the search</param>
+  /// <param name="position">
+  ///   Position in search.order of the form to match, whose
+  ///   subproofAssumptionForm should be NULL.
   /// </param>
   /// <param name="binds">
   ///   Stores bindings between sentence variables and syntax trees. Contains
   ///   the bindings to match the consequent and any previously matched
-  ///   required forms. If matching is successful, will be updated with any
-  ///   additional bindings for this and subsequent matchings.
-  /// </param>
-  /// <param name="ant_usage">
-  ///   Maintains a count of how many required forms are matched to each
-  ///   antecedent.
+  ///   required forms. Bindings made here are undone before returning.
   /// </param>
   /// <returns>
   ///   True if this and each subsequent form can be matched with antecedents,
   ///   and all antecedents are used.
   /// </returns>
-  bool findAntecedentsForBasicForm(required_form_list::iterator form, antecedent_list& ant,
-    bind_map& binds, statement_usage_map& ant_usage);
+  bool findAntecedentsForBasicForm(antecedent_search& search, size_t position, BindTable& binds);
 
   /// <summary>
   /// Helper function for findAntecedentsForForms to match a required form
-  /// which is a subproof with an antecedent. Looks through antecedent_list
-  /// for one which:
-  ///   -Is a subproof
-  ///   -The subproof's assumption can match the required assumption form
-  ///   -The subproof contains a child line which:
+  /// which is a subproof with one of its candidate antecedents, which must:
+  ///   -Be a subproof
+  ///   -Have an assumption which can match the required assumption form
+  ///   -Contain a child line which:
   ///     -Is not a subproof
   ///     -Can match with the required statement form.
   /// 
-  /// When such a subproof is found, calls findAntecedentsForForms for the
-  /// successor to the form iterator. If that recursive call succeeds, this has
-  /// succeeded. If not, keep looking through the antecedents for another that
-  /// matches. If none of them work out, matching has failed.
+  /// For each such subproof and line, calls findAntecedentsForForms for the
+  /// next position. If that recursive call succeeds, this has succeeded. If
+  /// none of them work out, matching has failed.
   /// </summary>
-  /// <param name="form">
-  ///   Iterator into the list of required forms, to the one we are trying to
-  ///   match. Should not be the end iterator, and subproofAssumptionForm at
-  ///   this value should NOT be NULL.
-  /// </param>
-  /// <param name="ant">
-  ///   The list of antecedents to match required forms with.
+  /// <param name="search">State of the search</param>
+  /// <param name="position">
+  ///   Position in search.order of the form to match, whose
+  ///   subproofAssumptionForm should NOT be NULL.
   /// </param>
   /// <param name="binds">
   ///   Stores bindings between sentence variables and syntax trees. Contains
   ///   the bindings to match the consequent and any previously matched
-  ///   required forms. If matching is successful, will be updated with any
-  ///   additional bindings for this and subsequent matchings.
-  /// </param>
-  /// <param name="ant_usage">
-  ///   Maintains a count of how many required forms are matched to each
-  ///   antecedent.
+  ///   required forms. Bindings made here are undone before returning.
   /// </param>
   /// <returns>
   ///   True if this and each subsequent form can be matched with antecedents,
   ///   and all antecedents are used.
   /// </returns>
-  bool findAntecedentsForSubProof(required_form_list::iterator form, antecedent_list& ant,
-    bind_map& binds, statement_usage_map& ant_usage);
-  
+  bool findAntecedentsForSubProof(antecedent_search& search, size_t position, BindTable& binds);
+
   /// <summary>
-  /// Helper function for findAntecedentsForForms, called once all required
-  /// forms have been matched with antecedents. Checks that each listed
-  /// antecedent has been matched with at least one required form.
+  /// Helper for the findAntecedentsFor functions. Marks an antecedent as
+  /// matched to a form, then continues with the next position.
   /// </summary>
-  /// <param name="ant_usage">
-  ///   Maintains a count of how many required forms are matched to each
-  ///   antecedent.
-  /// </param>
-  /// <returns>True if all antecedents are used</returns>
-  bool checkAntecedentRelevance(statement_usage_map& ant_usage);
+  /// <param name="search">State of the search</param>
+  /// <param name="position">Position in search.order of the form just matched</param>
+  /// <param name="antecedent">Index of the antecedent it was matched to</param>
+  /// <param name="binds">Bindings, including those for the match just made</param>
+  /// <returns>True if the remaining forms could be matched</returns>
+  bool useAntecedent(antecedent_search& search, size_t position, int antecedent,
+    BindTable& binds);
+
+  protected:
+  /// <summary>
+  /// An inference rule is sound if its required forms entail its consequent
+  /// form, taking each sentence variable as an atom, since a line it
+  /// justifies is the same substitution into all of them. Rules with subproof
+  /// forms aren't checked.
+  /// </summary>
+  /// <returns>True if the forms were checked to entail the consequent</returns>
+  bool checkSoundness();
   
   public:
   /// <summary>
@@ -206,7 +213,17 @@ class InferenceRule : public Justification
   /// <param name="result">The form the consequent must take</param>
   /// <param name="name">The name of the inference rule</param>
   InferenceRule(const char* result, const char* name) : Justification(name),
-    result_form(result)
+    result_form(StatementTree::create(result))
+  {}
+
+  /// <summary>
+  /// Constructs the inference rule from a consequent form that has already
+  /// been parsed. The rule takes its own reference to the tree.
+  /// </summary>
+  /// <param name="result">The form the consequent must take</param>
+  /// <param name="name">The name of the inference rule</param>
+  InferenceRule(StatementTree& result, const char* name) : Justification(name),
+    result_form(StatementTree::create(result))
   {}
   
   virtual ~InferenceRule();
@@ -226,6 +243,26 @@ class InferenceRule : public Justification
   ///   take. Will be parsed into a syntax tree.
   /// </param>
   void addRequiredForm(const char* statement, const char* assumption=NULL);
+
+  /// <summary>
+  /// Adds an antecedent form that has already been parsed, as for the other
+  /// addRequiredForm. The rule takes its own references to the trees.
+  /// </summary>
+  /// <param name="statement">Form of the required antecedent sentence</param>
+  /// <param name="assumption">Form of the subproof's assumption, or NULL</param>
+  void addRequiredForm(StatementTree* statement, StatementTree* assumption);
+
+  /// <summary>
+  /// The form the consequent must take.
+  /// </summary>
+  /// <returns>Consequent form</returns>
+  StatementTree* getResultForm();
+
+  /// <summary>
+  /// The required antecedent forms, in the order they were added.
+  /// </summary>
+  /// <returns>Required forms</returns>
+  const required_form_list& getRequiredForms();
   
   /// <summary>
   /// A proof line is justified by this rule if that line matches the rule's
@@ -246,6 +283,12 @@ class InferenceRule : public Justification
   ///   rule.
   /// </returns>
   bool isJustified(StatementTree& con, antecedent_list& ant);
+
+  /// <summary>
+  /// Hash of the rule's name, consequent form, and required forms in order.
+  /// </summary>
+  /// <returns>Hash of the rule</returns>
+  tree_hash fingerprint();
 };
 
 #endif
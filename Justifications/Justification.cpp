@@ -1,8 +1,13 @@
 #include "Justification.hpp"
+#include <atomic>
 #include <cstring>
 
+//Ids given out so far. Starts at one so no rule has id zero.
+static std::atomic<unsigned long long> rule_ids(1);
+
 //Stores the name of this rule.
-Justification::Justification(const char* name)
+Justification::Justification(const char* name) : rule_id(rule_ids++),
+  soundness(SOUNDNESS_UNKNOWN)
 {
   if(name == NULL)
   {
@@ -26,27 +31,74 @@ Justification::~Justification()
 char* Justification::getName()
 { return rule_name; }
 
-//Deallocates the values in the given map & clears the map.
-void Justification::removeBoundForms(bind_map& binds)
+unsigned long long Justification::getId()
+{ return rule_id; }
+
+//Hash of the name. Rules with forms mix those in.
+tree_hash Justification::fingerprint()
 {
-  for(bind_map::iterator itr = binds.begin(); itr != binds.end(); itr++)
-    delete itr->second;
-  binds.clear();
+  if(rule_name == NULL) return 0;
+  return AtomTable::hashName(rule_name, strlen(rule_name));
 }
 
-//Deallocates values & removes entries in new_binds for which the key value does
-//not appear in old_binds.
-void Justification::removeNewlyBoundForms(bind_map& new_binds, bind_map& old_binds)
+//Threads that ask at the same time may both work it out, which gives the
+//same answer.
+bool Justification::isSound()
 {
-  bind_map::iterator next_itr = new_binds.begin();
-  while (next_itr != new_binds.end())
+  int known = soundness.load();
+  if(known == SOUNDNESS_UNKNOWN)
   {
-	  bind_map::iterator test_itr = next_itr++;
-	  if (old_binds.find(test_itr->first) == old_binds.end())
-	  {
-		  delete test_itr->second;
-		  new_binds.erase(test_itr);
-	  }
+    known = checkSoundness() ? SOUND : UNSOUND;
+    soundness.store(known);
   }
+  return known == SOUND;
+}
+
+bool Justification::checkSoundness()
+{ return false; }
+
+void Justification::soundnessChanged()
+{ soundness.store(SOUNDNESS_UNKNOWN); }
+
+BindTable::BindTable() : binding_count(0)
+{
+  //This space left intentionally blank
+}
+
+//Linear search; there are only ever a few variables bound.
+bound_form* BindTable::find(char variable)
+{
+  for(int i = 0; i < binding_count && i < BIND_TABLE_SIZE; i++)
+    if(bindings[i].variable == variable)
+      return &bindings[i];
+  for(unsigned int i = 0; i < more_bindings.size(); i++)
+    if(more_bindings[i].variable == variable)
+      return &more_bindings[i];
+  return NULL;
+}
+
+void BindTable::bind(char variable, StatementTree* tree, bool flipped)
+{
+  bound_form binding = { variable, tree, flipped };
+  if(binding_count < BIND_TABLE_SIZE)
+    bindings[binding_count] = binding;
+  else
+    more_bindings.push_back(binding);
+  binding_count++;
+}
+
+int BindTable::mark()
+{ return binding_count; }
+
+//Bindings are in the order they were made, so this just drops the newer ones.
+void BindTable::undoTo(int binding_mark)
+{
+  binding_count = binding_mark;
+  if(binding_mark < BIND_TABLE_SIZE)
+    more_bindings.clear();
+  else
+    more_bindings.resize(binding_mark - BIND_TABLE_SIZE);
 }
 
+void BindTable::clear()
+{ undoTo(0); }
@@ -1,29 +1,92 @@
 #ifndef __JUSTIFICATION_H_
 #define __JUSTIFICATION_H_
 
+#include <atomic>
 #include <map>
 #include <list>
 #include <cstring>
+#include <vector>
 
 class Justification;
 
 #include "StatementTree.hpp"
 #include "ProofStatement.hpp"
 
+#define BIND_TABLE_SIZE 32
+
+/// <summary>
+/// The statement tree bound to a sentence variable. This is a view of a
+/// subtree of some proof line rather than a copy: the bound sentence is the
+/// tree with the negation flag at its root inverted if flipped is set. It
+/// doesn't hold a reference to the tree, as the proof lines being checked
+/// outlive the check.
+/// </summary>
+struct bound_form
+{
+  char variable;
+  StatementTree* tree;
+  bool flipped;
+};
+
 /// <summary>
 /// When checking whether a justification rule is appropriately applied, the
 /// atomic propositions in the forms specified in the rule must correspond
 /// with subtrees of the proof lines it's being applied to, and the same
 /// proposition must correspond with an equivalent tree each time it appears.
-/// This map stores that correspondance.
+/// This table stores that correspondance.
+///
+/// Rules only use a handful of sentence variables, so bindings are kept in a
+/// small fixed array in the order they were made. That order doubles as the
+/// trail for backtracking: when a branch of the search doesn't work out, the
+/// bindings made since some earlier mark are dropped off the end. Nothing is
+/// allocated when binding, comparing, or backtracking, unless a rule (e.g. a
+/// large lemma) has more than BIND_TABLE_SIZE variables, in which case the
+/// rest go in a vector after the array.
 /// </summary>
-typedef std::map<char, StatementTree*> bind_map;
+class BindTable
+{
+  private:
+  bound_form bindings[BIND_TABLE_SIZE];
+  std::vector<bound_form> more_bindings; //Any past the first BIND_TABLE_SIZE
+  int binding_count;
 
-/// <summary>
-/// Used to check whether any of the listed antecedents are unused when
-/// checking whether a rule can be applied.
-/// </summary>
-typedef std::map<ProofStatement*, int> statement_usage_map;
+  public:
+  BindTable();
+
+  /// <summary>
+  /// Gets the sentence bound to a variable.
+  /// </summary>
+  /// <param name="variable">Sentence variable from a rule form</param>
+  /// <returns>The bound view, or null if the variable is unbound</returns>
+  bound_form* find(char variable);
+
+  /// <summary>
+  /// Binds an unbound sentence variable.
+  /// </summary>
+  /// <param name="variable">Sentence variable from a rule form</param>
+  /// <param name="tree">Subtree of a proof line</param>
+  /// <param name="flipped">Whether the negation at the root is inverted</param>
+  void bind(char variable, StatementTree* tree, bool flipped);
+
+  /// <summary>
+  /// Marks the current state of the table, to be returned to with undoTo.
+  /// </summary>
+  /// <returns>Number of bindings</returns>
+  int mark();
+
+  /// <summary>
+  /// Unbinds every variable bound since mark was called. This is used when a
+  /// branch of searching for correspondance between proof lines and rule
+  /// forms doesn't work out, and we need to backtrack and try a different one.
+  /// </summary>
+  /// <param name="binding_mark">Value returned by mark</param>
+  void undoTo(int binding_mark);
+
+  /// <summary>
+  /// Unbinds all variables.
+  /// </summary>
+  void clear();
+};
 
 /// <summary>
 /// Represents the reason why a logical statement can be considered a valid
@@ -48,6 +111,24 @@ class Justification
 {
   private:
   char* rule_name;
+  unsigned long long rule_id;
+  std::atomic<int> soundness; //SOUNDNESS_UNKNOWN until isSound works it out
+  const static int SOUNDNESS_UNKNOWN = 0, SOUND = 1, UNSOUND = 2;
+
+  protected:
+  /// <summary>
+  /// Works out whether the rule is sound, for isSound. Only called when
+  /// that's needed, as it can take time exponential in the number of
+  /// sentence variables in the rule's forms. The base class returns false.
+  /// </summary>
+  /// <returns>True if the rule was checked to be sound</returns>
+  virtual bool checkSoundness();
+
+  /// <summary>
+  /// Forgets whether the rule is sound, for subclasses to call when their
+  /// forms change.
+  /// </summary>
+  void soundnessChanged();
   
   public:
   /// <summary>
@@ -60,6 +141,14 @@ class Justification
   Justification(const char* name);
   virtual ~Justification();
   char* getName();
+
+  /// <summary>
+  /// Number that no other rule made in this run has, even after this one is
+  /// deleted. Unlike the rule's address, it can't be reused by a later rule
+  /// (e.g. a lemma from another proof).
+  /// </summary>
+  /// <returns>Id of the rule</returns>
+  unsigned long long getId();
   
   /// <summary>
   /// Checks whether a statement is a logical consequence of certain antecedents
@@ -77,27 +166,28 @@ class Justification
   /// </returns>
   virtual bool isJustified(StatementTree& consequent, 
      antecedent_list& antecedents) = 0;
-  
-  protected:
 
   /// <summary>
-  /// Removes all entries from a bind map and frees their resources.
+  /// Hash of what this rule accepts, used to key stored results of checking
+  /// proof lines (see VerificationCache). Built from the rule's name and
+  /// forms rather than where the rule was read from, so it only changes when
+  /// the rule itself does. The base class hashes the name; subclasses mix in
+  /// their forms.
   /// </summary>
-  /// <param name="binds">Bind map to clear</param>
-  void removeBoundForms(bind_map& binds);
+  /// <returns>Hash of the rule</returns>
+  virtual tree_hash fingerprint();
 
   /// <summary>
-  /// Removes and frees all entries in one bind map which do not appear in
-  /// another. This is used when a branch of searching for correspondance
-  /// between proof lines and rule forms doesn't work out, and we need to
-  /// backtrack and try a different one. Doesn't check whether the bound trees
-  /// are equivalent, just whether there's an entry for a given proposition.
+  /// Whether the rule only ever justifies a line that its antecedents entail,
+  /// as worked out from the rule's forms. For such a rule, a line whose
+  /// antecedents don't entail it can be rejected without matching any forms
+  /// (see ProofStatement::setSemanticPrefilter). Rules are only sound if
+  /// that's been checked, by checkSoundness, which is done the first time
+  /// this is called rather than when the rule is made. May be called from
+  /// any thread.
   /// </summary>
-  /// <param name="new_binds">Map to remove forms from</param>
-  /// <param name="old_binds">
-  ///   Any form that's not in this map will be removed.
-  /// </param>
-  void removeNewlyBoundForms(bind_map& new_binds, bind_map& old_binds);
+  /// <returns>True if the rule is known to be sound</returns>
+  bool isSound();
 };
 
 //TODO: This could be a singleton maybe?
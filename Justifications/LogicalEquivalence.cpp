@@ -0,0 +1,18 @@
+#include "LogicalEquivalence.hpp"
+
+//The antecedent is built first, so its atoms are nearest the root.
+bool LogicalEquivalence::isJustified(StatementTree& consequent,
+  antecedent_list& antecedents)
+{
+  if(antecedents.size() != 1) return false;
+  StatementTree* antecedent = antecedents.front()->getStatementData();
+  if(antecedent == NULL) return false;
+
+  DecisionDiagram diagram;
+  int antecedent_node = diagram.build(antecedent);
+  if(antecedent_node == DECISION_DIAGRAM_OVERFLOW) return false;
+  return diagram.build(&consequent) == antecedent_node;
+}
+
+tree_hash LogicalEquivalence::fingerprint()
+{ return StatementTree::mixHash(Justification::fingerprint(), DECISION_DIAGRAM_NODE_LIMIT); }
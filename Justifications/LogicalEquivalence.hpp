@@ -0,0 +1,47 @@
+#ifndef __LOGICAL_EQUIVALENCE_H_
+#define __LOGICAL_EQUIVALENCE_H_
+
+#include "Justification.hpp"
+#include "DecisionDiagram.hpp"
+
+/// <summary>
+/// Justification by the meaning of a sentence rather than by a rule of
+/// deduction: a line is justified if it's logically equivalent to its one
+/// antecedent, however many steps that would take with equivalence rules.
+///
+/// Both sentences are built into a DecisionDiagram, where equivalent
+/// sentences are the same node. Unlike a truth table this doesn't depend on
+/// the number of atoms as such, only on the size of the diagrams; if they
+/// need more than DECISION_DIAGRAM_NODE_LIMIT nodes, the line isn't
+/// justified. The antecedent can't be a subproof.
+/// </summary>
+class LogicalEquivalence : public Justification
+{
+  public:
+  LogicalEquivalence(const char* name) : Justification(name)
+  {}
+
+  /// <summary>
+  /// Checks whether the consequent and the antecedent build the same node.
+  /// </summary>
+  /// <param name="consequent">
+  ///   The proposed consequent of applying the rule
+  /// </param>
+  /// <param name="antecedents">
+  ///   The antecedent it must be equivalent to. If more than one is listed,
+  ///   the justification fails.
+  /// </param>
+  /// <returns>
+  ///   True if the consequent and antecedent are logically equivalent, and
+  ///   their diagrams weren't too big to build.
+  /// </returns>
+  bool isJustified(StatementTree& consequent, antecedent_list& antecedents);
+
+  /// <summary>
+  /// Hash of the rule's name and the limit on nodes.
+  /// </summary>
+  /// <returns>Hash of the rule</returns>
+  tree_hash fingerprint();
+};
+
+#endif
@@ -0,0 +1,33 @@
+#include "TautologicalConsequence.hpp"
+#include <vector>
+
+using std::vector;
+
+bool TautologicalConsequence::isJustified(StatementTree& consequent,
+  antecedent_list& antecedents)
+{
+  TruthTable table;
+  vector<int> premises;
+  for(antecedent_list::iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+  {
+    if(*itr == NULL || (*itr)->getStatementData() == NULL) return false;
+    premises.push_back(table.addSentence((*itr)->getStatementData()));
+  }
+  int conclusion = table.addSentence(&consequent);
+  if(table.atomCount() <= TRUTH_TABLE_MAX_ATOMS)
+    return table.entails(premises, conclusion);
+
+  //Too many atoms for the table, so the SAT solver is asked instead
+  SatEncoder encoder;
+  premises.clear();
+  for(antecedent_list::iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+    premises.push_back(encoder.addSentence((*itr)->getStatementData()));
+  conclusion = encoder.addSentence(&consequent);
+  return encoder.entails(premises, conclusion) == SatEncoder::ENTAILED;
+}
+
+tree_hash TautologicalConsequence::fingerprint()
+{
+  tree_hash hash = StatementTree::mixHash(Justification::fingerprint(), TRUTH_TABLE_MAX_ATOMS);
+  return StatementTree::mixHash(hash, SAT_CONFLICT_LIMIT);
+}
@@ -0,0 +1,52 @@
+#ifndef __TAUTOLOGICAL_CONSEQUENCE_H_
+#define __TAUTOLOGICAL_CONSEQUENCE_H_
+
+#include "Justification.hpp"
+#include "TruthTable.hpp"
+#include "SatEncoder.hpp"
+
+/// <summary>
+/// Justification by truth table rather than by a rule of deduction: a line
+/// is justified if it's true under every assignment of truth values that
+/// makes all its antecedents true (it's a tautological consequence of them).
+/// With no antecedents, the line must be a tautology.
+///
+/// Up to TRUTH_TABLE_MAX_ATOMS distinct atoms between the line and its
+/// antecedents, the truth table is worked out in full (see TruthTable).
+/// With more, a SatEncoder searches for a row making the antecedents true
+/// and the line false instead; if it gives up after SAT_CONFLICT_LIMIT
+/// conflicts, the line isn't justified. Antecedents can't be subproofs.
+///
+/// It isn't marked sound (see Justification::isSound) even though it is, as
+/// the semantic prefilter would only repeat part of its own check.
+/// </summary>
+class TautologicalConsequence : public Justification
+{
+  public:
+  TautologicalConsequence(const char* name) : Justification(name)
+  {}
+
+  /// <summary>
+  /// Checks the truth table of the consequent and antecedents.
+  /// </summary>
+  /// <param name="consequent">
+  ///   The proposed consequent of applying the rule
+  /// </param>
+  /// <param name="antecedents">
+  ///   The antecedents the consequent must follow from
+  /// </param>
+  /// <returns>
+  ///   True if every assignment that makes the antecedents true makes the
+  ///   consequent true, and the SAT solver didn't give up checking that.
+  /// </returns>
+  bool isJustified(StatementTree& consequent, antecedent_list& antecedents);
+
+  /// <summary>
+  /// Hash of the rule's name, the limit on atoms and the SAT solver's limit
+  /// on conflicts.
+  /// </summary>
+  /// <returns>Hash of the rule</returns>
+  tree_hash fingerprint();
+};
+
+#endif
@@ -0,0 +1,235 @@
+#include "BatchVerifier.hpp"
+#include "Proof.hpp"
+#include "ProofReader.hpp"
+#include "ProofRules.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <windows.h>
+
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+
+#endif
+
+using std::string;
+using std::vector;
+using std::ifstream;
+using std::stringstream;
+using std::lock_guard;
+using std::mutex;
+using std::ostream;
+
+/// <summary>
+/// ParallelTask which verifies one file of a batch per task.
+/// </summary>
+class BatchTask : public ParallelTask
+{
+  private:
+  BatchVerifier& batch;
+
+  public:
+  BatchTask(BatchVerifier& verifier) : batch(verifier)
+  {}
+
+  void runTask(int index)
+  { batch.verifyFile(index); }
+};
+
+BatchVerifier::BatchVerifier() : verbose(false), cache(NULL), report(NULL),
+  next_report(0)
+{
+  //This space left intentionally blank
+}
+
+void BatchVerifier::setVerbose(bool is_verbose)
+{ verbose = is_verbose; }
+
+void BatchVerifier::setCache(VerificationCache* line_cache)
+{ cache = line_cache; }
+
+int BatchVerifier::fileCount()
+{ return entries.size(); }
+
+//Works out what kind of path this is and adds the file(s) it names.
+bool BatchVerifier::addPath(const char* path, ostream& errors)
+{
+  if(path[0] == MANIFEST_PREFIX)
+  {
+    if(addManifest(string(path+1))) return true;
+    errors << "Error: manifest " << (path+1) << " could not be read\n";
+    return false;
+  }
+
+#if defined(_WIN32)
+  DWORD attributes = GetFileAttributesA(path);
+  bool is_directory = attributes != INVALID_FILE_ATTRIBUTES &&
+    (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+  struct stat info;
+  bool is_directory = stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+  if(is_directory)
+  {
+    if(addDirectory(string(path))) return true;
+    errors << "Error: directory " << path << " could not be read\n";
+    return false;
+  }
+  
+  //Anything else is taken to be a proof file. If it can't be opened, that's
+  //reported as that file's result.
+  batch_entry added;
+  added.filename = path;
+  added.result = UNREADABLE;
+  added.done = false;
+  entries.push_back(added);
+  return true;
+}
+
+//Lists the directory, then adds its files sorted by name so the order of
+//results doesn't depend on the filesystem.
+bool BatchVerifier::addDirectory(const string& path)
+{
+  vector<string> names;
+#if defined(_WIN32)
+  WIN32_FIND_DATAA found;
+  HANDLE search = FindFirstFileA((path + "\\*").c_str(), &found);
+  if(search == INVALID_HANDLE_VALUE) return false;
+  do
+  {
+    if(found.cFileName[0] != '.' && !(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+      names.push_back(found.cFileName);
+  } while(FindNextFileA(search, &found));
+  FindClose(search);
+  string separator = "\\";
+#else
+  DIR* directory = opendir(path.c_str());
+  if(directory == NULL) return false;
+  for(struct dirent* found = readdir(directory); found != NULL; found = readdir(directory))
+  {
+    if(found->d_name[0] == '.') continue;
+    struct stat info;
+    string full_path = path + "/" + found->d_name;
+    if(stat(full_path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+      names.push_back(found->d_name);
+  }
+  closedir(directory);
+  string separator = "/";
+#endif
+  
+  std::sort(names.begin(), names.end());
+  for(unsigned int i = 0; i < names.size(); i++)
+  {
+    batch_entry added;
+    added.filename = path + separator + names[i];
+    added.result = UNREADABLE;
+    added.done = false;
+    entries.push_back(added);
+  }
+  return true;
+}
+
+//Each non-blank line of the manifest is a path. Directories and nested
+//manifests aren't expanded.
+bool BatchVerifier::addManifest(const string& path)
+{
+  ifstream manifest(path.c_str());
+  if(!manifest.is_open()) return false;
+  
+  string line;
+  while(std::getline(manifest, line))
+  {
+    if(line.size() > 0 && line[line.size()-1] == '\r')
+      line.erase(line.size()-1); //DOS File types
+    if(line.find_first_not_of(" \t") == string::npos) continue;
+    
+    batch_entry added;
+    added.filename = line;
+    added.result = UNREADABLE;
+    added.done = false;
+    entries.push_back(added);
+  }
+  return true;
+}
+
+//Runs the batch and writes the summary once every result has been written.
+bool BatchVerifier::run(WorkPool& pool, ostream& output)
+{
+  ProofRules::loadRules();
+  report = &output;
+  next_report = 0;
+  
+  BatchTask task(*this);
+  pool.run(task, entries.size());
+  
+  int passed = 0, failed = 0, unreadable = 0;
+  for(unsigned int i = 0; i < entries.size(); i++)
+  {
+    switch(entries[i].result)
+    {
+      case PASSED: passed++;
+        break;
+      case FAILED: failed++;
+        break;
+      default: unreadable++;
+        break;
+    }
+  }
+  output << "-------------------------\n";
+  output << "Checked " << entries.size() << " proofs: " << passed << " passed, "
+    << failed << " failed, " << unreadable << " could not be read\n";
+  return passed == (int)entries.size();
+}
+
+//Each file gets its own Proof and ProofReader, writing to a buffer so that
+//output from files verified at the same time isn't interleaved.
+void BatchVerifier::verifyFile(int index)
+{
+  batch_entry& current = entries[index];
+  stringstream buffer;
+  Proof proof;
+  ProofReader reader;
+  proof.setOutput(buffer);
+  proof.setCache(cache);
+  reader.setOutput(buffer, buffer);
+  reader.setTarget(&proof);
+  
+  if(!reader.readFile(current.filename.c_str()))
+    current.result = UNREADABLE;
+  else
+  {
+    if(verbose) proof.printProof();
+    current.result = proof.verifyProof() ? PASSED : FAILED;
+  }
+  if(verbose) current.output = buffer.str();
+  
+  lock_guard<mutex> guard(report_lock);
+  current.done = true;
+  writeFinishedResults();
+}
+
+void BatchVerifier::writeFinishedResults()
+{
+  for(; next_report < entries.size() && entries[next_report].done; next_report++)
+  {
+    batch_entry& finished = entries[next_report];
+    if(verbose)
+    {
+      *report << "=== " << finished.filename << "\n" << finished.output;
+      finished.output.clear();
+    }
+    switch(finished.result)
+    {
+      case PASSED: *report << "PASS  ";
+        break;
+      case FAILED: *report << "FAIL  ";
+        break;
+      default: *report << "ERROR ";
+        break;
+    }
+    *report << finished.filename << "\n";
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef __BATCH_VERIFIER_H_
+#define __BATCH_VERIFIER_H_
+
+#include "WorkPool.hpp"
+#include "VerificationCache.hpp"
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define MANIFEST_PREFIX '@'
+
+/// <summary>
+/// Verifies many proof files in one run. Proofs are read and verified
+/// concurrently on a WorkPool, all using the one set of rules loaded by
+/// ProofRules. Each file gets a pass/fail line, in the order the files were
+/// given, followed by a summary of the whole batch.
+/// </summary>
+class BatchVerifier
+{
+  public:
+  enum file_result_t { PASSED, FAILED, UNREADABLE };
+
+  private:
+  /// <summary>
+  /// One proof file in the batch.
+  /// </summary>
+  struct batch_entry
+  {
+    std::string filename;
+    file_result_t result;
+    std::string output; //Printout of the proof, if verbose
+    bool done;
+  };
+
+  std::vector<batch_entry> entries;
+  bool verbose;
+  VerificationCache* cache;
+
+  //Results are written in order as they're finished
+  std::mutex report_lock;
+  std::ostream* report;
+  unsigned int next_report;
+
+  /// <summary>
+  /// Adds every file in a directory (not including subdirectories or hidden
+  /// files), in order of name.
+  /// </summary>
+  /// <returns>False if the directory couldn't be read</returns>
+  bool addDirectory(const std::string& path);
+
+  /// <summary>
+  /// Adds the files listed in a manifest file, one path per line.
+  /// </summary>
+  /// <returns>False if the manifest couldn't be read</returns>
+  bool addManifest(const std::string& path);
+
+  /// <summary>
+  /// Reads and verifies one proof file, then reports any results that are
+  /// now ready to be written. Called from the pool's worker threads.
+  /// </summary>
+  /// <param name="index">Index of the file in the batch</param>
+  void verifyFile(int index);
+
+  /// <summary>
+  /// Writes the results of finished files, up to the first unfinished one.
+  /// The report lock must be held.
+  /// </summary>
+  void writeFinishedResults();
+
+  friend class BatchTask;
+
+  public:
+  BatchVerifier();
+
+  /// <summary>
+  /// When verbose, each file's result is preceded by the printout of the
+  /// proof and its verification, as for a single file.
+  /// </summary>
+  void setVerbose(bool is_verbose);
+
+  /// <summary>
+  /// Sets a cache of results from checking lines, shared by every proof in
+  /// the batch. Null (the default) for no cache.
+  /// </summary>
+  /// <param name="line_cache">Cache to use. Isn't owned by the batch.</param>
+  void setCache(VerificationCache* line_cache);
+
+  /// <summary>
+  /// Adds proof files to the batch. The path may be:
+  /// -A proof file
+  /// -A directory, in which case all the files in it are added
+  /// -A manifest file prefixed with MANIFEST_PREFIX (e.g. "@list.txt"),
+  ///  which lists one proof file per line. Paths in it are relative to the
+  ///  working directory, the same as lemma files in proofs.
+  /// </summary>
+  /// <param name="path">Path to add</param>
+  /// <param name="errors">Stream to write a message to if the path can't be read</param>
+  /// <returns>False if a directory or manifest couldn't be read</returns>
+  bool addPath(const char* path, std::ostream& errors);
+
+  /// <summary>
+  /// Number of proof files in the batch.
+  /// </summary>
+  int fileCount();
+
+  /// <summary>
+  /// Verifies every file in the batch, writing a result line for each file
+  /// and then a summary. The rules file is loaded before the files are
+  /// started, so the workers share the loaded rules.
+  /// </summary>
+  /// <param name="pool">Threads to verify files on</param>
+  /// <param name="output">Stream to write results to</param>
+  /// <returns>True if every proof was read and verified successfully</returns>
+  bool run(WorkPool& pool, std::ostream& output);
+};
+
+#endif
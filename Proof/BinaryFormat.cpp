@@ -0,0 +1,167 @@
+#include "BinaryFormat.hpp"
+#include <cstdio>
+#include <cstring>
+
+using std::unordered_map;
+using std::vector;
+
+#define FORMULA_TYPE_MASK 7
+#define FORMULA_NEGATED 8
+
+//Little-endian, so the file doesn't depend on the machine.
+void BinaryWriter::writeWord(unsigned int value)
+{
+  for(int i = 0; i < 4; i++)
+  {
+    contents.push_back((unsigned char)(value & 0xFF));
+    value >>= 8;
+  }
+}
+
+void BinaryWriter::writeBytes(const char* bytes, int length)
+{ contents.insert(contents.end(), bytes, bytes + length); }
+
+void BinaryWriter::writeString(const char* text, int length)
+{
+  writeWord(length);
+  writeBytes(text, length);
+}
+
+void BinaryWriter::append(const BinaryWriter& other)
+{ contents.insert(contents.end(), other.contents.begin(), other.contents.end()); }
+
+const vector<unsigned char>& BinaryWriter::data()
+{ return contents; }
+
+bool BinaryWriter::save(const char* filename)
+{
+  FILE* file = fopen(filename, "wb");
+  if(file == NULL) return false;
+  bool written = contents.empty() || fwrite(&contents[0], 1, contents.size(), file) == contents.size();
+  if(fclose(file) != 0) written = false;
+  return written;
+}
+
+//Adds the tree's nodes children first. Iterative so that very deep trees don't
+//exhaust the stack.
+int FormulaTableWriter::addFormula(StatementTree* tree)
+{
+  vector<StatementTree*> pending(1, tree);
+  while(!pending.empty())
+  {
+    StatementTree* node = pending.back();
+    if(formula_indices.find(node) != formula_indices.end())
+    {
+      pending.pop_back();
+      continue;
+    }
+
+    bool children_added = true;
+    for(child_itr itr = node->begin(); itr != node->end(); itr++)
+    {
+      if(formula_indices.find(*itr) == formula_indices.end())
+      {
+        pending.push_back(*itr);
+        children_added = false;
+      }
+    }
+    if(!children_added) continue;
+    pending.pop_back();
+
+    formulas.writeWord(node->nodeType() | (node->isAffirmed() ? 0 : FORMULA_NEGATED));
+    if(node->nodeType() == StatementTree::ATOM)
+    {
+      unordered_map<int, int>::iterator found = atom_indices.find(node->atomId());
+      if(found == atom_indices.end())
+      {
+        found = atom_indices.insert(std::make_pair(node->atomId(), (int)atom_names.size())).first;
+        atom_names.push_back(node->atomName());
+      }
+      formulas.writeWord(found->second);
+    }
+    else
+    {
+      for(child_itr itr = node->begin(); itr != node->end(); itr++)
+        formulas.writeWord(formula_indices[*itr]);
+    }
+    int index = formula_indices.size();
+    formula_indices[node] = index;
+  }
+  return formula_indices[tree];
+}
+
+void FormulaTableWriter::write(BinaryWriter& output)
+{
+  output.writeWord(atom_names.size());
+  output.writeWord(formula_indices.size());
+  for(unsigned int i = 0; i < atom_names.size(); i++)
+    output.writeString(atom_names[i], strlen(atom_names[i]));
+  output.append(formulas);
+}
+
+BinaryReader::BinaryReader(const char* data, size_t size) :
+  position((const unsigned char*)data), data_end((const unsigned char*)data + size)
+{
+  //This space left intentionally blank
+}
+
+bool BinaryReader::readWord(unsigned int& value)
+{
+  if(data_end - position < 4) return false;
+  value = position[0] | (position[1] << 8) | (position[2] << 16) | ((unsigned int)position[3] << 24);
+  position += 4;
+  return true;
+}
+
+bool BinaryReader::readString(const char*& text, int& length)
+{
+  unsigned int string_length;
+  if(!readWord(string_length)) return false;
+  if((size_t)(data_end - position) < string_length) return false;
+  text = (const char*)position;
+  length = string_length;
+  position += string_length;
+  return true;
+}
+
+//Every index is checked before it's used. Operators can only refer to
+//formulas before them, so the table can't have cycles.
+bool BinaryReader::readFormulas(vector<StatementTree*>& formulas)
+{
+  unsigned int atom_count, formula_count;
+  if(!readWord(atom_count) || !readWord(formula_count)) return false;
+
+  //Each name is at least one word, and each formula at least two
+  if(atom_count > (size_t)(data_end - position) / 4) return false;
+  vector<const char*> names(atom_count);
+  vector<int> name_lengths(atom_count);
+  for(unsigned int i = 0; i < atom_count; i++)
+    if(!readString(names[i], name_lengths[i])) return false;
+  if(formula_count > (size_t)(data_end - position) / 8) return false;
+
+  size_t first = formulas.size();
+  formulas.reserve(first + formula_count);
+  for(unsigned int i = 0; i < formula_count; i++)
+  {
+    unsigned int header, left, right;
+    if(!readWord(header) || !readWord(left)) return false;
+    int node_type = header & FORMULA_TYPE_MASK;
+    bool affirmed = (header & FORMULA_NEGATED) == 0;
+    if(node_type == StatementTree::ATOM)
+    {
+      if(left >= atom_count) return false;
+      formulas.push_back(StatementTree::createAtom(names[left], name_lengths[left], affirmed));
+    }
+    else
+    {
+      if(node_type >= StatementTree::NOT || !readWord(right) || left >= i || right >= i)
+        return false;
+      formulas.push_back(StatementTree::createOperator(node_type, affirmed,
+        StatementTree::create(*formulas[first + left]), StatementTree::create(*formulas[first + right])));
+    }
+  }
+  return true;
+}
+
+bool BinaryReader::atEnd()
+{ return position == data_end; }
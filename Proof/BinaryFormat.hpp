@@ -0,0 +1,145 @@
+#ifndef __BINARY_FORMAT_H_
+#define __BINARY_FORMAT_H_
+
+#include "StatementTree.hpp"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Builds up the contents of a binary file (a binary proof or a rule pack).
+/// Numbers are written as 32 bit little-endian words, so files don't depend
+/// on the machine.
+/// </summary>
+class BinaryWriter
+{
+  private:
+  std::vector<unsigned char> contents;
+
+  public:
+  /// <summary>
+  /// Appends a word.
+  /// </summary>
+  /// <param name="value">Value to write. Negative ints are written as their unsigned form.</param>
+  void writeWord(unsigned int value);
+
+  /// <summary>
+  /// Appends bytes as they are, such as a file header.
+  /// </summary>
+  /// <param name="bytes">Bytes to write</param>
+  /// <param name="length">Number of bytes</param>
+  void writeBytes(const char* bytes, int length);
+
+  /// <summary>
+  /// Appends a string, as its length followed by its characters.
+  /// </summary>
+  /// <param name="text">Characters to write. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters</param>
+  void writeString(const char* text, int length);
+
+  /// <summary>
+  /// Appends everything written to another writer.
+  /// </summary>
+  /// <param name="other">Writer to copy from</param>
+  void append(const BinaryWriter& other);
+
+  /// <summary>
+  /// Everything written so far.
+  /// </summary>
+  /// <returns>Contents of the file</returns>
+  const std::vector<unsigned char>& data();
+
+  /// <summary>
+  /// Writes everything written so far to a file, replacing it.
+  /// </summary>
+  /// <param name="filename">File to write</param>
+  /// <returns>False if the file couldn't be written</returns>
+  bool save(const char* filename);
+};
+
+/// <summary>
+/// Table of sentences for a binary file. Every distinct subtree is stored
+/// once, with an operator's children before it, so trees shared between
+/// sentences (which hash-consing makes common) are only written once.
+/// Sentences are then referred to by their index in the table.
+///
+/// Written as the number of atom names and of formulas, the atom names, then
+/// each formula: a word with the node type and a negation flag, then the
+/// atom's name index, or the operator's children by formula index.
+/// </summary>
+class FormulaTableWriter
+{
+  private:
+  std::unordered_map<StatementTree*, int> formula_indices;
+  std::unordered_map<int, int> atom_indices; //By AtomTable id
+  std::vector<const char*> atom_names;
+  BinaryWriter formulas;
+
+  public:
+  /// <summary>
+  /// Adds a tree to the table, along with any of its subtrees not in it yet.
+  /// </summary>
+  /// <param name="tree">Tree to add</param>
+  /// <returns>Index of the tree in the table</returns>
+  int addFormula(StatementTree* tree);
+
+  /// <summary>
+  /// Writes the table.
+  /// </summary>
+  /// <param name="output">Writer to write to</param>
+  void write(BinaryWriter& output);
+};
+
+/// <summary>
+/// Reads the contents of a binary file in place, as written by BinaryWriter.
+/// Reads fail rather than going past the end of the data, so that a damaged
+/// file can be rejected.
+/// </summary>
+class BinaryReader
+{
+  private:
+  const unsigned char* position;
+  const unsigned char* data_end;
+
+  public:
+  /// <summary>
+  /// Starts reading data.
+  /// </summary>
+  /// <param name="data">Data to read, which must outlast the reader</param>
+  /// <param name="size">Length of the data</param>
+  BinaryReader(const char* data, size_t size);
+
+  /// <summary>
+  /// Reads a word.
+  /// </summary>
+  /// <param name="value">Set to the word read</param>
+  /// <returns>False if the data ended</returns>
+  bool readWord(unsigned int& value);
+
+  /// <summary>
+  /// Reads a string without copying it.
+  /// </summary>
+  /// <param name="text">Set to the start of the string in the data. Not null terminated.</param>
+  /// <param name="length">Set to the length of the string</param>
+  /// <returns>False if the data ended</returns>
+  bool readString(const char*& text, int& length);
+
+  /// <summary>
+  /// Reads a table written by FormulaTableWriter, creating each of its trees
+  /// without parsing them.
+  /// </summary>
+  /// <param name="formulas">
+  ///   A reference to each tree in the table is added to the end, in order. They must be given
+  ///   back with StatementTree::release, including any read before an error.
+  /// </param>
+  /// <returns>False if the table isn't valid</returns>
+  bool readFormulas(std::vector<StatementTree*>& formulas);
+
+  /// <summary>
+  /// Whether all the data has been read.
+  /// </summary>
+  /// <returns>True if there's nothing left to read</returns>
+  bool atEnd();
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "BinaryProof.hpp"
+#include "BinaryFormat.hpp"
+#include "ProofReader.hpp"
+#include <cstring>
+#include <unordered_map>
+
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+#define BINARY_PROOF_MAGIC_SIZE 7
+#define LINE_TYPE_BITS 2
+
+//Magic bytes, then the format version.
+static const char binary_proof_header[BINARY_PROOF_HEADER_SIZE] =
+  { 'L', 'O', 'G', 'I', 'C', 'V', 'P', BINARY_PROOF_VERSION };
+
+BinaryProof::BinaryProof() : target(NULL), out(&std::cout), err(&std::cerr)
+{
+  //This space left intentionally blank
+}
+
+void BinaryProof::setOutput(std::ostream& output, std::ostream& errors)
+{
+  out = &output;
+  err = &errors;
+}
+
+void BinaryProof::setTarget(Proof* new_target)
+{ target = new_target; }
+
+bool BinaryProof::isBinary(const char* data, size_t size)
+{
+  return size >= BINARY_PROOF_MAGIC_SIZE &&
+    memcmp(data, binary_proof_header, BINARY_PROOF_MAGIC_SIZE) == 0;
+}
+
+//Antecedents that are subproofs are written as the index of their assumption,
+//which Proof::toggleAntecedent resolves back to the same subproof.
+bool BinaryProof::write(Proof& proof, const vector<string>& lemma_lines, const char* filename)
+{
+  unordered_map<ProofStatement*, int> line_indices;
+  for(int i = 0; i < proof.lineCount(); i++)
+    line_indices[proof.getLine(i)] = i;
+
+  FormulaTableWriter formulas;
+  unordered_map<Justification*, int> rule_indices;
+  vector<const char*> rule_names;
+  BinaryWriter lines;
+  for(int i = 0; i < proof.lineCount(); i++)
+  {
+    ProofStatement* line = proof.getLine(i);
+    Proof::line_type_t line_type = Proof::DERIVED_LINE;
+    if(i < proof.premiseCount())
+      line_type = Proof::PREMISE_LINE;
+    else if(line->isAssumption())
+      line_type = Proof::ASSUMPTION_LINE;
+    lines.writeWord(line_type | (line->getDepth() << LINE_TYPE_BITS));
+    lines.writeWord(formulas.addFormula(line->getStatementData()));
+
+    int rule_index = -1;
+    Justification* rule = line->getJustification();
+    if(line_type == Proof::DERIVED_LINE && rule != NULL)
+    {
+      unordered_map<Justification*, int>::iterator found = rule_indices.find(rule);
+      if(found == rule_indices.end())
+      {
+        found = rule_indices.insert(std::make_pair(rule, (int)rule_names.size())).first;
+        rule_names.push_back(rule->getName());
+      }
+      rule_index = found->second;
+    }
+    lines.writeWord(rule_index);
+
+    const antecedent_list& antecedents = line->getAntecedents();
+    lines.writeWord(antecedents.size());
+    for(antecedent_list::const_iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+    {
+      ProofStatement* cited = *itr;
+      if(cited->getSubproofContents() != NULL)
+        cited = ((SubProof*)cited)->getAssumptionStatement();
+      lines.writeWord(line_indices[cited]);
+    }
+  }
+  int goal_index = (proof.getGoal() == NULL) ? -1 : formulas.addFormula(proof.getGoal());
+
+  BinaryWriter contents;
+  contents.writeBytes(binary_proof_header, BINARY_PROOF_HEADER_SIZE);
+  contents.writeWord(rule_names.size());
+  contents.writeWord(lemma_lines.size());
+  contents.writeWord(proof.lineCount());
+  contents.writeWord(goal_index);
+  for(unsigned int i = 0; i < rule_names.size(); i++)
+    contents.writeString(rule_names[i], strlen(rule_names[i]));
+  for(unsigned int i = 0; i < lemma_lines.size(); i++)
+    contents.writeString(lemma_lines[i].c_str(), lemma_lines[i].size());
+  formulas.write(contents);
+  contents.append(lines);
+
+  if(!contents.save(filename))
+  {
+    *err << "Error: file " << filename << " could not be written\n";
+    return false;
+  }
+  return true;
+}
+
+//Lemmas are read first, so that lemma rules can be found along with the rest.
+//Every index is checked before it's used, so a damaged file is rejected rather
+//than read out of bounds.
+bool BinaryProof::read(const char* source_name, const char* data, size_t size,
+  ProofReader& lemma_reader)
+{
+  if(target == NULL)
+  {
+    *err << "Error: no proof to read file " << source_name << " into\n";
+    return false;
+  }
+  if(!isBinary(data, size) || size < BINARY_PROOF_HEADER_SIZE)
+  {
+    *err << "Error: file " << source_name << " is not a valid binary proof\n";
+    return false;
+  }
+  if(data[BINARY_PROOF_MAGIC_SIZE] != BINARY_PROOF_VERSION)
+  {
+    *err << "Error: file " << source_name << " is from a different version of the binary proof format\n";
+    return false;
+  }
+
+  BinaryReader input(data + BINARY_PROOF_HEADER_SIZE, size - BINARY_PROOF_HEADER_SIZE);
+  unsigned int rule_count, lemma_count, line_count, goal_index;
+  bool valid = input.readWord(rule_count) && input.readWord(lemma_count) &&
+    input.readWord(line_count) && input.readWord(goal_index);
+
+  //Names are used in place
+  vector<const char*> rule_names;
+  vector<int> name_lengths;
+  for(unsigned int i = 0; valid && i < rule_count; i++)
+  {
+    const char* rule_name;
+    int length;
+    valid = input.readString(rule_name, length);
+    rule_names.push_back(rule_name);
+    name_lengths.push_back(length);
+  }
+  for(unsigned int i = 0; valid && i < lemma_count; i++)
+  {
+    const char* lemma_line;
+    int length;
+    valid = input.readString(lemma_line, length);
+    if(valid && !lemma_reader.readLine(source_name, lemma_line, length)) return false;
+  }
+
+  vector<Justification*> rules;
+  for(unsigned int i = 0; valid && i < rule_count; i++)
+    rules.push_back(target->findRule(rule_names[i], name_lengths[i]));
+
+  vector<StatementTree*> formulas;
+  valid = valid && input.readFormulas(formulas);
+  for(unsigned int i = 0; valid && i < line_count; i++)
+  {
+    unsigned int header, formula, rule, antecedent_count;
+    valid = input.readWord(header) && input.readWord(formula) && input.readWord(rule) &&
+      input.readWord(antecedent_count) && formula < formulas.size() &&
+      (rule < rules.size() || (int)rule == -1) &&
+      (header & ((1 << LINE_TYPE_BITS)-1)) <= Proof::DERIVED_LINE &&
+      target->appendLine((Proof::line_type_t)(header & ((1 << LINE_TYPE_BITS)-1)),
+        header >> LINE_TYPE_BITS, *formulas[formula]);
+    if(!valid) break;
+    if((int)rule != -1) target->setJustification(rules[rule]);
+
+    for(unsigned int j = 0; valid && j < antecedent_count; j++)
+    {
+      unsigned int antecedent;
+      valid = input.readWord(antecedent) && antecedent < i;
+      if(valid) target->toggleAntecedent(antecedent);
+    }
+  }
+
+  valid = valid && input.atEnd() && ((int)goal_index == -1 || goal_index < formulas.size());
+  if(valid && (int)goal_index != -1) target->setGoal(*formulas[goal_index]);
+  for(unsigned int i = 0; i < formulas.size(); i++)
+    StatementTree::release(formulas[i]);
+  if(!valid) *err << "Error: file " << source_name << " is not a valid binary proof\n";
+  return valid;
+}
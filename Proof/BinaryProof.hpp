@@ -0,0 +1,84 @@
+#ifndef __BINARY_PROOF_H_
+#define __BINARY_PROOF_H_
+
+#include "Proof.hpp"
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define BINARY_PROOF_HEADER_SIZE 8
+#define BINARY_PROOF_VERSION 2
+
+class ProofReader;
+
+/// <summary>
+/// Reads and writes proofs in a compact binary format, so that a proof which
+/// is verified again and again doesn't have to have its sentences parsed and
+/// its rules and antecedent line numbers looked up every time.
+///
+/// The file is a header, then tables that are read straight into a Proof:
+/// - Rule names, and the text of any lemma lines
+/// - Every sentence in the proof, as a FormulaTableWriter table
+/// - Lines: the kind of line, how many subproofs it's in, its sentence and
+///   rule by index, then its antecedents by line index (a subproof by the
+///   index of its assumption).
+/// Rules are kept by name so the file still works if rules.xml changes, but
+/// each name is only looked up once.
+///
+/// Lemma lines are kept as text and read by a ProofReader when loading, since
+/// they read (and verify) other proof files anyway.
+/// </summary>
+class BinaryProof
+{
+  private:
+  Proof* target;
+  std::ostream* out;
+  std::ostream* err;
+
+  public:
+  BinaryProof();
+
+  /// <summary>
+  /// Sets where messages are written while reading, as for ProofReader.
+  /// Defaults to the console.
+  /// </summary>
+  /// <param name="output">Stream for normal output</param>
+  /// <param name="errors">Stream for error messages</param>
+  void setOutput(std::ostream& output, std::ostream& errors);
+
+  /// <summary>
+  /// Sets the Proof object to read into. This should be an empty proof.
+  /// </summary>
+  /// <param name="new_target">Proof object to read the proof into</param>
+  void setTarget(Proof* new_target);
+
+  /// <summary>
+  /// Reads a binary proof into the Proof.
+  /// </summary>
+  /// <param name="source_name">Name of the file, for error messages</param>
+  /// <param name="data">Contents of the file</param>
+  /// <param name="size">Length of the contents</param>
+  /// <param name="lemma_reader">Reader targeting the same proof, to read lemma lines with</param>
+  /// <returns>False if the data isn't a valid binary proof or a lemma couldn't be read</returns>
+  bool read(const char* source_name, const char* data, size_t size, ProofReader& lemma_reader);
+
+  /// <summary>
+  /// Writes a proof to a binary file.
+  /// </summary>
+  /// <param name="proof">Proof to write</param>
+  /// <param name="lemma_lines">Lemma lines the proof was read with (see ProofReader)</param>
+  /// <param name="filename">File to write to</param>
+  /// <returns>False if the file couldn't be written</returns>
+  bool write(Proof& proof, const std::vector<std::string>& lemma_lines, const char* filename);
+
+  /// <summary>
+  /// Does data start with the header of a binary proof?
+  /// </summary>
+  /// <param name="data">Start of a file</param>
+  /// <param name="size">Length of the data</param>
+  /// <returns>True if the data is a binary proof of this version</returns>
+  static bool isBinary(const char* data, size_t size);
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "MappedFile.hpp"
+
+#define READ_CHUNK_SIZE 65536
+
+#if defined(_WIN32)
+#include <windows.h>
+
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif
+
+MappedFile::MappedFile() : contents(NULL), length(0)
+{
+#if defined(_WIN32)
+  file_handle = INVALID_HANDLE_VALUE;
+  mapping_handle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+#if defined(_WIN32)
+bool MappedFile::open(const char* filename)
+{
+  close();
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file == INVALID_HANDLE_VALUE) return false;
+  file_handle = file;
+
+  //Pipes and the like have no size, and can only be read in. Empty files
+  //can't be mapped, but may only report a size of 0 (as some devices do).
+  LARGE_INTEGER file_size;
+  if(GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &file_size) ||
+    file_size.QuadPart == 0)
+  {
+    if(readAll(file)) return true;
+    close();
+    return false;
+  }
+
+  mapping_handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(mapping_handle != NULL)
+    contents = (const char*)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  if(contents == NULL)
+  {
+    //Read it in instead, from the start as nothing has been read yet
+    if(mapping_handle != NULL) CloseHandle(mapping_handle);
+    mapping_handle = NULL;
+    if(readAll(file)) return true;
+    close();
+    return false;
+  }
+  length = (size_t)file_size.QuadPart;
+  return true;
+}
+
+bool MappedFile::readAll(void* file)
+{
+  DWORD count;
+  do
+  {
+    size_t start = buffer.size();
+    buffer.resize(start + READ_CHUNK_SIZE);
+    if(!ReadFile(file, &buffer[start], READ_CHUNK_SIZE, &count, NULL))
+    {
+      //A pipe whose writer has finished reports that as an error
+      buffer.resize(start);
+      if(GetLastError() != ERROR_BROKEN_PIPE) return false;
+      count = 0;
+    }
+    else
+      buffer.resize(start + count);
+  } while(count > 0);
+  
+  contents = buffer.empty() ? NULL : &buffer[0];
+  length = buffer.size();
+  return true;
+}
+
+void MappedFile::close()
+{
+  if(contents != NULL && buffer.empty()) UnmapViewOfFile(contents);
+  if(mapping_handle != NULL) CloseHandle(mapping_handle);
+  if(file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+  std::vector<char>().swap(buffer);
+  contents = NULL;
+  length = 0;
+  mapping_handle = NULL;
+  file_handle = INVALID_HANDLE_VALUE;
+}
+
+#else
+//The descriptor is only needed to make the mapping, which stays valid after
+//it's closed.
+bool MappedFile::open(const char* filename)
+{
+  close();
+  int file = ::open(filename, O_RDONLY);
+  if(file < 0) return false;
+
+  //Pipes, terminals and the like can only be read in. Empty files can't be
+  //mapped, but may only report a size of 0 (as files in /proc do).
+  struct stat file_info;
+  bool read_in = fstat(file, &file_info) != 0 || !S_ISREG(file_info.st_mode) ||
+    file_info.st_size == 0;
+  void* mapping = MAP_FAILED;
+  if(!read_in)
+    mapping = mmap(NULL, file_info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  if(mapping == MAP_FAILED)
+  {
+    //Nothing has been read yet, so this reads the whole file
+    bool read_ok = readAll(file);
+    ::close(file);
+    return read_ok;
+  }
+
+  ::close(file);
+  madvise(mapping, file_info.st_size, MADV_SEQUENTIAL); //Lines are read in order
+  contents = (const char*)mapping;
+  length = file_info.st_size;
+  return true;
+}
+
+bool MappedFile::readAll(int file)
+{
+  ssize_t count;
+  do
+  {
+    size_t start = buffer.size();
+    buffer.resize(start + READ_CHUNK_SIZE);
+    count = read(file, &buffer[start], READ_CHUNK_SIZE);
+    buffer.resize(start + ((count > 0) ? count : 0));
+    if(count < 0 && errno != EINTR)
+    {
+      std::vector<char>().swap(buffer);
+      return false;
+    }
+  } while(count != 0);
+
+  contents = buffer.empty() ? NULL : &buffer[0];
+  length = buffer.size();
+  return true;
+}
+
+void MappedFile::close()
+{
+  if(contents != NULL && buffer.empty()) munmap((void*)contents, length);
+  std::vector<char>().swap(buffer);
+  contents = NULL;
+  length = 0;
+}
+
+#endif
+
+const char* MappedFile::data()
+{ return contents; }
+
+size_t MappedFile::size()
+{ return length; }
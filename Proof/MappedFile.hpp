@@ -0,0 +1,72 @@
+#ifndef __MAPPED_FILE_H_
+#define __MAPPED_FILE_H_
+
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// A file mapped read-only into memory, so it can be read in place rather
+/// than copied into buffers. The mapping lasts until the file is closed or
+/// the object is destroyed; pointers into it aren't valid after that.
+///
+/// Files that can't be mapped, such as pipes, /dev/stdin, or a regular file
+/// the system won't map, are read into a buffer instead, which is used the
+/// same way.
+/// </summary>
+class MappedFile
+{
+  private:
+  const char* contents;
+  size_t length;
+  std::vector<char> buffer; //Contents of a file that was read rather than mapped
+#if defined(_WIN32)
+  void* file_handle;
+  void* mapping_handle;
+#endif
+
+  /// <summary>
+  /// Helper for open, reads the rest of an open file into the buffer.
+  /// </summary>
+  /// <returns>False if the file couldn't be read</returns>
+#if defined(_WIN32)
+  bool readAll(void* file);
+#else
+  bool readAll(int file);
+#endif
+
+  //Not copyable, since the mapping is owned
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+  public:
+  MappedFile();
+  ~MappedFile();
+
+  /// <summary>
+  /// Maps a file, closing any file already mapped, or reads it in if it can't
+  /// be mapped. An empty file opens successfully with no contents.
+  /// </summary>
+  /// <param name="filename">File to map</param>
+  /// <returns>False if the file couldn't be opened or read</returns>
+  bool open(const char* filename);
+
+  /// <summary>
+  /// Unmaps the file, or frees its contents if it was read in. Does nothing
+  /// if no file is open.
+  /// </summary>
+  void close();
+
+  /// <summary>
+  /// Contents of the file. Not null terminated.
+  /// </summary>
+  /// <returns>Start of the contents, or null if the file is empty</returns>
+  const char* data();
+
+  /// <summary>
+  /// Length of the file.
+  /// </summary>
+  /// <returns>Number of bytes in the file</returns>
+  size_t size();
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "Proof.hpp"
 #include "ProofRules.hpp"
 #include "StatementTree.hpp"
+#include "SatEncoder.hpp"
+#include <climits>
 #include <iostream>
 #include <stack>
 #include <utility>
@@ -11,17 +13,152 @@ using std::endl;
 using std::stack;
 using std::pair;
 using std::string;
+using std::vector;
 
-Proof::Proof() : current_position(-1), last_premise(-1), goal(NULL)
+/// <summary>
+/// ParallelTask for checking the lines of a proof. Each task checks one of the
+/// listed lines and records the result. Justifications don't change rule or
+/// tree data, and each line only stores its own failure type, so lines can be
+/// checked on different threads at once.
+/// </summary>
+class LineCheckTask : public ParallelTask
+{
+  private:
+  proof_list& lines;
+  vector<int>& to_check;
+  vector<char>& justified;
+  VerificationCache* cache;
+
+  public:
+  LineCheckTask(proof_list& proof_lines, vector<int>& line_indices, vector<char>& results,
+    VerificationCache* line_cache) :
+    lines(proof_lines), to_check(line_indices), justified(results), cache(line_cache)
+  {}
+
+  void runTask(int index)
+  {
+    int line = to_check[index];
+    justified[line] = lines[line]->isJustified(cache);
+  }
+};
+
+bool Proof::goal_precheck = false;
+
+Proof::Proof() : current_position(-1), last_premise(-1), goal(NULL),
+  enclosing_proof(NULL), out(&cout), cache(NULL), track_changes(false), scopes_current(true),
+  low_memory(false), released_lines(0)
 {
   //This space left intentionally blank
 }
 
+//Proof lines (including removed ones and the subproofs themselves) are
+//destroyed along with the arena.
 Proof::~Proof()
 {
-  for(unsigned int i = 0; i < proof_data.size(); i++)
-    delete proof_data[i];
-  if(goal != NULL) delete goal;
+  StatementTree::release(goal);
+  for(justification_map::iterator itr = lemma_rules.begin(); itr != lemma_rules.end(); itr++)
+    delete itr->second;
+}
+
+void Proof::setOutput(std::ostream& output)
+{ out = &output; }
+
+void Proof::setEnclosingProof(Proof* enclosing)
+{
+  enclosing_proof = enclosing;
+  if(enclosing != NULL) cache = enclosing->cache;
+}
+
+void Proof::setCache(VerificationCache* line_cache)
+{ cache = line_cache; }
+
+//Searches this proof's lemma rules, then those of enclosing proofs, then the
+//rules file.
+Justification* Proof::findRule(const char* rule_name)
+{
+  for(Proof* proof = this; proof != NULL; proof = proof->enclosing_proof)
+  {
+    justification_map::iterator itr = proof->lemma_rules.find(string(rule_name));
+    if(itr != proof->lemma_rules.end()) return itr->second;
+  }
+  return ProofRules::findRule(rule_name);
+}
+
+//Checks the rule remembered under the name's hash first, comparing names in
+//case two of them share a hash. Missing rules aren't remembered, as a lemma
+//could still add one by that name.
+Justification* Proof::findRule(const char* rule_name, int length)
+{
+  unsigned long long name_hash = AtomTable::hashName(rule_name, length);
+  std::unordered_map<unsigned long long, Justification*>::iterator found = found_rules.find(name_hash);
+  if(found != found_rules.end())
+  {
+    char* found_name = found->second->getName();
+    if(strncmp(found_name, rule_name, length) == 0 && found_name[length] == '\0')
+      return found->second;
+  }
+  
+  Justification* rule = findRule(string(rule_name, length).c_str());
+  if(rule != NULL) found_rules[name_hash] = rule;
+  return rule;
+}
+
+void Proof::setLowMemory(bool enabled)
+{
+  low_memory = enabled;
+}
+
+//Subproofs are closed innermost first, so by the time one is released the
+//subproofs within it have already had their insides released.
+void Proof::releaseCheckedLines(int checked_lines)
+{
+  if(!low_memory) return;
+  if(checked_lines > (int)proof_data.size()) checked_lines = proof_data.size();
+  for(; released_lines < checked_lines; released_lines++)
+    proof_data[released_lines]->clearAntecedents();
+  
+  unsigned int released = 0;
+  for(; released < closed_subproofs.size(); released++)
+  {
+    ProofStatement* closed = closed_subproofs[released];
+    if(closed->getScopeClose() >= checked_lines) break; //Lines in it still to be checked
+    
+    vector<ProofStatement*> nested;
+    statement_set* contents = closed->getSubproofContents();
+    for(statement_set::iterator itr = contents->begin(); itr != contents->end(); itr++)
+    {
+      //Subproofs without an interval (see addScope) aren't all together, so are kept
+      if((*itr)->getSubproofContents() != NULL && (*itr)->getScopeOpen() >= 0)
+        nested.push_back(*itr);
+    }
+    for(unsigned int i = 0; i < nested.size(); i++)
+    {
+      nested[i]->setParent(NULL);
+      releaseSubproof(nested[i], closed);
+    }
+  }
+  closed_subproofs.erase(closed_subproofs.begin(), closed_subproofs.begin()+released);
+}
+
+//Destroys the subproof and everything in it. Its lines are all in its scope
+//interval, including ones given to it when subproofs in it were released.
+void Proof::releaseSubproof(ProofStatement* subproof, ProofStatement* replacement)
+{
+  if(replacement != NULL)
+  {
+    for(int i = subproof->getScopeOpen(); i <= subproof->getScopeClose(); i++)
+      proof_data[i] = replacement;
+  }
+  
+  statement_set* contents = subproof->getSubproofContents();
+  for(statement_set::iterator itr = contents->begin(); itr != contents->end(); itr++)
+  {
+    if((*itr)->getSubproofContents() != NULL)
+      releaseSubproof(*itr, NULL);
+    else
+      arena.recycleStatement(*itr, sizeof(ProofStatement));
+  }
+  arena.recycleStatement(subproof, sizeof(SubProof));
 }
 
 //Sets the current focus position for editing.
@@ -42,15 +179,43 @@ void Proof::setStatement(const char* statement_string)
   if(current_position == -1) return; //Shouldn't ever be >= size.
   
   proof_data[current_position]->rewrite(statement_string);
+  markChanged(proof_data[current_position]);
+}
+
+//Sets the sentence of the focused statement to the given length of a string.
+void Proof::setStatement(const char* statement_string, int length)
+{
+  if(current_position == -1) return;
+  
+  proof_data[current_position]->rewrite(statement_string, length);
+  markChanged(proof_data[current_position]);
 }
 
 //Sets the goal statement of this proof.
 void Proof::setGoal(const char* goal_string)
 {
-  if(goal != NULL) delete goal;
-  goal = new StatementTree(goal_string);
+  StatementTree::release(goal);
+  goal = StatementTree::create(goal_string);
 }
 
+//Sets the goal statement of this proof from the given length of a string.
+void Proof::setGoal(const char* goal_string, int length)
+{
+  StatementTree::release(goal);
+  goal = StatementTree::create(goal_string, length);
+}
+
+//Sets the goal statement of this proof to a tree that's already been built.
+void Proof::setGoal(StatementTree& goal_tree)
+{
+  StatementTree* old_goal = goal;
+  goal = StatementTree::create(goal_tree);
+  StatementTree::release(old_goal);
+}
+
+StatementTree* Proof::getGoal()
+{ return goal; }
+
 //Adds a new proof line after the focused one (or after the premises
 //if focus is on a premise line) and sets focus to the new line. This
 //line will be in the same subproof as the previously focused line.
@@ -60,7 +225,7 @@ void Proof::addLine()
   if(current_position < last_premise) current_position = last_premise;
   
   //Create the statement and put it in the correct subproof
-  ProofStatement* new_statement = new ProofStatement("");
+  ProofStatement* new_statement = new (arena) ProofStatement("");
   if(current_position >= 0 && current_position < (int)proof_data.size())
     new_statement->setParent(proof_data[current_position]->getParent());
   
@@ -68,6 +233,8 @@ void Proof::addLine()
   proof_list::iterator ins_pos = getLineInsertionIterator();
   proof_data.insert(ins_pos, new_statement);
   current_position++;
+  lineAdded(current_position);
+  markChanged(new_statement);
 }
 
 //Adds a premise line after the focused line (or at the end of the premises
@@ -78,7 +245,7 @@ void Proof::addPremiseLine()
 	if (current_position > last_premise) current_position = last_premise;
 
     //Create the statement and apply the premise Assumption justification
-	ProofStatement* new_premise = new ProofStatement("");
+	ProofStatement* new_premise = new (arena) ProofStatement("");
 	new_premise->setJustification(&premise_just);
 
     //Insert into the proof, update the index to the last premise
@@ -86,6 +253,8 @@ void Proof::addPremiseLine()
 	proof_data.insert(ins_pos, new_premise);
 	current_position++;
 	last_premise++;
+	lineAdded(current_position);
+	markChanged(new_premise);
 }
 
 //Adds a new subproof assumption line (creating a new subproof). Will
@@ -99,7 +268,7 @@ void Proof::addSubproofLine()
   //Premises before derivation
 	if (current_position < last_premise) current_position = last_premise;
 
-	SubProof* new_proof = new SubProof("");
+	SubProof* new_proof = new (arena) SubProof("", arena);
 
     //Create the subproof and put it into a parent subproof (if relevant)
 	if (current_position >= 0 && current_position < (int)proof_data.size())
@@ -116,6 +285,8 @@ void Proof::addSubproofLine()
 	proof_list::iterator ins_pos = getLineInsertionIterator();
 	proof_data.insert(ins_pos, new_proof->getAssumptionStatement());
 	current_position++;
+	lineAdded(current_position);
+	markChanged(new_proof->getAssumptionStatement());
 }
 
 //Adds a new proof line as per AddLine, except that it will be in the current
@@ -131,6 +302,49 @@ void Proof::endSubproof()
 	ProofStatement* new_parent = proof_data[current_position]->getParent();
 	new_parent = new_parent->getParent();
 	proof_data[current_position]->setParent(new_parent);
+	lineAdded(current_position); //Numbering it again closes the subproof it left
+	markChanged(proof_data[current_position]);
+}
+
+//Finds the subproof the line goes in by walking out from the last line, so
+//only the subproofs being left are looked at.
+bool Proof::appendLine(line_type_t line_type, int depth, StatementTree& statement)
+{
+  ProofStatement* last = proof_data.empty() ? NULL : proof_data.back();
+  if(line_type == PREMISE_LINE && (depth != 0 || last_premise != (int)proof_data.size()-1))
+    return false;
+  
+  //The new line (or the subproof it starts) is in this many subproofs
+  int enclosing_depth = (line_type == ASSUMPTION_LINE) ? depth-1 : depth;
+  ProofStatement* enclosing = (last == NULL) ? NULL : last->getParent();
+  while(enclosing != NULL && enclosing->getDepth() >= enclosing_depth)
+    enclosing = enclosing->getParent();
+  if(enclosing_depth < 0 || ((enclosing == NULL) ? 0 : enclosing->getDepth()+1) != enclosing_depth)
+    return false;
+  
+  ProofStatement* new_line;
+  if(line_type == ASSUMPTION_LINE)
+  {
+    SubProof* new_proof = new (arena) SubProof(&statement, arena);
+    new_proof->setParent(enclosing);
+    new_line = new_proof->getAssumptionStatement();
+  }
+  else
+  {
+    new_line = new (arena) ProofStatement(&statement);
+    new_line->setParent(enclosing);
+    if(line_type == PREMISE_LINE)
+    {
+      new_line->setJustification(&premise_just);
+      last_premise++;
+    }
+  }
+  
+  proof_data.push_back(new_line);
+  current_position = proof_data.size()-1;
+  lineAdded(current_position);
+  markChanged(new_line);
+  return true;
 }
 
 //Get an iterator to insert a line after the currently focused line.
@@ -158,9 +372,34 @@ void Proof::setJustification(const char* justification_name)
 {
   if(current_position <= last_premise) return; //Don't change justification for premises
   
-  Justification* justification_rule = ProofRules::findRule(justification_name);
+  Justification* justification_rule = findRule(justification_name);
   if(justification_rule != NULL)
+  {
     proof_data[current_position]->setJustification(justification_rule);
+    if(track_changes) changed_lines.insert(proof_data[current_position]);
+  }
+}
+
+//As above, with the rule name given as the first length characters of a string.
+void Proof::setJustification(const char* justification_name, int length)
+{
+  if(current_position <= last_premise) return;
+  
+  Justification* justification_rule = findRule(justification_name, length);
+  if(justification_rule != NULL)
+  {
+    proof_data[current_position]->setJustification(justification_rule);
+    if(track_changes) changed_lines.insert(proof_data[current_position]);
+  }
+}
+
+//As above, for a rule that's already been looked up.
+void Proof::setJustification(Justification* justification_rule)
+{
+  if(current_position <= last_premise || justification_rule == NULL) return;
+  
+  proof_data[current_position]->setJustification(justification_rule);
+  if(track_changes) changed_lines.insert(proof_data[current_position]);
 }
 
 //Toggles whether or not the specified line is listed as an antecedent of the
@@ -172,7 +411,12 @@ void Proof::toggleAntecedent(int antecedent_index)
 	if (current_position <= last_premise || antecedent_index >= current_position) return; //Current line is a premise, or proposed antecedent is after current line
     if (proof_data[current_position]->isAssumption()) return; //Current line is a subproof assumption
 
-	proof_data[current_position]->toggleAntecedent(proof_data[antecedent_index]);
+	updateScopes();
+	ProofStatement* line = proof_data[current_position];
+	linkAntecedents(line, false);
+	line->toggleAntecedent(proof_data[antecedent_index]);
+	linkAntecedents(line, true);
+	if(track_changes) changed_lines.insert(line);
 }
 
 //Removes the focused line and decrements the focus.
@@ -183,75 +427,151 @@ void Proof::removeLine()
   if(current_position <= last_premise) last_premise--;
   
   proof_list::iterator pos = proof_data.begin()+current_position;
+  proof_list::iterator epos = pos+1;
   if((*pos)->isAssumption())
   {
-    proof_list::iterator epos = pos;
-    for(; epos != proof_data.end(), (*epos)->getParent() == (*pos)->getParent(); epos++);
-    proof_data.erase(pos, epos);
+    epos = pos;
+    for(; epos != proof_data.end() && (*epos)->getParent() == (*pos)->getParent(); epos++);
   }
-  else
-    proof_data.erase(pos);
+  
+  //Lines using the removed ones can't be relied on any more
+  for(proof_list::iterator itr = pos; itr != epos; itr++)
+  {
+    markChanged(*itr);
+    linkAntecedents(*itr, false);
+  }
+  proof_data.erase(pos, epos);
   current_position--;
+  scopes_current = false;
 }
 
-//The following two functions should be moved out of this class; they're left over from when the 
-//justification_map was a member of Proof.
+//Lemma rules are kept in the proof which added them.
 bool Proof::addEquivalenceRule(const char* form1, const char* form2, const char* name)
 {
-  if(ProofRules::findRule(name) != NULL) return false; //A rule by that name already exists
+  if(name == NULL || strcmp(name, "") == 0) return false;
+  if(findRule(name) != NULL) return false; //A rule by that name already exists
   
   EquivalenceRule* added_equivalence = new EquivalenceRule(name);
   added_equivalence->addEquivalentPair(form1, form2);
   
-  ProofRules::addRule(added_equivalence);
+  lemma_rules[string(name)] = added_equivalence;
   return true;
 }
 
 bool Proof::addInferenceRule(const std::vector<char*>& antecedents, const char* goal, const char* name)
 {
-  if(ProofRules::findRule(name) != NULL) return false; //A rule by that name already exists
+  if(name == NULL || strcmp(name, "") == 0) return false;
+  if(findRule(name) != NULL) return false; //A rule by that name already exists
   
   InferenceRule* added_inference = new InferenceRule(goal, name);
   for(unsigned int i = 0; i < antecedents.size(); i++)
     added_inference->addRequiredForm(antecedents[i]);
   
-  ProofRules::addRule(added_inference);
+  lemma_rules[string(name)] = added_inference;
   return true;
 }
 
 //Checks and prints if the proof works. Note again that a proof that ends in a subproof will fail.
-bool Proof::verifyProof()
+bool Proof::verifyProof(WorkPool* pool)
+{
+  if(goal_precheck && goalUnreachable())
+  {
+    *out << "Goal does not follow from the premises\n";
+    *out << "Lines were not checked; run without -g to see which lines are not justified\n";
+    return false;
+  }
+
+  //Lines are all checked first, so the output is in order however they were checked
+  vector<char> justified;
+  checkLines(justified, pool, false);
+  return reportResults(justified);
+}
+
+void Proof::setGoalPrecheck(bool enabled)
+{ goal_precheck = enabled; }
+
+//Looks for an assignment making every premise true and the goal false.
+bool Proof::goalUnreachable()
+{
+  if(goal == NULL || !goal->isValid()) return false;
+  SatEncoder encoder;
+  vector<int> premises;
+  for(int i = 0; i <= last_premise; i++)
+  {
+    StatementTree* premise = proof_data[i]->getStatementData();
+    if(premise == NULL || !premise->isValid()) return false;
+    premises.push_back(encoder.addSentence(premise));
+  }
+  int conclusion = encoder.addSentence(goal);
+  return encoder.entails(premises, conclusion) == SatEncoder::NOT_ENTAILED;
+}
+
+//Same as verifyProof, except that lines which haven't changed aren't checked.
+bool Proof::verifyChanges(WorkPool* pool)
+{
+  vector<char> justified;
+  checkLines(justified, pool, true);
+  return reportResults(justified);
+}
+
+//Prints the lines which failed, then whether the goal was found.
+bool Proof::reportResults(vector<char>& justified)
 {
   bool failed = false;
+  for(unsigned int i = 0; i < proof_data.size(); i++)
+  {
+    //Report each line
+    if(!justified[i])
+    {
+      reportLineFailure(proof_data[i], i+1);
+      failed = true;
+    }
+  }
+  return reportSummary(failed);
+}
+
+int Proof::lineCount()
+{ return proof_data.size(); }
+
+int Proof::premiseCount()
+{ return last_premise+1; }
+
+ProofStatement* Proof::getLine(int index)
+{ return proof_data[index]; }
+
+//Prints the reason a line that was checked is not justified.
+void Proof::reportLineFailure(ProofStatement* line, int line_number)
+{
+  *out << "Line " << line_number << " is not justified: ";
+  switch(line->getFailureType())
+  {
+    case ProofStatement::INVALID_STATEMENT:
+      *out << "sentence is not well-formed\n";
+      break;
+    case ProofStatement::NO_JUSTIFICATION:
+      *out << "no inference/equivalence rule specified\n";
+      break;
+    case ProofStatement::JUSTIFICATION_FAILURE:
+      *out << "rule could not be applied\n";
+      break;
+    default: *out << "unspecified failure\n";
+      break;
+  }
+}
+
+//Prints whether all lines checked out, then searches for the goal.
+bool Proof::reportSummary(bool lines_failed)
+{
+  bool failed = lines_failed;
   //int goal_index = (goal==NULL)?0:-1; //Only check that the goal was found if there is a goal
   int goal_index = -1;
   bool has_goal = goal != NULL;
 
   for(unsigned int i = 0; i < proof_data.size(); i++)
   {
-    //Check each line
-    if(!proof_data[i]->isJustified())
-    {
-      //Line is not justified, print the reason why
-      cout << "Line " << (i+1) << " is not justified: ";
-      switch(proof_data[i]->getFailureType())
-      {
-        case ProofStatement::INVALID_STATEMENT:
-          cout << "sentence is not well-formed\n";
-          break;
-        case ProofStatement::NO_JUSTIFICATION:
-          cout << "no inference/equivalence rule specified\n";
-          break;
-        case ProofStatement::JUSTIFICATION_FAILURE:
-          cout << "rule could not be applied\n";
-          break;
-        default: cout << "unspecified failure\n";
-          break;
-      }
-      
-      failed = true;
-    }
+    //In low memory mode, released lines are replaced by a subproof, with no statement
     if(has_goal && goal_index == -1 && proof_data[i]->getParent()==NULL &&
+      proof_data[i]->getStatementData() != NULL &&
       proof_data[i]->getStatementData()->equals(*goal))
     {
       //The proof has a goal, and the current line matches it and is not in
@@ -265,19 +585,138 @@ bool Proof::verifyProof()
   }
 
   //Print the results of verification
-  if(!failed) cout << "All lines check out\n";
+  if(!failed) *out << "All lines check out\n";
   if(has_goal)
   {
     if(goal_index == -1)
     {
-      cout << "Goal not found\n";
+      *out << "Goal not found\n";
       failed = true;
     }
-    else cout << "Goal found at line " << (goal_index+1) << "\n";
+    else *out << "Goal found at line " << (goal_index+1) << "\n";
   }
   return !failed;
 }
 
+//Checks the lines, on the pool's threads if there's a pool with more than one.
+//A line's failure type is only NO_FAILURE if its last check passed, so lines
+//that aren't checked again are taken from that.
+void Proof::checkLines(vector<char>& justified, WorkPool* pool, bool changed_only)
+{
+  justified.assign(proof_data.size(), 0);
+  vector<int> to_check;
+  for(unsigned int i = 0; i < proof_data.size(); i++)
+  {
+    if(!changed_only || !track_changes || changed_lines.count(proof_data[i]) > 0)
+      to_check.push_back(i);
+    else
+      justified[i] = proof_data[i]->getFailureType() == ProofStatement::NO_FAILURE;
+  }
+  changed_lines.clear();
+  if(!track_changes && !low_memory)
+  {
+    //Every line is being checked, so start keeping track of edits from here
+    track_changes = true;
+    for(unsigned int i = 0; i < proof_data.size(); i++)
+      linkAntecedents(proof_data[i], true);
+  }
+  
+  if(pool == NULL || pool->threadCount() <= 1)
+  {
+    for(unsigned int i = 0; i < to_check.size(); i++)
+      justified[to_check[i]] = proof_data[to_check[i]]->isJustified(cache);
+    return;
+  }
+  
+  LineCheckTask task(proof_data, to_check, justified, cache);
+  pool->run(task, to_check.size());
+}
+
+//Keeps a stack of the subproofs the last numbered line is in, so each line
+//only needs to look at the subproofs it starts or leaves.
+void Proof::addScope(int index)
+{
+  ProofStatement* line = proof_data[index];
+  line->setScope(index, index);
+  
+  //Find the innermost subproof of this line that's already open. Depth is the
+  //position of a subproof in the stack.
+  vector<ProofStatement*> opened;
+  ProofStatement* enclosing = line->getParent();
+  while(enclosing != NULL && !(enclosing->getDepth() < (int)open_scopes.size() &&
+    open_scopes[enclosing->getDepth()] == enclosing))
+  {
+    opened.push_back(enclosing);
+    enclosing = enclosing->getParent();
+  }
+  
+  //Any other open subproofs ended at the previous line. In low memory mode,
+  //closing them while numbering new lines (rather than renumbering in
+  //updateScopes) lines them up to be released, innermost first.
+  unsigned int still_open = (enclosing == NULL)?0:(enclosing->getDepth()+1);
+  for(unsigned int i = open_scopes.size(); i > still_open; i--)
+  {
+    open_scopes[i-1]->setScope(open_scopes[i-1]->getScopeOpen(), index-1);
+    if(low_memory && scopes_current) closed_subproofs.push_back(open_scopes[i-1]);
+  }
+  open_scopes.resize(still_open);
+  
+  //Subproofs this line starts are open until a line outside them is numbered.
+  //A subproof normally starts at its assumption. If it's started anywhere else,
+  //its lines aren't all together and it can't have an interval.
+  for(int i = opened.size()-1; i >= 0; i--)
+  {
+    if(opened[i] == line->getParent() && line->isAssumption())
+      opened[i]->setScope(index, INT_MAX);
+    else
+      opened[i]->setScope(-1, -1);
+    open_scopes.push_back(opened[i]);
+  }
+}
+
+void Proof::updateScopes()
+{
+  if(scopes_current) return;
+  open_scopes.clear();
+  for(unsigned int i = 0; i < proof_data.size(); i++)
+    addScope(i);
+  scopes_current = true;
+}
+
+void Proof::lineAdded(int index)
+{
+  if(scopes_current && index == (int)proof_data.size()-1)
+    addScope(index);
+  else
+    scopes_current = false;
+}
+
+//The line itself, then the lines using it or any subproof it's in.
+void Proof::markChanged(ProofStatement* line)
+{
+  if(!track_changes) return;
+  changed_lines.insert(line);
+  for(ProofStatement* source = line; source != NULL; source = source->getParent())
+  {
+    dependency_map::iterator found = dependents.find(source);
+    if(found != dependents.end())
+      changed_lines.insert(found->second.begin(), found->second.end());
+  }
+}
+
+void Proof::linkAntecedents(ProofStatement* line, bool link)
+{
+  if(!track_changes) return;
+  const antecedent_list& antecedents = line->getAntecedents();
+  for(antecedent_list::const_iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+  {
+    if(link)
+      dependents[*itr].insert(line);
+    else
+      dependents[*itr].erase(line);
+  }
+}
+
 //Displays the proof.
 void Proof::printProof()
 {
@@ -289,7 +728,7 @@ void Proof::printProof()
   int index = 0;
   for(; index <= last_premise; index++)
     printProofLine(index);
-  cout << "   ]---\n";
+  *out << "   ]---\n";
   
   //Print the lines of the proof
   for(; index < (int)proof_data.size(); index++)
@@ -299,7 +738,7 @@ void Proof::printProof()
   if(goal != NULL)
   {
     char* goal_disp = goal->createDisplayString();
-    cout << "Goal: " << goal_disp << "\n";
+    *out << "Goal: " << goal_disp << "\n";
     delete [] goal_disp;
   }
 }
@@ -307,36 +746,34 @@ void Proof::printProof()
 void Proof::printProofLine(int index)
 {
   //Determine how far to indent the line, i.e. how many subproofs it's in
-  int depth = 0; //Is inefficient, change later (pass depth as parameter?)
-  ProofStatement* traveller = proof_data[index]->getParent();
-  for(; traveller != NULL; depth++, traveller = traveller->getParent());
+  int depth = proof_data[index]->getDepth();
   
   if(proof_data[index]->isAssumption() && index > last_premise)
   {
     //This is a subproof assumption, print an empty line before it
-    cout << "   ";
+    *out << "   ";
     for(int i = 0; i <= depth-1; i++)
-      cout << ']';
-    cout << "\n";
+      *out << ']';
+    *out << "\n";
   }
   
   //Print the line number and indent
-  cout << (index+1) << ((index < 99)?((index < 9)?"  ":" "):""); //TODO: more robust formatting for this
+  *out << (index+1) << ((index < 99)?((index < 9)?"  ":" "):""); //TODO: more robust formatting for this
   for(int i = 0; i <= depth; i++)
-    cout << ']';
+    *out << ']';
     
   //Print the line
   char* display_string = proof_data[index]->createDisplayString();
-  cout << " " << display_string << "\n";
+  *out << " " << display_string << "\n";
   delete [] display_string;
   
   if(proof_data[index]->isAssumption() && index > last_premise)
   {
     //This is a subproof assumption, print a separator after it
-    cout << "   ";
+    *out << "   ";
     for(int i = 0; i <= depth; i++)
-      cout << ']';
-    cout << "---\n";
+      *out << ']';
+    *out << "---\n";
   }
 }
 
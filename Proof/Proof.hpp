@@ -8,16 +8,26 @@
 #include "InferenceRules.hpp"
 #include "EquivalenceRules.hpp"
 #include "AggregateJustification.hpp"
+#include "WorkPool.hpp"
+#include "ProofRules.hpp"
+#include "VerificationCache.hpp"
 #include <cstring>
+#include <iostream>
 #include <map>
 #include <vector>
 #include <string>
+#include <unordered_map>
 
 /// <summary>
 /// For the list of lines in the proof.
 /// </summary>
 typedef std::vector<ProofStatement*> proof_list;
 
+/// <summary>
+/// For each line or subproof used as an antecedent, the lines that list it as one.
+/// </summary>
+typedef std::map<ProofStatement*, statement_set> dependency_map;
+
 /// <summary>
 /// Stores a proof, consisting of a list of ProofStatements for the lines in the proof. SubProof
 /// instances are not directly included in this list, just the lines within them.
@@ -31,13 +41,114 @@ class Proof
   private:
   int current_position;
   int last_premise;
+  ProofArena arena; //Owns every line of the proof, including subproofs
   proof_list proof_data;
   Assumption premise_just;
   StatementTree* goal;
+  justification_map lemma_rules; //Rules added by lemmas in this proof
+  Proof* enclosing_proof; //For a lemma proof, the proof using the lemma
+  std::ostream* out;
+  VerificationCache* cache;
+  dependency_map dependents;
+  statement_set changed_lines; //Lines to check again in verifyChanges
+  bool track_changes; //Whether edits are recorded for verifyChanges; not until lines are first checked
+  std::vector<ProofStatement*> open_scopes; //Subproofs containing the last numbered line, by depth
+  bool scopes_current; //Whether every line's scope interval is up to date
+  bool low_memory; //See setLowMemory
+  std::vector<ProofStatement*> closed_subproofs; //Closed but not released yet, in low memory mode
+  int released_lines; //Lines before this have had their antecedents cleared, in low memory mode
+  std::unordered_map<unsigned long long, Justification*> found_rules; //By name hash, for findRule with a length
+  static bool goal_precheck; //See setGoalPrecheck
   
   public:
+  /// <summary>
+  /// Kinds of line for appendLine.
+  /// </summary>
+  enum line_type_t { PREMISE_LINE, ASSUMPTION_LINE, DERIVED_LINE };
+
   Proof();
   ~Proof();
+
+  /// <summary>
+  /// Sets where printProof and verifyProof write to. Defaults to the console.
+  /// </summary>
+  /// <param name="output">Stream to write to</param>
+  void setOutput(std::ostream& output);
+
+  /// <summary>
+  /// Makes this a lemma proof read for another proof. It can use any lemma rules the other
+  /// proof had added so far, and uses the same verification cache.
+  /// </summary>
+  /// <param name="enclosing">Proof the lemma is for</param>
+  void setEnclosingProof(Proof* enclosing);
+
+  /// <summary>
+  /// Sets a cache of results from checking lines, which verifyProof will look lines up in
+  /// and add new results to. Null (the default) for no cache.
+  /// </summary>
+  /// <param name="line_cache">Cache to use. Isn't owned by the proof.</param>
+  void setCache(VerificationCache* line_cache);
+
+  /// <summary>
+  /// Sets whether verifyProof first checks that the goal follows from the premises at all,
+  /// using a SatEncoder. If it doesn't, no proof of it can be correct, so that's reported
+  /// instead of checking any lines, along with a note that the lines were skipped. If the SAT
+  /// solver gives up, lines are checked as usual.
+  /// Off by default, and applies to every proof.
+  ///
+  /// This relies on the rules in use being sound, since a proof using an unsound rule could
+  /// still check out. verifyChanges and streamed proofs aren't prechecked.
+  /// </summary>
+  /// <param name="enabled">Whether to do the precheck</param>
+  static void setGoalPrecheck(bool enabled);
+
+  /// <summary>
+  /// Turns on low memory mode, for proofs too big to keep all of in memory. Lines are meant to
+  /// be checked as they're added, e.g. by a StreamVerifier, with releaseCheckedLines called as
+  /// they are. Whatever can't be used by a later line is then freed, so memory use depends on
+  /// how much of the proof can still be used as antecedents rather than on its length.
+  ///
+  /// Must be set before any lines are added. Lines may only be added at the end of the proof, as
+  /// a ProofReader does. Released lines can't be printed or checked again, so printProof,
+  /// verifyProof and verifyChanges shouldn't be used, and no dependencies are tracked for
+  /// verifyChanges.
+  /// </summary>
+  /// <param name="enabled">Whether to use low memory mode</param>
+  void setLowMemory(bool enabled);
+
+  /// <summary>
+  /// In low memory mode, frees what's no longer needed once lines have been checked. Checked
+  /// lines drop their antecedent lists. For each subproof which has been closed (i.e. a line
+  /// after it was added), anything in a subproof within it is destroyed, as no later line can
+  /// use it. Later lines can only use the closed subproof itself, and InferenceRule only needs
+  /// its assumption and the lines directly in it for that, so those are kept.
+  ///
+  /// Line numbers of destroyed lines are kept pointing to the subproof they were in, since that
+  /// subproof is what a later line citing them would actually use (see
+  /// ProofStatement::toggleAntecedent).
+  /// </summary>
+  /// <param name="checked_lines">
+  ///   Number of lines at the start of the proof which have been checked.
+  /// </param>
+  void releaseCheckedLines(int checked_lines);
+
+  /// <summary>
+  /// Finds a justification rule usable in this proof: a lemma rule added by this proof or one
+  /// enclosing it, or else a rule from ProofRules.
+  /// </summary>
+  /// <param name="rule_name">Name of the rule</param>
+  /// <returns>The rule, or null if there's no rule by that name</returns>
+  Justification* findRule(const char* rule_name);
+
+  /// <summary>
+  /// Finds a justification rule as per findRule, given the first length characters of a string
+  /// as the name. Rules that have been found before are remembered by a hash of their name, so
+  /// looking them up again doesn't need to copy the name.
+  /// </summary>
+  /// <param name="rule_name">Name of the rule. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the name</param>
+  /// <returns>The rule, or null if there's no rule by that name</returns>
+  Justification* findRule(const char* rule_name, int length);
   
   /// <summary>
   /// Set which line of the proof has focus. Position is zero-indexed for all lines of the proof,
@@ -59,6 +170,14 @@ class Proof
   /// </param>
   void setStatement(const char* statement_string);
 
+  /// <summary>
+  /// Set the sentence on the currently focused line, as per setStatement, from the first length
+  /// characters of a string.
+  /// </summary>
+  /// <param name="statement_string">Sentence to put on this line. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the sentence</param>
+  void setStatement(const char* statement_string, int length);
+
   /// <summary>
   /// Sets the goal of the proof. The proof is successful if every line is justified and there is
   /// a derived line (which is not within a subproof) which matches the goal.
@@ -67,6 +186,25 @@ class Proof
   ///   Sentence for the goal of the proof. Will be parsed into a syntax tree.
   /// </param>
   void setGoal(const char* goal_string);
+
+  /// <summary>
+  /// Sets the goal of the proof, as per setGoal, from the first length characters of a string.
+  /// </summary>
+  /// <param name="goal_string">Sentence for the goal. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the sentence</param>
+  void setGoal(const char* goal_string, int length);
+
+  /// <summary>
+  /// Sets the goal of the proof, as per setGoal, to an existing tree.
+  /// </summary>
+  /// <param name="goal_tree">Sentence for the goal. The proof takes its own reference.</param>
+  void setGoal(StatementTree& goal_tree);
+
+  /// <summary>
+  /// Gets the goal of the proof.
+  /// </summary>
+  /// <returns>Goal sentence, or null if no goal is set</returns>
+  StatementTree* getGoal();
   
   /// <summary>
   /// Adds a new line to the proof after the currently focused line. If focus is on -1, this means
@@ -102,6 +240,21 @@ class Proof
   /// </summary>
   void endSubproof();
 
+  /// <summary>
+  /// Adds a line to the end of the proof, placed by the number of subproofs it's in rather than
+  /// relative to the focused line. For building a proof whose structure is already known, such
+  /// as from a binary proof file. The line goes in the subproofs the last line is in, up to the
+  /// given depth. An assumption line starts a new subproof, at that depth, within them. Premises
+  /// must come before any other lines. Focus moves to the new line.
+  /// </summary>
+  /// <param name="line_type">Kind of line to add</param>
+  /// <param name="depth">
+  ///   Number of subproofs the line is in. For an assumption this includes the subproof it starts.
+  /// </param>
+  /// <param name="statement">Sentence of the line</param>
+  /// <returns>False if the line can't be added there, in which case nothing is added</returns>
+  bool appendLine(line_type_t line_type, int depth, StatementTree& statement);
+
   /// <summary>
   /// Removes the currently focused line. If that line is the assumption of a subproof, will
   /// remove all the contents of that subproof as well.
@@ -118,6 +271,21 @@ class Proof
   /// </param>
   void setJustification(const char* justification_name);
 
+  /// <summary>
+  /// Sets the justification on the currently focused line, as per setJustification, from the
+  /// first length characters of a string.
+  /// </summary>
+  /// <param name="justification_name">Name of the rule. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the name</param>
+  void setJustification(const char* justification_name, int length);
+
+  /// <summary>
+  /// Sets the justification on the currently focused line to a rule that's already been found,
+  /// as per setJustification. Does nothing for a null rule.
+  /// </summary>
+  /// <param name="justification_rule">Rule to justify the line with</param>
+  void setJustification(Justification* justification_rule);
+
   /// <summary>
   /// Toggles whether a given line is an antecedent of the currently focused line. If the focused
   /// line is a premise or assumption, or focus is before the first line, does nothing. Also does
@@ -129,8 +297,9 @@ class Proof
   void toggleAntecedent(int antecedent_index);
 
   /// <summary>
-  /// Adds an equivalence rule to the list of justifications usable in this proof.
-  /// TODO: Maybe shouldn't be in Proof.
+  /// Adds an equivalence rule to the list of justifications usable in this proof. Lemma rules
+  /// belong to the proof rather than being added to ProofRules, so that proofs read at the same
+  /// time don't see each other's lemmas.
   /// </summary>
   /// <param name="form1">First equivalent form</param>
   /// <param name="form2">Second equivalent form</param>
@@ -139,8 +308,8 @@ class Proof
   bool addEquivalenceRule(const char* form1, const char* form2, const char* name);
 
   /// <summary>
-  /// Adds an inference rule to the list of justifications usable in this proof..
-  /// TODO: Maybe shouldn't be in Proof.
+  /// Adds an inference rule to the list of justifications usable in this proof. As with
+  /// addEquivalenceRule, the rule belongs to this proof.
   /// </summary>
   /// <param name="antecedents">List of required antecedent forms</param>
   /// <param name="goal">Consequent form</param>
@@ -154,13 +323,29 @@ class Proof
   /// <summary>
   /// Checks whether the proof is successful, which means all lines are well-formed and justified.
   /// If a goal is set, also means there is a derived line containing the goal (not in a subproof).
-  /// If verification is not successful, prints the reason(s) it failed to the console.
+  /// If verification is not successful, prints the reason(s) it failed to the output.
+  ///
+  /// Lines are checked independently of each other, so with a pool they're checked in parallel.
+  /// The results are still printed in line order, the same as when checked sequentially.
   /// </summary>
+  /// <param name="pool">Threads to check lines on. If null, lines are checked in sequence.</param>
   /// <returns>True if verification succeeded</returns>
-  bool verifyProof();
+  bool verifyProof(WorkPool* pool = NULL);
 
   /// <summary>
-  /// Prints the proof to the console.
+  /// Verifies the proof as per verifyProof, but only checks the lines that could have a
+  /// different result since the proof was last verified: lines that were added or edited, and
+  /// lines using an edited line (or a subproof containing one) as an antecedent. Other lines
+  /// keep the result of their last check. Output is the same as verifyProof's.
+  ///
+  /// Meant for checking a proof again after each edit, when only a few lines change.
+  /// </summary>
+  /// <param name="pool">Threads to check lines on. If null, lines are checked in sequence.</param>
+  /// <returns>True if verification succeeded</returns>
+  bool verifyChanges(WorkPool* pool = NULL);
+
+  /// <summary>
+  /// Prints the proof to the output.
   /// </summary>
   void printProof();
 
@@ -178,9 +363,123 @@ class Proof
   ///   For each premise line of the proof, contains the sentence of its statement.
   /// </param>
   void createPremiseStrings(std::vector<char*>& premise_strings);
+
+  /// <summary>
+  /// Number of lines in the proof, including premises and subproof assumptions.
+  /// </summary>
+  /// <returns>Number of lines</returns>
+  int lineCount();
+
+  /// <summary>
+  /// Number of premise lines, which are always the first lines of the proof.
+  /// </summary>
+  /// <returns>Number of premises</returns>
+  int premiseCount();
+
+  /// <summary>
+  /// Gets a line of the proof by index.
+  /// </summary>
+  /// <param name="index">Line index, in range 0 to lineCount()-1</param>
+  /// <returns>The line</returns>
+  ProofStatement* getLine(int index);
+
+  /// <summary>
+  /// Prints why a line is not justified, based on its failure type from when it was last
+  /// checked. Only reads the given line, so it can be used while other lines are being added.
+  /// </summary>
+  /// <param name="line">Line that failed its check</param>
+  /// <param name="line_number">Number to print for the line (its index + 1)</param>
+  void reportLineFailure(ProofStatement* line, int line_number);
+
+  /// <summary>
+  /// Prints the end of a verification: whether all lines checked out, and whether the goal was
+  /// found if there is one.
+  /// </summary>
+  /// <param name="lines_failed">Whether any line failed its check</param>
+  /// <returns>True if verification succeeded</returns>
+  bool reportSummary(bool lines_failed);
   
   private:
 
+  /// <summary>
+  /// Helper for verifyProof. Checks whether each line is justified, without printing anything.
+  /// </summary>
+  /// <param name="justified">Set to whether each line is justified, by line index</param>
+  /// <param name="pool">Threads to check lines on. If null, lines are checked in sequence.</param>
+  /// <param name="changed_only">
+  ///   If true, only lines in changed_lines are checked. The others keep the result of their
+  ///   last check.
+  /// </param>
+  void checkLines(std::vector<char>& justified, WorkPool* pool, bool changed_only);
+
+  /// <summary>
+  /// Helper for verifyProof, for the goal precheck (see setGoalPrecheck).
+  /// </summary>
+  /// <returns>
+  ///   True if there's a goal and it definitely doesn't follow from the premises. False if it
+  ///   does, if that couldn't be decided, or if the goal or a premise isn't well-formed.
+  /// </returns>
+  bool goalUnreachable();
+
+  /// <summary>
+  /// Helper for verifyProof, prints which lines aren't justified and whether the goal was
+  /// found.
+  /// </summary>
+  /// <param name="justified">Whether each line is justified, by line index</param>
+  /// <returns>True if verification succeeded</returns>
+  bool reportResults(std::vector<char>& justified);
+
+  /// <summary>
+  /// Marks a line to be checked again by verifyChanges, along with every line whose check
+  /// depends on it: lines using it as an antecedent, and lines using any subproof it's in.
+  /// </summary>
+  /// <param name="line">Line that was edited</param>
+  void markChanged(ProofStatement* line);
+
+  /// <summary>
+  /// Adds a line to, or removes it from, the dependents of each of its antecedents.
+  /// </summary>
+  /// <param name="line">Line whose antecedents to update the dependency graph for</param>
+  /// <param name="link">True to add the line, false to remove it</param>
+  void linkAntecedents(ProofStatement* line, bool link);
+
+  /// <summary>
+  /// Sets the scope interval (see ProofStatement::setScope) of a line, numbering it by its
+  /// index, and of the subproofs it starts. Lines must be numbered in order. Subproofs that
+  /// the line is not in are closed at the previous line; the rest are left open, as later lines
+  /// may still be added to them.
+  ///
+  /// Lines added to the end of the proof are numbered as they're added. Any other change to the
+  /// structure of the proof means renumbering the lot with updateScopes.
+  /// </summary>
+  /// <param name="index">Line index to number. Must be one after the last line numbered.</param>
+  void addScope(int index);
+
+  /// <summary>
+  /// Renumbers the scope intervals of every line, if they aren't up to date.
+  /// </summary>
+  void updateScopes();
+
+  /// <summary>
+  /// Helper for releaseCheckedLines. Destroys a subproof, along with every line and subproof
+  /// in it. The index of each line in it is given to a replacement instead.
+  /// </summary>
+  /// <param name="subproof">
+  ///   Subproof to destroy, which must have no parent and a scope interval
+  /// </param>
+  /// <param name="replacement">
+  ///   Subproof which the destroyed one was in. Null when destroying a subproof within one
+  ///   that's being released, whose lines have been given to the replacement already.
+  /// </param>
+  void releaseSubproof(ProofStatement* subproof, ProofStatement* replacement);
+
+  /// <summary>
+  /// Keeps scope intervals up to date after a line is added: numbers it if it's the last line,
+  /// otherwise marks the intervals to be renumbered.
+  /// </summary>
+  /// <param name="index">Line index of the new line</param>
+  void lineAdded(int index);
+
   /// <summary>
   /// Helper for printProof, prints one line of the proof. Indents the line based on how many
   /// levels of subproof it's in, then prints that line's display string.
@@ -1,4 +1,6 @@
 #include "ProofReader.hpp"
+#include "BinaryProof.hpp"
+#include <cctype>
 #include <cstdlib>
 #include <utility>
 
@@ -18,193 +20,234 @@ void ProofReader::setTarget(Proof* new_target)
   target = new_target;
   new_line_needed = true; //When ending a subproof, an empty new line is added, so the next line read will use that instead of creating a new one.
   derivation_started = false;
+  finished = false;
+  line_number_offset = 0;
+  line_number_translation.clear();
+  lemma_lines.clear();
   //TODO: Clear any existing data in new_target?
 }
 
+void ProofReader::setOutput(std::ostream& output, std::ostream& errors)
+{
+  out = &output;
+  err = &errors;
+}
+
 //Reads the file with the given name to the proof object.
 bool ProofReader::readFile(const char* filename)
 {
   line_number_offset = 0;
   line_number_translation.clear();
+  lemma_lines.clear();
+  finished = false;
   
   //Open the file
   if(target == NULL)
   {
-    cerr << "Error: no proof to read file " << filename << "into \n";
+    *err << "Error: no proof to read file " << filename << "into \n";
     return false;
   }
-  reader.open(filename);
-  if(!reader.is_open())
+  MappedFile file;
+  if(!file.open(filename))
+  {
+    *err << "Error: file " << filename << " could not be opened\n";
+    return false;
+  }
+  
+  if(BinaryProof::isBinary(file.data(), file.size()))
+  {
+    BinaryProof binary;
+    binary.setOutput(*out, *err);
+    binary.setTarget(target);
+    return binary.read(filename, file.data(), file.size(), *this);
+  }
+  
+  //Walk the file line by line, finding the end of each with memchr
+  const char* file_end = file.data() + file.size();
+  const char* next_line = file.data();
+  while(!finished && next_line < file_end)
+  {
+    const char* line = next_line;
+    const char* line_end = (const char*)memchr(line, '\n', file_end - line);
+    if(line_end == NULL) line_end = file_end; //Last line has no newline
+    next_line = line_end + 1;
+    if(!readLine(filename, line, line_end - line)) return false;
+  }
+  
+  return true;
+}
+
+//Trims the line, then reads the command on it.
+bool ProofReader::readLine(const char* source_name, const char* line, int length)
+{
+  if(finished) return true;
+  if(target == NULL)
   {
-    cerr << "Error: file " << filename << " could not be opened\n";
+    *err << "Error: no proof to read " << source_name << " into\n";
     return false;
   }
   
-  while(!reader.eof())
+  const char* line_end = line + length;
+  if(line_end > line && *(line_end-1) == '\r') line_end--; //DOS File types
+  line = skipLeadingWhitespace(line, line_end); //this pointer moves
+  if(line == line_end)
   {
-    //Read the input file line by line
-    char* temp = readLine();
-    char* line = temp; //this pointer moves
-    while(*line == ' ' || *line == '\t') line++;
-    
-    if(line == NULL)
+    finished = true;
+    return true;
+  }
+  return readCommand(source_name, line, line_end);
+}
+
+bool ProofReader::isFinished()
+{ return finished; }
+
+const vector<string>& ProofReader::getLemmaLines()
+{ return lemma_lines; }
+
+int ProofReader::completeLines()
+{
+  if(target == NULL) return 0;
+  int line_count = target->lineCount();
+  return (new_line_needed || line_count == 0) ? line_count : line_count-1;
+}
+
+//Reads one line of the input, which is passed to the command for it without
+//copying (other than for lemmas).
+bool ProofReader::readCommand(const char* source_name, const char* line, const char* line_end)
+{
+  if(hasCommand(line, line_end, PREMISE_COMMAND))
+  {
+    //Add a premise to the proof. The input file should have all the premises listed
+    //before any derivation starts.
+    if(derivation_started)
     {
-      cerr << "Error: problem reading file " << filename << "\n";
+      *err << "Error: premise after start of derivation in file " << source_name << "\n";
       return false;
     }
-    if(strcmp(line, "") == 0) break;
-    
-    if(strncmp(line, PREMISE_COMMAND, 4) == 0)
-    {
-      //Add a premise to the proof. The input file should have all the premises listed
-      //before any derivation starts.
-      if(derivation_started)
-      {
-        cerr << "Error: premise after start of derivation in file " << filename << "\n";
-        return false;
-      }
-      pre(line+3);
-    }
-    else if(strncmp(line, PROOFLINE_COMMAND, 4) == 0)
-    {
-      //Add a line of derivation. If the prior line was in a subproof, this line will
-      //be in the same one.
-      derivation_started = true;
-      if(!lin(line+3))
-      {
-         malformedLine(filename, line);
-         return false;
-      }
-    }
-    else if(strncmp(line, SUBPROOF_COMMAND, 4) == 0)
-    {
-      //Start a new subproof and add its assumption line.
-      derivation_started = true;
-      sub(line+3);
-    }
-    else if(strcmp(line, SUBPROOF_END_COMMAND) == 0)
+    pre(line+3, line_end);
+  }
+  else if(hasCommand(line, line_end, PROOFLINE_COMMAND))
+  {
+    //Add a line of derivation. If the prior line was in a subproof, this line will
+    //be in the same one.
+    derivation_started = true;
+    if(!lin(line+3, line_end))
     {
-      //Create an empty line which is not in the (innermost) subproof that the last line was
-      derivation_started = true;
-      end(line+3);
+       malformedLine(source_name, line, line_end);
+       return false;
     }
-    else if(strncmp(line, GOAL_DEF_COMMAND, 4) == 0)
+  }
+  else if(hasCommand(line, line_end, SUBPROOF_COMMAND))
+  {
+    //Start a new subproof and add its assumption line.
+    derivation_started = true;
+    sub(line+3, line_end);
+  }
+  else if(line_end - line == (int)strlen(SUBPROOF_END_COMMAND) && hasCommand(line, line_end, SUBPROOF_END_COMMAND))
+  {
+    //Create an empty line which is not in the (innermost) subproof that the last line was
+    derivation_started = true;
+    end(line+3, line_end);
+  }
+  else if(hasCommand(line, line_end, GOAL_DEF_COMMAND))
+  {
+    //Define the goal of the proof
+    gol(line+3, line_end);
+  }
+  else if(hasCommand(line, line_end, EQUIVALENCE_LEMMA_COMMAND))
+  {
+    //Add an equivalence rule based on a lemma in the proof
+    line_copy.assign(line, line_end);
+    lemma_lines.push_back(line_copy);
+    if(!equ(&line_copy[3]))
     {
-      //Define the goal of the proof
-      gol(line+3);
+       malformedLine(source_name, line, line_end);
+       return false;
     }
-	else if(strncmp(line, EQUIVALENCE_LEMMA_COMMAND, 4) == 0)
-	{
-      //Add an equivalence rule based on a lemma in the proof
-      if(!equ(line+3))
-      {
-         malformedLine(filename, line);
-         return false;
-      }
-	}
-	else if(strncmp(line, INFERENCE_LEMMA_COMMAND, 4) == 0)
-	{
-      //Add an inference rule based on a lemma in the proof
-      if(!inf(line+3))
-      {
-         malformedLine(filename, line);
-         return false;
-      }
-	}
-    else
+  }
+  else if(hasCommand(line, line_end, INFERENCE_LEMMA_COMMAND))
+  {
+    //Add an inference rule based on a lemma in the proof
+    line_copy.assign(line, line_end);
+    lemma_lines.push_back(line_copy);
+    if(!inf(&line_copy[3]))
     {
-      //Oops
-      cerr << "Error: unrecognized command in line: " << line << " from file " << filename << "\n";
-      return false;
+       malformedLine(source_name, line, line_end);
+       return false;
     }
-    delete [] temp;
   }
-  
-  reader.close();
+  else
+  {
+    //Oops
+    *err << "Error: unrecognized command in line: ";
+    err->write(line, line_end - line);
+    *err << " from file " << source_name << "\n";
+    return false;
+  }
   return true;
 }
 
-//Reads, stores, and returns one line from the input file. Removes a
-//terminating '\r' if present to account for DOS filetypes.
-char* ProofReader::readLine()
+bool ProofReader::hasCommand(const char* line, const char* line_end, const char* command)
 {
-  //Read the line in 50-character chunks into a stringstream
-  linestream.str("");
-  char* temp = new char[50];
-  do
-  {
-    reader.clear();
-    reader.getline(temp, 50);
-    linestream << temp;
-  } while(reader.fail() && !reader.eof() && !reader.bad());
-  delete [] temp;
-  
-  //Extract char* from stringstream, remove terminal carriage return
-  if(reader.fail()) return NULL;
-  string tempstr = linestream.str();
-  temp = new char[tempstr.size()+1];
-  strcpy(temp, tempstr.c_str());
-  if(tempstr.size() > 0 && temp[tempstr.size()-1] == '\r')
-    temp[tempstr.size()-1]='\0'; //DOS File types
-  return temp;
+  int command_length = strlen(command);
+  return line_end - line >= command_length && strncmp(line, command, command_length) == 0;
 }
 
 //Input line was a premise command.
-bool ProofReader::pre(char* input)
+bool ProofReader::pre(const char* input, const char* input_end)
 {
-  input = skipLeadingWhitespace(input);
+  input = skipLeadingWhitespace(input, input_end);
   extendLineNumberTranslation();
   
   target->addPremiseLine();
-  target->setStatement(input);
+  target->setStatement(input, input_end - input);
   return true;
 }
 
 //input command was a line command
-bool ProofReader::lin(char* input)
+bool ProofReader::lin(const char* input, const char* input_end)
 {
-  input = skipLeadingWhitespace(input);
+  const char* position = skipLeadingWhitespace(input, input_end);
   if(new_line_needed)
   {
     target->addLine();
     extendLineNumberTranslation();
   }
   
-  char* temp = strtok(input, ":");
-  if(temp == NULL) return false;
-  target->setStatement(temp);
+  int length;
+  const char* token = nextToken(position, input_end, ':', length);
+  if(token == NULL) return false;
+  target->setStatement(token, length);
   
-  temp = strtok(NULL, ":");
-  if(temp == NULL) return false;
-  target->setJustification(temp);
+  token = nextToken(position, input_end, ':', length);
+  if(token == NULL) return false;
+  target->setJustification(token, length);
   
-  temp = strtok(NULL, " ");
-  while(temp != NULL)
+  while((token = nextToken(position, input_end, ' ', length)) != NULL)
   {
-    int ant = atoi(temp);
+    int ant = readLineNumber(token, length);
     if(ant > 0 && ant <= (int)line_number_translation.size())
-      ant = line_number_translation[ant];
+      ant = line_number_translation[ant-1];
     target->toggleAntecedent(ant);
-    temp = strtok(NULL, " ");
   }
   new_line_needed = true;
   return true;
 }
 
 //Input command was a subproof command
-bool ProofReader::sub(char* input)
+bool ProofReader::sub(const char* input, const char* input_end)
 {
-  input = skipLeadingWhitespace(input);
+  input = skipLeadingWhitespace(input, input_end);
   extendLineNumberTranslation();
   
   target->addSubproofLine();
-  target->setStatement(input);
+  target->setStatement(input, input_end - input);
   new_line_needed = true;
   return true;
 }
 
 //Et cetera
-bool ProofReader::end(char* input)
+bool ProofReader::end(const char*, const char*)
 {
   target->endSubproof();
   new_line_needed = false;
@@ -213,21 +256,77 @@ bool ProofReader::end(char* input)
   return true;
 }
 
-bool ProofReader::gol(char* input)
+bool ProofReader::gol(const char* input, const char* input_end)
 {
-  input = skipLeadingWhitespace(input);
+  input = skipLeadingWhitespace(input, input_end);
   line_number_offset++;
   extendLineNumberTranslation();
-  target->setGoal(input);
+  target->setGoal(input, input_end - input);
   return true;
 }
 
-char* ProofReader::skipLeadingWhitespace(char* input)
+const char* ProofReader::skipLeadingWhitespace(const char* input, const char* input_end)
 {
-  while (*input == ' ' || *input == '\t') input++;
+  while (input != input_end && (*input == ' ' || *input == '\t')) input++;
   return input;
 }
 
+//Skips any leading delimiters, then ends the token at the next one.
+char* ProofReader::nextToken(char* input, const char* delimiters)
+{
+  if(input != NULL) token_position = input;
+  if(token_position == NULL) return NULL;
+  
+  char* token = token_position + strspn(token_position, delimiters);
+  if(*token == '\0')
+  {
+    token_position = NULL;
+    return NULL;
+  }
+  
+  char* token_end = token + strcspn(token, delimiters);
+  if(*token_end == '\0')
+    token_position = NULL;
+  else
+  {
+    *token_end = '\0';
+    token_position = token_end + 1;
+  }
+  return token;
+}
+
+//Skips any leading delimiters, then ends the token at the next one.
+const char* ProofReader::nextToken(const char*& position, const char* input_end, char delimiter, int& length)
+{
+  while(position != input_end && *position == delimiter) position++;
+  if(position == input_end) return NULL;
+  
+  const char* token = position;
+  while(position != input_end && *position != delimiter) position++;
+  length = position - token;
+  if(position != input_end) position++;
+  return token;
+}
+
+//Optional whitespace and sign, then digits up to the first non-digit.
+int ProofReader::readLineNumber(const char* token, int length)
+{
+  const char* token_end = token + length;
+  while(token != token_end && isspace((unsigned char)*token)) token++;
+  
+  bool negative = false;
+  if(token != token_end && (*token == '+' || *token == '-'))
+  {
+    negative = (*token == '-');
+    token++;
+  }
+  
+  unsigned int number = 0;
+  for(; token != token_end && *token >= '0' && *token <= '9'; token++)
+    number = number*10 + (*token - '0');
+  return negative ? -(int)number : (int)number;
+}
+
 //TODO: add some sorta loop prevention in lemma commands
 //pass depth limit to ProofReader & decrement?
 
@@ -238,35 +337,41 @@ bool ProofReader::equ(char* input)
   line_number_offset++;
   extendLineNumberTranslation();
   
-  char* equivalence_name = strtok(input, ":");
+  char* equivalence_name = nextToken(input, ":");
   if(equivalence_name == NULL || strcmp(equivalence_name, "") == 0) return false;
   
   //getting filenames
-  char* direction_1_filename = strtok(NULL, ":");
-  char* direction_2_filename = strtok(NULL, "\r\n");
+  char* direction_1_filename = nextToken(NULL, ":");
+  char* direction_2_filename = nextToken(NULL, "\r\n");
   if(direction_1_filename == NULL || strcmp(direction_1_filename, "") == 0) return false;
   if(direction_2_filename == NULL || strcmp(direction_2_filename, "") == 0) return false;
   
   //reading files
   Proof direction_1, direction_2;
   ProofReader direction_1_reader, direction_2_reader;
+  direction_1.setOutput(*out);
+  direction_2.setOutput(*out);
+  direction_1.setEnclosingProof(target);
+  direction_2.setEnclosingProof(target);
+  direction_1_reader.setOutput(*out, *err);
+  direction_2_reader.setOutput(*out, *err);
   direction_1_reader.setTarget(&direction_1);
   direction_2_reader.setTarget(&direction_2);
   if(!direction_1_reader.readFile(direction_1_filename) || !direction_2_reader.readFile(direction_2_filename))
     return false;
   
   //Print and verify proofs
-  cout << "Proofs for lemma \"" << equivalence_name << "\" follow:\nFirst Proof:\n";
+  *out << "Proofs for lemma \"" << equivalence_name << "\" follow:\nFirst Proof:\n";
   direction_1.printProof();
   bool dir_1_verified = direction_1.verifyProof();
-  cout << "Second Proof:\n";
+  *out << "Second Proof:\n";
   direction_2.printProof();
   bool dir_2_verified = direction_2.verifyProof();
   if(!dir_1_verified || !dir_2_verified)
   {
-    cout << "Equivalence lemma \"" << equivalence_name << "\" was not successfully proven.\n";
-    cout << "The " << (dir_1_verified?"second":"first") << " proof was incorrect.\n";
-    cout << "Lines that rely on this equivalence will appear as unjustified.\n-------------------------\n";
+    *out << "Equivalence lemma \"" << equivalence_name << "\" was not successfully proven.\n";
+    *out << "The " << (dir_1_verified?"second":"first") << " proof was incorrect.\n";
+    *out << "Lines that rely on this equivalence will appear as unjustified.\n-------------------------\n";
     return true;
   }
   
@@ -283,12 +388,12 @@ bool ProofReader::equ(char* input)
   {
     if(!target->addEquivalenceRule(form_1, form_2, equivalence_name))
     {
-      cerr << "Error: justification rule named \"" << equivalence_name << "\" already exists\n";
+      *err << "Error: justification rule named \"" << equivalence_name << "\" already exists\n";
       return_value = false;
     }
-    cout << "-------------------------\n";
+    *out << "-------------------------\n";
   }
-  else cout << "Lines that rely on this equivalence will appear as unjustified.\n-------------------------\n";
+  else *out << "Lines that rely on this equivalence will appear as unjustified.\n-------------------------\n";
   
   delete [] form_1;
   delete [] form_2;
@@ -308,25 +413,28 @@ bool ProofReader::inf(char* input)
   extendLineNumberTranslation();
   
   //Names of things
-  char* inference_name = strtok(input, ":");
+  char* inference_name = nextToken(input, ":");
   if(inference_name == NULL || strcmp(inference_name, "") == 0) return false;
   
-  char* lemma_file_name = strtok(NULL, "\r\n");
+  char* lemma_file_name = nextToken(NULL, "\r\n");
   if(lemma_file_name == NULL || strcmp(lemma_file_name, "") == 0) return false;
   
   //Read file
   Proof lemma_proof;
   ProofReader lemma_proof_reader;
+  lemma_proof.setOutput(*out);
+  lemma_proof.setEnclosingProof(target);
+  lemma_proof_reader.setOutput(*out, *err);
   lemma_proof_reader.setTarget(&lemma_proof);
   if(!lemma_proof_reader.readFile(lemma_file_name)) return false;
   
   //Print & verify proof
-  cout << "Proof for lemma \"" << inference_name << "\" follows:\n";
+  *out << "Proof for lemma \"" << inference_name << "\" follows:\n";
   lemma_proof.printProof();
   if(!lemma_proof.verifyProof())
   {
-    cout << "Inference lemma \"" << inference_name << "\" was not successfully proven.\n";
-    cout << "Lines that rely on this inference will appear as unjustified.\n-------------------------\n";
+    *out << "Inference lemma \"" << inference_name << "\" was not successfully proven.\n";
+    *out << "Lines that rely on this inference will appear as unjustified.\n-------------------------\n";
     return true;
   }
   
@@ -335,8 +443,8 @@ bool ProofReader::inf(char* input)
   if(strcmp(lemma_goal, "") == 0)
   {
     delete [] lemma_goal;
-    cout << "Inference lemma \"" << inference_name << "\" has no consequent and consequently could not be created.\n";
-    cout << "Lines that rely on this inference will appear as unjustified.\n-------------------------\n";
+    *out << "Inference lemma \"" << inference_name << "\" has no consequent and consequently could not be created.\n";
+    *out << "Lines that rely on this inference will appear as unjustified.\n-------------------------\n";
     return true;
   }
   vector<char*> lemma_premises;
@@ -346,10 +454,10 @@ bool ProofReader::inf(char* input)
   bool return_value = true;
   if(!target->addInferenceRule(lemma_premises, lemma_goal, inference_name))
   {
-    cerr << "Error: justification rule named \"" << inference_name << "\" already exists\n";
+    *err << "Error: justification rule named \"" << inference_name << "\" already exists\n";
     return_value = false;
   }
-  cout << "-------------------------\n";
+  *out << "-------------------------\n";
   delete [] lemma_goal;
   for(unsigned int i = 0; i < lemma_premises.size(); i++)
     delete [] lemma_premises[i];
@@ -357,28 +465,30 @@ bool ProofReader::inf(char* input)
   return return_value;
 }
 
-void ProofReader::malformedLine(const char* filename, char* input)
+void ProofReader::malformedLine(const char* filename, const char* input, const char* input_end)
 {
-	cerr << "Error in " << filename << ": line " << input << " is malformed\n";
+	*err << "Error in " << filename << ": line ";
+	err->write(input, input_end - input);
+	*err << " is malformed\n";
 }
 
 //For translation between file line number & proof line number.
 void ProofReader::extendLineNumberTranslation()
 {
   int target_line = line_number_translation.size() - line_number_offset;
-  line_number_translation[line_number_translation.size() + 1] = target_line;
+  line_number_translation.push_back(target_line);
 }
 
 bool ProofReader::matchEquivalenceForms(char* form_1, char* form_2, vector<char*> premise_1, vector<char*> premise_2)
 {
   if(strcmp(form_1, "") == 0 || strcmp(form_2, "") == 0)
-    cout << "One of the proofs had no goal set.\n";
+    *out << "One of the proofs had no goal set.\n";
   else if(premise_1.size() != 1)
-    cout << "The first proof had " << ((premise_1.size()>1)?"more":"fewer") << " than 1 premise.\n";
+    *out << "The first proof had " << ((premise_1.size()>1)?"more":"fewer") << " than 1 premise.\n";
   else if(premise_2.size() != 1)
-    cout << "The second proof had " << ((premise_2.size()>1)?"more":"fewer") << " than 1 premise.\n";
+    *out << "The second proof had " << ((premise_2.size()>1)?"more":"fewer") << " than 1 premise.\n";
   else if(strcmp(premise_1[0], form_2) != 0 || strcmp(premise_2[0], form_1) != 0)
-    cout << "The premise of one proof does not match the goal of the other.\n";
+    *out << "The premise of one proof does not match the goal of the other.\n";
   else return true;
   
   return false;
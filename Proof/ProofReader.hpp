@@ -2,6 +2,7 @@
 #define __PROOF_READER_H_
 
 #include "Proof.hpp"
+#include "MappedFile.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -22,21 +23,38 @@
 /// <summary>
 /// Reads a proof in an input file into a Proof object. The format of the
 /// input file is specified in readme.txt.
+///
+/// The file is memory mapped and read in place. Sentences, rule names and
+/// antecedent lists are passed to the Proof as pointers into the mapping
+/// with a length, so reading a line doesn't allocate or copy it. Only lemma
+/// lines, which are rare and read other files anyway, are copied.
 /// </summary>
 class ProofReader
 {
   private:
-  std::ifstream reader;
-  std::stringstream linestream;
   Proof* target;
   bool new_line_needed;
   bool derivation_started;
-  std::map<int, int> line_number_translation;
+  bool finished; //A blank line has been read
+  std::vector<int> line_number_translation; //Internal line number for each external line, from line 1
   int line_number_offset;
+  std::ostream* out;
+  std::ostream* err;
+  char* token_position; //For nextToken
+  std::string line_copy; //Null terminated copy of a lemma line, for nextToken
+  std::vector<std::string> lemma_lines; //Every lemma line read, for getLemmaLines
   
   public:
-  ProofReader() : target(NULL)
+  ProofReader() : target(NULL), finished(false), out(&std::cout), err(&std::cerr), token_position(NULL)
   {}
+
+  /// <summary>
+  /// Sets where messages are written while reading, including the printout of
+  /// any lemma proofs. Defaults to the console.
+  /// </summary>
+  /// <param name="output">Stream for normal output</param>
+  /// <param name="errors">Stream for error messages</param>
+  void setOutput(std::ostream& output, std::ostream& errors);
   
   /// <summary>
   /// Sets the Proof object to read the file into. This should be an empty
@@ -48,7 +66,9 @@ class ProofReader
   void setTarget(Proof* new_target);
 
   /// <summary>
-  /// Reads the input file into the Proof. Potential failure conditions are:
+  /// Reads the input file into the Proof. The file may be a text proof or a
+  /// binary one (see BinaryProof), which is told apart by its header.
+  /// Potential failure conditions are:
   /// -File doesn't exist or file IO error.
   /// -Proof object has not been set.
   /// -The proof or one of its lines is not formatted correctly.
@@ -59,16 +79,64 @@ class ProofReader
   ///   is valid.
   /// </returns>
   bool readFile(const char* filename);
+
+  /// <summary>
+  /// Reads one line of a proof into the Proof, for input that arrives a line
+  /// at a time (such as from a pipe) rather than in a file. Lines are read
+  /// the same way as by readFile, starting from when the target was set.
+  /// A blank line ends the proof, after which further lines are ignored.
+  /// </summary>
+  /// <param name="source_name">Name of the input, for error messages</param>
+  /// <param name="line">Contents of the line. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the line, not including the newline</param>
+  /// <returns>False if the line couldn't be read. Reading should stop then.</returns>
+  bool readLine(const char* source_name, const char* line, int length);
+
+  /// <summary>
+  /// Whether a blank line has been read, ending the proof.
+  /// </summary>
+  /// <returns>True if the proof has ended</returns>
+  bool isFinished();
+
+  /// <summary>
+  /// Number of lines at the start of the Proof which are finished, i.e. which
+  /// reading more input will not change. Lines are only ever added to the end
+  /// of the proof, and each is finished once its command has been read, apart
+  /// from the empty line added by an "end" command. The next "lin" command
+  /// fills that line in.
+  /// </summary>
+  /// <returns>Number of finished lines</returns>
+  int completeLines();
+
+  /// <summary>
+  /// The lemma ("equ" and "inf") lines read so far, in order. A binary proof
+  /// keeps these to read again when it's loaded.
+  /// </summary>
+  /// <returns>Text of each lemma line</returns>
+  const std::vector<std::string>& getLemmaLines();
   
   private:
 
   /// <summary>
-  /// Helper for readFile. Loads one line of the input file into a char*,
-  /// to be parsed. The returned string will not contain the newline char,
-  /// or the carriage return if it has a DOS line ending.
+  /// Helper for readLine. Reads the command on one line.
   /// </summary>
-  /// <returns>Newly-allocated char*</returns>
-  char* readLine();
+  /// <param name="source_name">Name of the input, for error messages</param>
+  /// <param name="line">Start of the line, after leading whitespace</param>
+  /// <param name="line_end">
+  ///   End of the line, before the newline (and the carriage return if it
+  ///   has a DOS line ending).
+  /// </param>
+  /// <returns>False if reading should stop with an error</returns>
+  bool readCommand(const char* source_name, const char* line, const char* line_end);
+
+  /// <summary>
+  /// Does a line start with a command?
+  /// </summary>
+  /// <param name="line">Start of the line</param>
+  /// <param name="line_end">End of the line</param>
+  /// <param name="command">Command, including the space after it</param>
+  /// <returns>True if the line starts with the command</returns>
+  bool hasCommand(const char* line, const char* line_end, const char* command);
   
 #pragma region RegularProofLines
 
@@ -79,8 +147,9 @@ class ProofReader
   ///   Contents of the premise line, after the "pre" command. Should just
   ///   be the premise sentence with leading whitespace.
   /// </param>
+  /// <param name="input_end">End of the line</param>
   /// <returns>True</returns>
-  bool pre(char* input);
+  bool pre(const char* input, const char* input_end);
 
   /// <summary>
   /// Reads a derived line and inserts it into the proof.
@@ -91,10 +160,11 @@ class ProofReader
   ///   Antecedents are listed by external line number, i.e. the actual line
   ///   in the input file (one-indexed).
   /// </param>
+  /// <param name="input_end">End of the line</param>
   /// <returns>
   ///   True if the statement and justification strings can be read.
   /// </returns>
-  bool lin(char* input);
+  bool lin(const char* input, const char* input_end);
 
   /// <summary>
   /// Reads a line for a new subproof. Inserts the subproof and its assumption
@@ -104,8 +174,9 @@ class ProofReader
   ///   Subproof line, after the "sub" command. Contains the subproof's
   ///   assumption.
   /// </param>
+  /// <param name="input_end">End of the line</param>
   /// <returns>True</returns>
-  bool sub(char* input);
+  bool sub(const char* input, const char* input_end);
 
   /// <summary>
   /// Reads a line to end a subproof. Ends the current innermost subproof in
@@ -115,8 +186,9 @@ class ProofReader
   ///   Input line after the "sub" command. Should be whitespace;
   ///   is ignored.
   /// </param>
+  /// <param name="input_end">End of the line</param>
   /// <returns>True</returns>
-  bool end(char* input);
+  bool end(const char* input, const char* input_end);
 
   /// <summary>
   /// Reads the proof's goal from the input file. If there's more than one
@@ -125,8 +197,9 @@ class ProofReader
   /// <param name="input">
   ///   Input line after the "gol" command. Contains the goal sentence.
   /// </param>
+  /// <param name="input_end">End of the line</param>
   /// <returns>True</returns>
-  bool gol(char* input);
+  bool gol(const char* input, const char* input_end);
 #pragma endregion
 
 #pragma region Lemmas
@@ -161,14 +234,52 @@ class ProofReader
 #pragma endregion
 
   /// <summary>
-  /// Finds the first character in an input string which is not a space or
+  /// Finds the first character in part of a line which is not a space or
   /// a tab.
   /// </summary>
-  /// <param name="input">Input string to search</param>
+  /// <param name="input">Start of the text to search</param>
+  /// <param name="input_end">End of the text to search</param>
   /// <returns>
-  ///   Pointer to a character in input (this is not a new allocation)
+  ///   Pointer to a character in input, or input_end if there are only
+  ///   spaces and tabs
   /// </returns>
-  char* skipLeadingWhitespace(char* input);
+  const char* skipLeadingWhitespace(const char* input, const char* input_end);
+
+  /// <summary>
+  /// Splits a line into tokens in the same way as strtok, but keeps its place
+  /// in this reader rather than in global state, so that files can be read on
+  /// several threads at once.
+  /// </summary>
+  /// <param name="input">
+  ///   String to start splitting, or null to continue with the last one.
+  ///   Delimiters in it are overwritten with null characters.
+  /// </param>
+  /// <param name="delimiters">Characters which separate tokens</param>
+  /// <returns>The next token, or null if there are none left</returns>
+  char* nextToken(char* input, const char* delimiters);
+
+  /// <summary>
+  /// Splits part of a line into tokens as per nextToken, without modifying
+  /// it. Tokens are returned as a pointer into the line and a length.
+  /// </summary>
+  /// <param name="position">
+  ///   Where to start looking for a token. Will be advanced past the token
+  ///   and the delimiter after it.
+  /// </param>
+  /// <param name="input_end">End of the line</param>
+  /// <param name="delimiter">Character which separates tokens</param>
+  /// <param name="length">Set to the length of the token</param>
+  /// <returns>Start of the next token, or null if there are none left</returns>
+  const char* nextToken(const char*& position, const char* input_end, char delimiter, int& length);
+
+  /// <summary>
+  /// Reads an antecedent line number in the same way as atoi, which gives 0
+  /// for anything that isn't a number.
+  /// </summary>
+  /// <param name="token">Start of the number</param>
+  /// <param name="length">Number of characters in the token</param>
+  /// <returns>External line number</returns>
+  int readLineNumber(const char* token, int length);
   
   /// <summary>
   /// Outputs text to the error console describing a line that couldn't be
@@ -176,7 +287,8 @@ class ProofReader
   /// </summary>
   /// <param name="filename">Name of the file the line is in</param>
   /// <param name="input">Contents of the line</param>
-  void malformedLine(const char* filename, char* input);
+  /// <param name="input_end">End of the line</param>
+  void malformedLine(const char* filename, const char* input, const char* input_end);
 
   /// <summary>
   /// Adds another line to a mapping from external line numbers to internal
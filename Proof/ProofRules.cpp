@@ -2,21 +2,17 @@
 #include "InferenceRules.hpp"
 #include "EquivalenceRules.hpp"
 #include "AggregateJustification.hpp"
+#include "TautologicalConsequence.hpp"
+#include "LogicalEquivalence.hpp"
+#include "MappedFile.hpp"
+#include "RulePack.hpp"
+#include <cstdlib>
 #include <cstring>
-#include <sstream>
-#include <fcntl.h>
 #include <iostream>
+#include <vector>
 
-#if defined(_WIN32)
-#include <io.h>
-
-#else
-#include <unistd.h>
-
-#endif
-
-using std::stringstream;
 using std::string;
+using std::vector;
 using std::cerr;
 using std::endl;
 using rapidxml::xml_document;
@@ -24,49 +20,109 @@ using rapidxml::xml_node;
 using rapidxml::xml_attribute;
 
 bool ProofRules::rules_need_reading = true;
+bool ProofRules::external_rules = false;
 justification_map ProofRules::rules;
+const char* ProofRules::built_in_rules = NULL;
+size_t ProofRules::built_in_rules_size = 0;
+
+void ProofRules::setBuiltInRules(const unsigned char* pack, size_t size)
+{
+  built_in_rules = (const char*)pack;
+  built_in_rules_size = size;
+}
+
+void ProofRules::setExternalRules(bool enabled)
+{ external_rules = enabled; }
 
-//Creates the initial rule map from the XML input file.
+//Creates the initial rule map from the built in rules, then the rules in the
+//rules file on top of them if they're wanted. If the built in rules were
+//compiled from the rules file as it is, it isn't parsed.
 void ProofRules::readRulesFromFile()
 {
   if (!rules_need_reading) return; //We've already done this
 
-  //Open and read file to a stringstream.
-  stringstream input_string;
-  char* input_buffer = new char[RULE_CHUNK_SIZE + 1];
-  int fd = open(DEFAULT_RULES_FILENAME, O_RDONLY);
-  if (fd == -1)
+  //With built in rules, the working directory isn't looked at unless asked
+  bool read_external = built_in_rules == NULL || external_rules;
+  MappedFile input_file;
+  bool has_rules_file = read_external && input_file.open(DEFAULT_RULES_FILENAME);
+  unsigned long long source_checksum = has_rules_file ?
+    RulePack::checksum(input_file.data(), input_file.size()) : 0;
+  bool rules_file_built_in = false;
+  if (built_in_rules != NULL)
   {
-    cerr << "Error: rules file " << DEFAULT_RULES_FILENAME << " could not be opened." << endl;
-    exit(1);
+    RulePack::read_result_t built_in_result = RulePack::read(built_in_rules, built_in_rules_size,
+      has_rules_file ? &source_checksum : NULL, rules);
+    rules_file_built_in = has_rules_file && built_in_result == RulePack::PACK_LOADED;
+    if (built_in_result == RulePack::PACK_STALE)
+      built_in_result = RulePack::read(built_in_rules, built_in_rules_size, NULL, rules);
+    if (built_in_result != RulePack::PACK_LOADED)
+    {
+      cerr << "Error: the built in rules could not be read." << endl;
+      exit(1);
+    }
   }
 
-  int read_size;
-  while ((read_size = read(fd, input_buffer, RULE_CHUNK_SIZE)))
+  if (read_external && !rules_file_built_in)
   {
-    if (read_size == -1)
+    justification_map file_rules;
+    if (!readExternalRules(input_file, has_rules_file ? &source_checksum : NULL,
+      built_in_rules == NULL, file_rules))
     {
-      cerr << "Error: rules file was opened but couldn't be read." << endl;
-      exit(1);
+      if (built_in_rules == NULL)
+      {
+        cerr << "Error: rules file " << DEFAULT_RULES_FILENAME << " could not be opened." << endl;
+        exit(1);
+      }
+      cerr << "Warning: rules file " << DEFAULT_RULES_FILENAME << " could not be opened, using the built in rules only." << endl;
+    }
+
+    //Rules from the file replace built in rules of the same name
+    for (justification_map::iterator itr = file_rules.begin(); itr != file_rules.end(); itr++)
+    {
+      justification_map::iterator existing = rules.find(itr->first);
+      if (existing != rules.end()) delete existing->second;
+      rules[itr->first] = itr->second;
     }
-    input_buffer[read_size] = '\0';
-    input_string << input_buffer;
   }
-  close(fd);
+  rules_need_reading = false;
+}
+
+//Reads the rule pack if it's up to date with the rules file, and otherwise
+//the rules file. A pack that can't be checked against a rules file is only
+//trusted when it's the only source of rules.
+bool ProofRules::readExternalRules(MappedFile& rules_file, const unsigned long long* source_checksum,
+  bool pack_alone, justification_map& target)
+{
+  if (source_checksum == NULL && !pack_alone) return false;
+  RulePack::read_result_t pack_result = RulePack::read(DEFAULT_RULE_PACK_FILENAME,
+    source_checksum, target);
+  if (pack_result == RulePack::PACK_LOADED) return true;
+  if (pack_result == RulePack::PACK_STALE)
+    cerr << "Warning: rule pack " << DEFAULT_RULE_PACK_FILENAME << " is out of date, reading " << DEFAULT_RULES_FILENAME << " instead." << endl;
+  else if (pack_result == RulePack::PACK_INVALID)
+    cerr << "Warning: rule pack " << DEFAULT_RULE_PACK_FILENAME << " is damaged, reading " << DEFAULT_RULES_FILENAME << " instead." << endl;
+
+  if (source_checksum == NULL) return false;
+  if (!parseRules(rules_file.data(), rules_file.size(), target))
+    exit(2);
+  return true;
+}
 
-  //Parse XML in input file with rapidxml
-  delete[] input_buffer;
-  input_buffer = new char[input_string.str().size() + 1];
-  strcpy(input_buffer, input_string.str().c_str()); //rapidxml modifies the c string it parses; copy data to a non-const c-string, then parse.
+//Parses the XML in a rules file into rules.
+bool ProofRules::parseRules(const char* source, size_t size, justification_map& target)
+{
+  //rapidxml modifies the c string it parses; copy data to a non-const c-string, then parse.
+  vector<char> input_buffer(source, source + size);
+  input_buffer.push_back('\0');
   xml_document<> input_structure;
   try
   {
-    input_structure.parse<0>(input_buffer);
+    input_structure.parse<0>(&input_buffer[0]);
   }
   catch (int e)
   {
     cerr << "Error: rules file could not be parsed, exception id " << e << endl;
-    exit(2);
+    return false;
   }
 
   //Create rules from nodes
@@ -83,13 +139,12 @@ void ProofRules::readRulesFromFile()
     }
     else
     {
-      rules[string(rule_name->value())] = new_rule;
+      target[string(rule_name->value())] = new_rule;
     }
   }
 
-  rules_need_reading = false;
   input_structure.clear();
-  delete[] input_buffer;
+  return true;
 }
 
 //Translates one XML node into a Justification object.
@@ -118,6 +173,10 @@ Justification* ProofRules::readRuleNode(xml_node<>* rule_node)
     retval = readInferenceRule(rule_node, rule_name);
   else if (strcmp(rule_node->name(), "aggregate") == 0)
     retval = readAggregateRule(rule_node, rule_name);
+  else if (strcmp(rule_node->name(), "tautological") == 0)
+    retval = new TautologicalConsequence(rule_name); //Nothing else to read
+  else if (strcmp(rule_node->name(), "logical") == 0)
+    retval = new LogicalEquivalence(rule_name);
   delete[] rule_name;
   return retval;
 }
@@ -209,6 +268,9 @@ Justification* ProofRules::readAggregateRule(xml_node<>* rule_node, char* rule_n
   return (Justification*)created_rule;
 }
 
+void ProofRules::loadRules()
+{ readRulesFromFile(); }
+
 //Finds and returns the justification rule with the given name. Returns NULL if no such rule is found.
 //Reads default rules from the file first if that has not yet happened.
 Justification* ProofRules::findRule(const char* rule_name)
@@ -2,10 +2,12 @@
 #define __PROOFRULES_H_
 
 #define DEFAULT_RULES_FILENAME "rules.xml"
-#define RULE_CHUNK_SIZE 20
+#define DEFAULT_RULE_PACK_FILENAME "rules.pack"
 
 #include "rapidxml.hpp"
 #include "Justification.hpp"
+#include "MappedFile.hpp"
+#include <cstddef>
 #include <map>
 #include <string>
 
@@ -20,7 +22,13 @@ typedef std::map<std::string, Justification*> justification_map;
 /// using lemmas.
 /// 
 /// Rules are retrieved by name, and the rules file will be read the first 
-/// time a rule is retrieved.
+/// time a rule is retrieved. If there's a rule pack (see RulePack) compiled
+/// from the current rules file, the rules are loaded from it instead.
+/// 
+/// The program may also have a set of rules built in (see setBuiltInRules),
+/// in which case only those are used, and the rules file isn't looked for,
+/// unless setExternalRules asks for it. Rules in it are then added to the
+/// built in ones, replacing any with the same name.
 /// 
 /// Uses rapidxml to parse the XML rules file.
 /// </summary>
@@ -29,13 +37,39 @@ class ProofRules
   private:
   static justification_map rules;
   static bool rules_need_reading;
+  static bool external_rules;
+  static const char* built_in_rules;
+  static size_t built_in_rules_size;
 	
   /// <summary>
-  /// Reads the rules file and stores the rules in the map. This will be called
-  /// the first time findRule or addRule is called.
+  /// Stores the built in rules, if there are any, and the rules from the
+  /// rules file in the map. This will be called the first time findRule or
+  /// addRule is called. The rules file is only read when there are no built
+  /// in rules or setExternalRules asked for it, and isn't parsed if the
+  /// built in rules were compiled from it.
   /// </summary>
   static void readRulesFromFile();
 
+  /// <summary>
+  /// Helper for readRulesFromFile. Reads the rule pack if it's up to date
+  /// with the rules file; if it's out of date or damaged, a warning is
+  /// printed and the rules file is read. Without a rules file, the pack
+  /// can't be checked, so it's only read if pack_alone is set.
+  /// </summary>
+  /// <param name="rules_file">The rules file, mapped if it could be opened</param>
+  /// <param name="source_checksum">
+  ///   Checksum of the rules file (see RulePack), or NULL if it couldn't be
+  ///   opened.
+  /// </param>
+  /// <param name="pack_alone">
+  ///   Whether a rule pack may be used without a rules file, i.e. there are
+  ///   no built in rules for it to replace.
+  /// </param>
+  /// <param name="target">Map to add the rules to</param>
+  /// <returns>False if no rules were read</returns>
+  static bool readExternalRules(MappedFile& rules_file, const unsigned long long* source_checksum,
+    bool pack_alone, justification_map& target);
+
   /// <summary>
   /// Helper for readRulesFromFile. Parses the XML node for one rule and
   /// constructs a Justification object for it. If the node has no "rulename"
@@ -87,6 +121,41 @@ class ProofRules
 	
   public:
 
+  /// <summary>
+  /// Sets a rule pack built into the program (see RulePack), whose rules
+  /// are used unless the rules file replaces them. Must be called before any
+  /// rules are looked up.
+  /// </summary>
+  /// <param name="pack">Contents of the rule pack, which must outlast the program</param>
+  /// <param name="size">Length of the contents</param>
+  static void setBuiltInRules(const unsigned char* pack, size_t size);
+
+  /// <summary>
+  /// Sets whether to read the rules file (or a rule pack up to date with it)
+  /// from the working directory as well as the built in rules. Off by
+  /// default; without built in rules, the rules file is always read. Must be
+  /// called before any rules are looked up.
+  /// </summary>
+  /// <param name="enabled">Whether to read the rules file</param>
+  static void setExternalRules(bool enabled);
+
+  /// <summary>
+  /// Parses the contents of a rules file, adding each rule to a map. Used by
+  /// readRulesFromFile, and by the rule compiler.
+  /// </summary>
+  /// <param name="source">Contents of the rules file. Not null terminated.</param>
+  /// <param name="size">Length of the contents</param>
+  /// <param name="target">Map to add the rules to</param>
+  /// <returns>False if the XML couldn't be parsed</returns>
+  static bool parseRules(const char* source, size_t size, justification_map& target);
+
+  /// <summary>
+  /// Reads the rules file if it hasn't been read yet. This otherwise happens
+  /// the first time a rule is looked up; call it before starting threads that
+  /// look up rules, so they only ever read the rule map.
+  /// </summary>
+  static void loadRules();
+
   /// <summary>
   /// Finds a rule by name. If the rules file has not been read yet, will load
   /// the rules (with readRulesFromFile).
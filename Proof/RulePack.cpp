@@ -0,0 +1,297 @@
+#include "RulePack.hpp"
+#include "BinaryFormat.hpp"
+#include "MappedFile.hpp"
+#include "AtomTable.hpp"
+#include "InferenceRules.hpp"
+#include "EquivalenceRules.hpp"
+#include "AggregateJustification.hpp"
+#include "TautologicalConsequence.hpp"
+#include "LogicalEquivalence.hpp"
+#include <cstring>
+#include <list>
+#include <string>
+#include <vector>
+
+using std::list;
+using std::string;
+using std::vector;
+
+#define RULE_PACK_MAGIC_SIZE 7
+#define RULE_PACK_CHECKSUMS_SIZE 16
+#define RULE_PACK_NO_FORM 0xFFFFFFFF
+#define RULE_PACK_MAX_NESTING 16
+
+//Magic bytes, then the format version.
+static const char rule_pack_header[RULE_PACK_HEADER_SIZE] =
+  { 'L', 'O', 'G', 'I', 'C', 'R', 'P', RULE_PACK_VERSION };
+
+enum rule_kind_t { EQUIVALENCE_RULE, INFERENCE_RULE, AGGREGATE_RULE, TAUTOLOGICAL_RULE,
+  LOGICAL_EQUIVALENCE_RULE };
+
+//Writes the rule records for a list of rules, and collects their forms.
+class RuleRecordWriter
+{
+  private:
+  FormulaTableWriter& formulas;
+  BinaryWriter& records;
+
+  public:
+  RuleRecordWriter(FormulaTableWriter& formula_table, BinaryWriter& output) :
+    formulas(formula_table), records(output)
+  {}
+
+  //Rules are told apart by their class, since that's all that says what kind
+  //of rule they were read as.
+  bool writeRule(Justification* rule)
+  {
+    const char* name = rule->getName();
+    if(EquivalenceRule* equivalence = dynamic_cast<EquivalenceRule*>(rule))
+    {
+      records.writeWord(EQUIVALENCE_RULE);
+      records.writeString(name, strlen(name));
+      const list<equiv_variants>& pairs = equivalence->getEquivalentPairs();
+      records.writeWord(pairs.size());
+      for(list<equiv_variants>::const_iterator itr = pairs.begin(); itr != pairs.end(); itr++)
+      {
+        for(int i = 0; i < 2; i++)
+        {
+          records.writeWord(formulas.addFormula(itr->variants[i].first));
+          records.writeWord(formulas.addFormula(itr->variants[i].second));
+        }
+      }
+    }
+    else if(InferenceRule* inference = dynamic_cast<InferenceRule*>(rule))
+    {
+      records.writeWord(INFERENCE_RULE);
+      records.writeString(name, strlen(name));
+      records.writeWord(formulas.addFormula(inference->getResultForm()));
+      const required_form_list& forms = inference->getRequiredForms();
+      records.writeWord(forms.size());
+      for(required_form_list::const_iterator itr = forms.begin(); itr != forms.end(); itr++)
+      {
+        records.writeWord(formulas.addFormula((*itr)->statementForm));
+        records.writeWord(((*itr)->subproofAssumptionForm == NULL) ? RULE_PACK_NO_FORM :
+          formulas.addFormula((*itr)->subproofAssumptionForm));
+      }
+    }
+    else if(AggregateJustification* aggregate = dynamic_cast<AggregateJustification*>(rule))
+    {
+      records.writeWord(AGGREGATE_RULE);
+      records.writeString(name, strlen(name));
+      const list<Justification*>& subrules = aggregate->getRules();
+      records.writeWord(subrules.size());
+      for(list<Justification*>::const_iterator itr = subrules.begin(); itr != subrules.end(); itr++)
+        if(!writeRule(*itr)) return false;
+    }
+    else if(dynamic_cast<TautologicalConsequence*>(rule) != NULL)
+    {
+      records.writeWord(TAUTOLOGICAL_RULE);
+      records.writeString(name, strlen(name));
+      records.writeWord(0); //Has no forms
+    }
+    else if(dynamic_cast<LogicalEquivalence*>(rule) != NULL)
+    {
+      records.writeWord(LOGICAL_EQUIVALENCE_RULE);
+      records.writeString(name, strlen(name));
+      records.writeWord(0);
+    }
+    else
+      return false; //Not a kind of rule that can be in rules.xml
+    return true;
+  }
+};
+
+//Builds rules from their records. Every count and index is checked before
+//it's used.
+class RuleRecordReader
+{
+  private:
+  BinaryReader& input;
+  vector<StatementTree*>& formulas;
+
+  //Reads a form index, which must be in the table.
+  bool readForm(StatementTree*& form)
+  {
+    unsigned int index;
+    if(!input.readWord(index) || index >= formulas.size()) return false;
+    form = formulas[index];
+    return true;
+  }
+
+  public:
+  RuleRecordReader(BinaryReader& reader, vector<StatementTree*>& formula_table) :
+    input(reader), formulas(formula_table)
+  {}
+
+  //Returns NULL if the record isn't valid.
+  Justification* readRule(int nesting)
+  {
+    unsigned int kind, count;
+    const char* name;
+    int name_length;
+    if(!input.readWord(kind) || !input.readString(name, name_length) || !input.readWord(count))
+      return NULL;
+    string rule_name(name, name_length);
+
+    if(kind == EQUIVALENCE_RULE)
+    {
+      if(count == 0) return NULL; //As when reading rules.xml
+      EquivalenceRule* rule = new EquivalenceRule(rule_name.c_str());
+      for(unsigned int i = 0; i < count; i++)
+      {
+        equiv_variants variants;
+        bool valid = true;
+        for(int j = 0; j < 2 && valid; j++)
+          valid = readForm(variants.variants[j].first) && readForm(variants.variants[j].second);
+        if(!valid)
+        {
+          delete rule;
+          return NULL;
+        }
+        rule->addEquivalentVariants(variants);
+      }
+      return rule;
+    }
+    else if(kind == INFERENCE_RULE)
+    {
+      //count was the consequent form
+      if(count >= formulas.size()) return NULL;
+      InferenceRule* rule = new InferenceRule(*formulas[count], rule_name.c_str());
+      unsigned int form_count;
+      if(!input.readWord(form_count))
+      {
+        delete rule;
+        return NULL;
+      }
+      for(unsigned int i = 0; i < form_count; i++)
+      {
+        StatementTree* statement;
+        unsigned int assumption;
+        if(!readForm(statement) || !input.readWord(assumption) ||
+          (assumption != RULE_PACK_NO_FORM && assumption >= formulas.size()))
+        {
+          delete rule;
+          return NULL;
+        }
+        rule->addRequiredForm(statement,
+          (assumption == RULE_PACK_NO_FORM) ? NULL : formulas[assumption]);
+      }
+      return rule;
+    }
+    else if(kind == AGGREGATE_RULE)
+    {
+      if(count == 0 || nesting >= RULE_PACK_MAX_NESTING) return NULL;
+      AggregateJustification* rule = new AggregateJustification(rule_name.c_str());
+      for(unsigned int i = 0; i < count; i++)
+      {
+        Justification* subrule = readRule(nesting + 1);
+        if(subrule == NULL)
+        {
+          delete rule;
+          return NULL;
+        }
+        rule->addRule(subrule);
+      }
+      return rule;
+    }
+    else if(kind == TAUTOLOGICAL_RULE)
+      return (count == 0) ? new TautologicalConsequence(rule_name.c_str()) : NULL;
+    else if(kind == LOGICAL_EQUIVALENCE_RULE)
+      return (count == 0) ? new LogicalEquivalence(rule_name.c_str()) : NULL;
+    return NULL;
+  }
+};
+
+unsigned long long RulePack::checksum(const char* source, size_t size)
+{ return AtomTable::hashName(source, size); }
+
+//The body is written first so that its checksum can go in the header.
+bool RulePack::write(justification_map& rules, unsigned long long source_checksum,
+  const char* filename)
+{
+  FormulaTableWriter formulas;
+  BinaryWriter records;
+  RuleRecordWriter rule_writer(formulas, records);
+  records.writeWord(rules.size());
+  for(justification_map::iterator itr = rules.begin(); itr != rules.end(); itr++)
+    if(!rule_writer.writeRule(itr->second)) return false;
+
+  BinaryWriter body;
+  formulas.write(body);
+  body.append(records);
+  const vector<unsigned char>& body_data = body.data();
+  unsigned long long body_checksum = body_data.empty() ? checksum(NULL, 0) :
+    checksum((const char*)&body_data[0], body_data.size());
+
+  BinaryWriter output;
+  output.writeBytes(rule_pack_header, RULE_PACK_HEADER_SIZE);
+  output.writeWord((unsigned int)source_checksum);
+  output.writeWord((unsigned int)(source_checksum >> 32));
+  output.writeWord((unsigned int)body_checksum);
+  output.writeWord((unsigned int)(body_checksum >> 32));
+  output.append(body);
+  return output.save(filename);
+}
+
+RulePack::read_result_t RulePack::read(const char* filename,
+  const unsigned long long* source_checksum, justification_map& rules)
+{
+  MappedFile file;
+  if(!file.open(filename)) return PACK_MISSING;
+  return read(file.data(), file.size(), source_checksum, rules);
+}
+
+//Rules are read into a map of their own, and only added once the whole pack
+//has been read.
+RulePack::read_result_t RulePack::read(const char* data, size_t size,
+  const unsigned long long* source_checksum, justification_map& rules)
+{
+  if(size < RULE_PACK_HEADER_SIZE + RULE_PACK_CHECKSUMS_SIZE ||
+    memcmp(data, rule_pack_header, RULE_PACK_HEADER_SIZE) != 0)
+    return PACK_INVALID;
+
+  BinaryReader header(data + RULE_PACK_HEADER_SIZE, RULE_PACK_CHECKSUMS_SIZE);
+  unsigned int words[4];
+  for(int i = 0; i < 4; i++)
+    header.readWord(words[i]);
+  unsigned long long pack_source = words[0] | ((unsigned long long)words[1] << 32);
+  unsigned long long pack_body = words[2] | ((unsigned long long)words[3] << 32);
+  if(source_checksum != NULL && *source_checksum != pack_source)
+    return PACK_STALE;
+
+  const char* body = data + RULE_PACK_HEADER_SIZE + RULE_PACK_CHECKSUMS_SIZE;
+  size_t body_size = size - RULE_PACK_HEADER_SIZE - RULE_PACK_CHECKSUMS_SIZE;
+  if(checksum(body, body_size) != pack_body) return PACK_INVALID;
+
+  BinaryReader input(body, body_size);
+  vector<StatementTree*> formulas;
+  justification_map read_rules;
+  bool valid = input.readFormulas(formulas);
+  unsigned int rule_count = 0;
+  if(valid) valid = input.readWord(rule_count);
+
+  RuleRecordReader rule_reader(input, formulas);
+  for(unsigned int i = 0; valid && i < rule_count; i++)
+  {
+    Justification* rule = rule_reader.readRule(0);
+    if(rule == NULL || read_rules.find(string(rule->getName())) != read_rules.end())
+    {
+      delete rule;
+      valid = false;
+    }
+    else
+      read_rules[string(rule->getName())] = rule;
+  }
+  valid = valid && input.atEnd();
+
+  for(unsigned int i = 0; i < formulas.size(); i++)
+    StatementTree::release(formulas[i]);
+  if(!valid)
+  {
+    for(justification_map::iterator itr = read_rules.begin(); itr != read_rules.end(); itr++)
+      delete itr->second;
+    return PACK_INVALID;
+  }
+  rules.insert(read_rules.begin(), read_rules.end());
+  return PACK_LOADED;
+}
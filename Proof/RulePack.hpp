@@ -0,0 +1,80 @@
+#ifndef __RULE_PACK_H_
+#define __RULE_PACK_H_
+
+#include "ProofRules.hpp"
+#include <cstddef>
+
+#define RULE_PACK_HEADER_SIZE 8
+#define RULE_PACK_VERSION 1
+
+/// <summary>
+/// Reads and writes rule packs: the rules from rules.xml compiled to a binary
+/// file (see ruleCompiler), so that a short-lived process can load its rules
+/// without parsing XML or any of the rules' forms.
+///
+/// The file is a header, a checksum of the rules.xml it was compiled from, a
+/// checksum of the rest of the file, then:
+/// - Every form used by the rules, as a FormulaTableWriter table. Both
+///   polarity variants of each equivalent pair are stored, so nothing is
+///   built from them when loading.
+/// - Each rule: its kind and name, then its forms by index in the table. An
+///   aggregate rule is followed by its subrules, and tautological consequence
+///   and logical equivalence rules have no forms.
+/// The file is mapped and read in place.
+/// </summary>
+class RulePack
+{
+  public:
+  enum read_result_t { PACK_LOADED, PACK_MISSING, PACK_STALE, PACK_INVALID };
+
+  /// <summary>
+  /// Checksum of the contents of a rules file, as stored in a pack compiled
+  /// from it.
+  /// </summary>
+  /// <param name="source">Contents of the rules file</param>
+  /// <param name="size">Length of the contents</param>
+  /// <returns>Checksum</returns>
+  static unsigned long long checksum(const char* source, size_t size);
+
+  /// <summary>
+  /// Writes rules to a pack file.
+  /// </summary>
+  /// <param name="rules">Rules read from the rules file</param>
+  /// <param name="source_checksum">Checksum of the rules file they were read from</param>
+  /// <param name="filename">File to write</param>
+  /// <returns>False if the file couldn't be written</returns>
+  static bool write(justification_map& rules, unsigned long long source_checksum,
+    const char* filename);
+
+  /// <summary>
+  /// Reads the rules in a pack file. Nothing is added unless the whole pack
+  /// is valid.
+  /// </summary>
+  /// <param name="filename">File to read</param>
+  /// <param name="source_checksum">
+  ///   Checksum of the current rules file, which the pack must have been
+  ///   compiled from. If NULL the pack is used without checking it.
+  /// </param>
+  /// <param name="rules">Map the rules are added to</param>
+  /// <returns>
+  ///   PACK_LOADED if the rules were added, PACK_MISSING if there's no pack,
+  ///   PACK_STALE if it was compiled from a different rules file, or
+  ///   PACK_INVALID if it's damaged or from another version.
+  /// </returns>
+  static read_result_t read(const char* filename, const unsigned long long* source_checksum,
+    justification_map& rules);
+
+  /// <summary>
+  /// Reads the rules in a pack that's already in memory, such as one built
+  /// into the program. As for reading a pack file.
+  /// </summary>
+  /// <param name="data">Contents of the pack</param>
+  /// <param name="size">Length of the contents</param>
+  /// <param name="source_checksum">Checksum the pack must have been compiled from, or NULL</param>
+  /// <param name="rules">Map the rules are added to</param>
+  /// <returns>PACK_LOADED, PACK_STALE or PACK_INVALID</returns>
+  static read_result_t read(const char* data, size_t size,
+    const unsigned long long* source_checksum, justification_map& rules);
+};
+
+#endif
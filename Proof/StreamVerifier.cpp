@@ -0,0 +1,211 @@
+#include "StreamVerifier.hpp"
+#include "ProofReader.hpp"
+#include <thread>
+
+using std::string;
+using std::vector;
+using std::stringstream;
+using std::lock_guard;
+using std::unique_lock;
+using std::mutex;
+
+/// <summary>
+/// ParallelTask which checks one of a set of finished lines per task.
+/// </summary>
+class StreamCheckTask : public ParallelTask
+{
+  private:
+  vector<ProofStatement*>& lines;
+  vector<char>& justified;
+  VerificationCache* cache;
+
+  public:
+  StreamCheckTask(vector<ProofStatement*>& to_check, vector<char>& results,
+    VerificationCache* line_cache) : lines(to_check), justified(results), cache(line_cache)
+  {}
+
+  void runTask(int index)
+  { justified[index] = lines[index]->isJustified(cache); }
+};
+
+StreamVerifier::StreamVerifier() : cache(NULL), out(&std::cout), err(&std::cerr),
+  lines_failed(false), low_memory(false), checked_lines(0), reading_done(false),
+  read_failed(false)
+{
+  //This space left intentionally blank
+}
+
+void StreamVerifier::setCache(VerificationCache* line_cache)
+{
+  cache = line_cache;
+}
+
+void StreamVerifier::setLowMemory(bool enabled)
+{
+  low_memory = enabled;
+  proof.setLowMemory(enabled);
+}
+
+//The calling thread does the checking while a second thread reads, except in
+//low memory mode where the reading thread checks lines itself.
+bool StreamVerifier::run(std::istream& input, const char* source_name, WorkPool* pool,
+  std::ostream& output, std::ostream& errors)
+{
+  out = &output;
+  err = &errors;
+  proof.setOutput(output);
+  lines_failed = false;
+  checked_lines = 0;
+  reading_done = false;
+  read_failed = false;
+  
+  if(low_memory)
+    readInput(input, source_name);
+  else
+  {
+    std::thread reading_stage(&StreamVerifier::readInput, this, std::ref(input), source_name);
+    vector<stream_item> items;
+    while(takeItems(items))
+      checkItems(items, pool);
+    reading_stage.join();
+  }
+  
+  if(read_failed)
+  {
+    *err << "Program terminated: errors encountered while reading " << source_name << "\n";
+    return false;
+  }
+  bool verified = proof.reportSummary(lines_failed);
+  out->flush();
+  return verified;
+}
+
+//Reader output goes through buffers, so that only the checking stage writes
+//to the output streams.
+void StreamVerifier::readInput(std::istream& input, const char* source_name)
+{
+  ProofReader reader;
+  stringstream reader_output, reader_errors;
+  reader.setOutput(reader_output, reader_errors);
+  reader.setTarget(&proof);
+  
+  int passed_lines = 0;
+  bool read_ok = true;
+  string line;
+  while(!reader.isFinished() && std::getline(input, line))
+  {
+    read_ok = reader.readLine(source_name, line.data(), line.size());
+    passOutput(reader_output, false);
+    passOutput(reader_errors, true);
+    if(!read_ok) break; //The line it stopped at may be half read
+    
+    stream_item item;
+    item.is_error = false;
+    for(int complete = reader.completeLines(); passed_lines < complete; passed_lines++)
+    {
+      item.line = proof.getLine(passed_lines);
+      item.line_number = passed_lines+1;
+      passItem(item);
+    }
+    if(low_memory) proof.releaseCheckedLines(checked_lines);
+  }
+  
+  //At the end of the input, an empty line left by "end" is finished too
+  if(read_ok)
+  {
+    stream_item item;
+    item.is_error = false;
+    for(; passed_lines < proof.lineCount(); passed_lines++)
+    {
+      item.line = proof.getLine(passed_lines);
+      item.line_number = passed_lines+1;
+      passItem(item);
+    }
+  }
+  
+  lock_guard<mutex> guard(queue_lock);
+  reading_done = true;
+  read_failed = !read_ok;
+  queue_changed.notify_one();
+}
+
+void StreamVerifier::passItem(const stream_item& item)
+{
+  if(low_memory)
+  {
+    writeItem(item, item.line == NULL || item.line->isJustified(cache));
+    if(item.line != NULL) checked_lines++;
+    return;
+  }
+  
+  lock_guard<mutex> guard(queue_lock);
+  pending.push_back(item);
+  queue_changed.notify_one();
+}
+
+void StreamVerifier::passOutput(stringstream& buffer, bool is_error)
+{
+  string text = buffer.str();
+  if(text.empty()) return;
+  buffer.str("");
+  
+  stream_item item;
+  item.line = NULL;
+  item.line_number = 0;
+  item.text = text;
+  item.is_error = is_error;
+  passItem(item);
+}
+
+bool StreamVerifier::takeItems(vector<stream_item>& items)
+{
+  unique_lock<mutex> guard(queue_lock);
+  while(pending.empty() && !reading_done)
+    queue_changed.wait(guard);
+  items.assign(pending.begin(), pending.end());
+  pending.clear();
+  return !items.empty();
+}
+
+//Output is flushed after each failure, so it's seen straight away even when
+//the output is a pipe.
+void StreamVerifier::checkItems(vector<stream_item>& items, WorkPool* pool)
+{
+  vector<ProofStatement*> lines;
+  vector<char> justified;
+  bool parallel = pool != NULL && pool->threadCount() > 1;
+  if(parallel)
+  {
+    for(unsigned int i = 0; i < items.size(); i++)
+    {
+      if(items[i].line != NULL) lines.push_back(items[i].line);
+    }
+    justified.assign(lines.size(), 0);
+    StreamCheckTask task(lines, justified, cache);
+    pool->run(task, lines.size());
+  }
+  
+  int checked = 0;
+  for(unsigned int i = 0; i < items.size(); i++)
+  {
+    if(items[i].line == NULL)
+      writeItem(items[i], true);
+    else if(parallel)
+      writeItem(items[i], justified[checked++] != 0);
+    else
+      writeItem(items[i], items[i].line->isJustified(cache));
+  }
+  out->flush();
+}
+
+void StreamVerifier::writeItem(const stream_item& item, bool justified)
+{
+  if(item.line == NULL)
+    *(item.is_error ? err : out) << item.text;
+  else if(!justified)
+  {
+    proof.reportLineFailure(item.line, item.line_number);
+    lines_failed = true;
+    out->flush();
+  }
+}
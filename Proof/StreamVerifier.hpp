@@ -0,0 +1,144 @@
+#ifndef __STREAM_VERIFIER_H_
+#define __STREAM_VERIFIER_H_
+
+#include "Proof.hpp"
+#include "WorkPool.hpp"
+#include "VerificationCache.hpp"
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Verifies a proof as it's read from a stream, such as standard input, so
+/// results come out while the rest of the proof is still arriving.
+///
+/// Reading and checking are separate stages on separate threads. The reading
+/// stage parses each line into the Proof with a ProofReader and passes every
+/// line that's finished (see ProofReader::completeLines) to the checking
+/// stage. A finished line, and the lines and closed subproofs it uses as
+/// antecedents, don't change again, so the checking stage can check it while
+/// reading carries on. Failures are printed as soon as they're found, in line
+/// order, and the summary and goal are printed once the input ends.
+///
+/// In low memory mode (see Proof::setLowMemory) the stages run one after the
+/// other on one thread instead: each line is checked as soon as it's
+/// finished, and the Proof then frees what later lines can't use.
+/// </summary>
+class StreamVerifier
+{
+  private:
+  /// <summary>
+  /// Something passed from the reading stage to the checking stage: either a
+  /// finished line to check, or output from reading (such as a lemma proof's
+  /// printout) to be written in order with the results.
+  /// </summary>
+  struct stream_item
+  {
+    ProofStatement* line; //Null for output
+    int line_number;
+    std::string text;
+    bool is_error; //Text goes to the error stream
+  };
+
+  Proof proof;
+  VerificationCache* cache;
+  std::ostream* out;
+  std::ostream* err;
+  bool lines_failed;
+  bool low_memory;
+  int checked_lines; //Lines checked so far, in low memory mode
+
+  //Queue between the stages
+  std::mutex queue_lock;
+  std::condition_variable queue_changed;
+  std::deque<stream_item> pending;
+  bool reading_done;
+  bool read_failed;
+
+  /// <summary>
+  /// The reading stage. Reads lines until the input ends or a blank line,
+  /// passing on each line once it's finished.
+  /// </summary>
+  /// <param name="input">Stream to read the proof from</param>
+  /// <param name="source_name">Name of the input, for error messages</param>
+  void readInput(std::istream& input, const char* source_name);
+
+  /// <summary>
+  /// Passes a line or output on to the checking stage. In low memory mode,
+  /// handles it straight away instead.
+  /// </summary>
+  void passItem(const stream_item& item);
+
+  /// <summary>
+  /// Writes an item's output, or the failure of its line if it wasn't
+  /// justified.
+  /// </summary>
+  /// <param name="item">Item to write</param>
+  /// <param name="justified">For a line, the result of checking it</param>
+  void writeItem(const stream_item& item, bool justified);
+
+  /// <summary>
+  /// Passes on anything the reader has written to an output buffer, then
+  /// empties it.
+  /// </summary>
+  /// <param name="buffer">Buffer the reader writes to</param>
+  /// <param name="is_error">Whether the buffer is for error messages</param>
+  void passOutput(std::stringstream& buffer, bool is_error);
+
+  /// <summary>
+  /// Waits for the reading stage to pass something on, then takes all of
+  /// it.
+  /// </summary>
+  /// <param name="items">Set to the items taken</param>
+  /// <returns>False if reading is done and there's nothing left</returns>
+  bool takeItems(std::vector<stream_item>& items);
+
+  /// <summary>
+  /// The checking stage's work on items taken from the queue. Checks the
+  /// lines, and writes the failures and output in order. With a pool of more
+  /// than one thread, the lines taken together are checked in parallel before
+  /// any are written; otherwise each line is written as soon as it's checked.
+  /// </summary>
+  /// <param name="items">Items to handle</param>
+  /// <param name="pool">Threads to check lines on, or null</param>
+  void checkItems(std::vector<stream_item>& items, WorkPool* pool);
+
+  public:
+  StreamVerifier();
+
+  /// <summary>
+  /// Sets a cache of results from checking lines. Null (the default) for no cache.
+  /// </summary>
+  /// <param name="line_cache">Cache to use. Isn't owned by the verifier.</param>
+  void setCache(VerificationCache* line_cache);
+
+  /// <summary>
+  /// Sets whether to verify in low memory mode, for proofs too big to hold in
+  /// memory. Lines are then checked on the reading thread, and any pool
+  /// passed to run isn't used.
+  /// </summary>
+  /// <param name="enabled">Whether to use low memory mode</param>
+  void setLowMemory(bool enabled);
+
+  /// <summary>
+  /// Reads and verifies a proof from a stream. The input is in the same
+  /// format as a proof file, and ends at the end of the stream or a blank
+  /// line. Output is the same as for verifying a file, without the printout
+  /// of the proof. If a line can't be read, the lines before it are still
+  /// reported but the summary isn't.
+  /// </summary>
+  /// <param name="input">Stream to read the proof from</param>
+  /// <param name="source_name">Name of the input, for error messages</param>
+  /// <param name="pool">Threads to check lines on. If null, lines are checked in sequence.</param>
+  /// <param name="output">Stream for results</param>
+  /// <param name="errors">Stream for error messages</param>
+  /// <returns>True if the proof was read and verification succeeded</returns>
+  bool run(std::istream& input, const char* source_name, WorkPool* pool,
+    std::ostream& output, std::ostream& errors);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "WorkPool.hpp"
+
+using std::mutex;
+using std::thread;
+using std::unique_lock;
+using std::lock_guard;
+
+WorkPool::WorkPool(int thread_count) : current_job(NULL), job_number(0),
+  idle_workers(0), shutting_down(false)
+{
+  if(thread_count < 1) thread_count = 1;
+  for(int i = 0; i < thread_count; i++)
+    queues.push_back(new worker_queue);
+  for(int i = 0; i < thread_count; i++)
+    threads.push_back(thread(&WorkPool::workerLoop, this, i));
+}
+
+WorkPool::~WorkPool()
+{
+  {
+    lock_guard<mutex> guard(state_lock);
+    shutting_down = true;
+  }
+  work_ready.notify_all();
+  for(unsigned int i = 0; i < threads.size(); i++)
+    threads[i].join();
+  for(unsigned int i = 0; i < queues.size(); i++)
+    delete queues[i];
+}
+
+int WorkPool::threadCount()
+{ return threads.size(); }
+
+//Deals the tasks out to the workers in contiguous blocks, then wakes them and
+//waits until every worker has found nothing left to do.
+void WorkPool::run(ParallelTask& job, int task_count)
+{
+  if(task_count <= 0) return;
+  
+  int workers = queues.size();
+  for(int i = 0; i < workers; i++)
+  {
+    int first = (int)((long long)task_count * i / workers);
+    int last = (int)((long long)task_count * (i+1) / workers);
+    lock_guard<mutex> guard(queues[i]->lock);
+    for(int task = first; task < last; task++)
+      queues[i]->tasks.push_back(task);
+  }
+  
+  unique_lock<mutex> guard(state_lock);
+  current_job = &job;
+  idle_workers = 0;
+  job_number++;
+  work_ready.notify_all();
+  while(idle_workers < workers)
+    work_done.wait(guard);
+  current_job = NULL;
+}
+
+void WorkPool::workerLoop(int worker)
+{
+  int last_job = 0;
+  while(true)
+  {
+    ParallelTask* job;
+    {
+      unique_lock<mutex> guard(state_lock);
+      while(!shutting_down && job_number == last_job)
+        work_ready.wait(guard);
+      if(shutting_down) return;
+      last_job = job_number;
+      job = current_job;
+    }
+    
+    int task;
+    while(takeTask(worker, task))
+      job->runTask(task);
+    
+    //No tasks are added during a job, so once none are left to take this
+    //worker is done with it.
+    {
+      lock_guard<mutex> guard(state_lock);
+      idle_workers++;
+    }
+    work_done.notify_one();
+  }
+}
+
+//Own queue is taken from the front and other queues from the back, so owner
+//and thief work from opposite ends of a block.
+bool WorkPool::takeTask(int worker, int& task)
+{
+  {
+    worker_queue* own = queues[worker];
+    lock_guard<mutex> guard(own->lock);
+    if(!own->tasks.empty())
+    {
+      task = own->tasks.front();
+      own->tasks.pop_front();
+      return true;
+    }
+  }
+  
+  int workers = queues.size();
+  for(int i = 1; i < workers; i++)
+  {
+    worker_queue* victim = queues[(worker+i) % workers];
+    lock_guard<mutex> guard(victim->lock);
+    if(!victim->tasks.empty())
+    {
+      task = victim->tasks.back();
+      victim->tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
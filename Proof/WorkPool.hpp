@@ -0,0 +1,103 @@
+#ifndef __WORK_POOL_H_
+#define __WORK_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// A job that can be split into independent, numbered tasks, such as checking
+/// each line of a proof. Subclasses say how to do one task; WorkPool decides
+/// which thread does which.
+/// </summary>
+class ParallelTask
+{
+  public:
+  virtual ~ParallelTask() {}
+
+  /// <summary>
+  /// Does one task of the job. Called from worker threads, so it must only
+  /// change state belonging to that task.
+  /// </summary>
+  /// <param name="index">Task number, from 0 to the task count - 1</param>
+  virtual void runTask(int index) = 0;
+};
+
+/// <summary>
+/// Fixed set of worker threads which run the tasks of a ParallelTask. Each
+/// worker starts with a contiguous share of the tasks in its own queue, and
+/// works through it from the front. A worker which runs out takes tasks from
+/// the back of another worker's queue (work stealing), so a few expensive
+/// tasks don't leave the other threads idle.
+///
+/// The threads are started when the pool is constructed and kept until it's
+/// destroyed, so one pool can be used to run many jobs.
+/// </summary>
+class WorkPool
+{
+  private:
+  /// <summary>
+  /// The tasks waiting for one worker.
+  /// </summary>
+  struct worker_queue
+  {
+    std::mutex lock;
+    std::deque<int> tasks;
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<worker_queue*> queues;
+
+  std::mutex state_lock;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+  ParallelTask* current_job;
+  int job_number; //Incremented for each job, so workers can tell it's new
+  int idle_workers;
+  bool shutting_down;
+
+  /// <summary>
+  /// Main function of each worker thread. Waits for a job, takes tasks until
+  /// there are none left anywhere, then waits for the next.
+  /// </summary>
+  /// <param name="worker">Index of the worker's queue</param>
+  void workerLoop(int worker);
+
+  /// <summary>
+  /// Gets the next task for a worker: the front of its own queue, or else the
+  /// back of another worker's.
+  /// </summary>
+  /// <param name="worker">Index of the worker's queue</param>
+  /// <param name="task">Set to the task number if one is found</param>
+  /// <returns>False if there are no tasks left in any queue</returns>
+  bool takeTask(int worker, int& task);
+
+  public:
+  /// <summary>
+  /// Starts the worker threads.
+  /// </summary>
+  /// <param name="thread_count">Number of workers. At least one is started.</param>
+  WorkPool(int thread_count);
+
+  /// <summary>
+  /// Stops and joins the worker threads. Must not be called during run.
+  /// </summary>
+  ~WorkPool();
+
+  /// <summary>
+  /// Number of worker threads in the pool.
+  /// </summary>
+  int threadCount();
+
+  /// <summary>
+  /// Runs every task of a job on the worker threads, and waits for them all
+  /// to finish. Tasks may run in any order.
+  /// </summary>
+  /// <param name="job">Job to run</param>
+  /// <param name="task_count">Number of tasks in the job</param>
+  void run(ParallelTask& job, int task_count);
+};
+
+#endif
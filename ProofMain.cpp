@@ -1,29 +1,44 @@
 #include "Proof.hpp"
 #include "ProofReader.hpp"
+#include "ProofRules.hpp"
+#include "BinaryProof.hpp"
+#include "BatchVerifier.hpp"
+#include "StreamVerifier.hpp"
+#include "WorkPool.hpp"
+#include "VerificationCache.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <thread>
+
+#if defined(EMBED_DEFAULT_RULES)
+#include "DefaultRules.hpp"
+#endif
 
 using std::cout;
 using std::cerr;
 using std::endl;
 
 /// <summary>
-/// Runs the program. Expects one argument after the executable name, which the
-/// name of an input file to read into a Proof object. That Proof will then be
-/// verified.
+/// Prints how to run the program.
 /// </summary>
-int main(int nargs, char** args)
+void printUsage(const char* program)
+{
+  cerr << "Usage: " << program << " [-j <threads>] [-c <cache directory>] [-f] [-g] [-r] [-m] <input filename | ->\n";
+  cerr << "       " << program << " [-j <threads>] [-c <cache directory>] [-f] [-g] [-r] [-v] -b <file | directory | @manifest>...\n";
+}
+
+/// <summary>
+/// Verifies one proof file, printing the proof and the result of verification.
+/// </summary>
+int verifySingleFile(const char* filename, int thread_count, VerificationCache* cache)
 {
-  if(nargs != 2)
-  {
-    //Input file not specified, or additional arguments are present
-    cerr << "Usage: " << args[0] << " <input filename>\n";
-    return 0;
-  }
-  
   Proof p;
   ProofReader r;
+  p.setCache(cache);
   r.setTarget(&p);
-  if(!r.readFile(args[1]))
+  if(!r.readFile(filename))
   {
     //IO error
     cerr << "Program terminated: errors encountered while reading file(s)\n";
@@ -31,7 +46,202 @@ int main(int nargs, char** args)
   }
   
   p.printProof();
-  p.verifyProof();
+  if(thread_count > 1)
+  {
+    WorkPool pool(thread_count);
+    p.verifyProof(&pool);
+  }
+  else
+    p.verifyProof();
+  return 0;
+}
+
+/// <summary>
+/// Verifies a proof read from standard input, printing results as lines are
+/// read rather than waiting for the whole proof.
+/// </summary>
+int verifyStandardInput(int thread_count, VerificationCache* cache, bool low_memory)
+{
+  StreamVerifier stream;
+  stream.setCache(cache);
+  stream.setLowMemory(low_memory);
+  if(thread_count > 1 && !low_memory)
+  {
+    WorkPool pool(thread_count);
+    stream.run(std::cin, "standard input", &pool, cout, cerr);
+  }
+  else
+    stream.run(std::cin, "standard input", NULL, cout, cerr);
+  return 0;
+}
+
+/// <summary>
+/// Verifies a proof file in low memory mode, reporting each line as it's
+/// checked rather than printing the proof first.
+/// </summary>
+int verifyFileLowMemory(const char* filename, VerificationCache* cache)
+{
+  std::ifstream input(filename);
+  if(!input.is_open())
+  {
+    cerr << "Error: file " << filename << " could not be opened\n";
+    cerr << "Program terminated: errors encountered while reading file(s)\n";
+    return 0;
+  }
+  
+  //Lines are read as text as they're checked, which a binary proof can't be
+  char header[BINARY_PROOF_HEADER_SIZE];
+  input.read(header, BINARY_PROOF_HEADER_SIZE);
+  if(BinaryProof::isBinary(header, input.gcount()))
+  {
+    cerr << "Error: file " << filename << " is a binary proof, which can't be read in low memory mode\n";
+    cerr << "Program terminated: errors encountered while reading file(s)\n";
+    return 0;
+  }
+  input.clear();
+  input.seekg(0);
+  
+  StreamVerifier stream;
+  stream.setCache(cache);
+  stream.setLowMemory(true);
+  stream.run(input, filename, NULL, cout, cerr);
   return 0;
 }
 
+/// <summary>
+/// Runs the program. Expects the name of an input file after the executable
+/// name, which will be read into a Proof object. The file may be a text proof
+/// or a binary one written by proofConverter (see BinaryProof). That Proof will then be
+/// verified. The file name may be preceded by "-j <threads>" to check the
+/// lines of the proof on that many threads. A file name of "-" reads the
+/// proof from standard input instead, and reports each line as soon as it's
+/// read and checked (see StreamVerifier).
+///
+/// With -m, the proof is verified in low memory mode (see
+/// Proof::setLowMemory), for proofs too big to hold in memory. Lines are
+/// reported as they're checked, as for standard input, and -j is ignored.
+///
+/// With -b, verifies a batch of proof files instead (see BatchVerifier),
+/// printing a result for each and a summary. -j then sets how many files are
+/// verified at once, defaulting to the number of hardware threads, and -v
+/// prints each proof as well. Returns nonzero if any proof in the batch
+/// didn't pass.
+///
+/// Results of checking lines are kept in memory (see VerificationCache), so a
+/// step repeated within a proof or batch is only worked out once, except
+/// with -m. With "-c <directory>", they're also kept in that directory, so
+/// lines checked in an earlier run don't need to be worked out again.
+///
+/// With -f (in either mode), lines are checked by truth table before their
+/// rule is applied, so that wrong lines are rejected quickly (see
+/// ProofStatement::setSemanticPrefilter).
+///
+/// With -g, a proof file or each proof in a batch is first checked for a
+/// goal that doesn't follow from its premises, which is reported without
+/// checking any lines, saying that they were skipped (see
+/// Proof::setGoalPrecheck). Not done with -m or for
+/// standard input.
+///
+/// With -r, rules.xml in the working directory (or a rule pack compiled from
+/// it) adds to the built in rules (see ProofRules::setExternalRules).
+/// Without built in rules, it's always read.
+/// </summary>
+int main(int nargs, char** args)
+{
+#if defined(EMBED_DEFAULT_RULES)
+  ProofRules::setBuiltInRules(default_rule_pack, default_rule_pack_size);
+#endif
+  int thread_count = 0;
+  bool verbose = false;
+  bool low_memory = false;
+  const char* cache_dir = NULL;
+  int arg_index = 1;
+  for(; arg_index < nargs && args[arg_index][0] == '-'; arg_index++)
+  {
+    if(strcmp(args[arg_index], "-j") == 0 && arg_index+1 < nargs)
+    {
+      thread_count = atoi(args[++arg_index]);
+      if(thread_count < 1)
+      {
+        printUsage(args[0]);
+        return 0;
+      }
+    }
+    else if(strcmp(args[arg_index], "-c") == 0 && arg_index+1 < nargs)
+      cache_dir = args[++arg_index];
+    else if(strcmp(args[arg_index], "-v") == 0)
+      verbose = true;
+    else if(strcmp(args[arg_index], "-m") == 0)
+      low_memory = true;
+    else if(strcmp(args[arg_index], "-f") == 0)
+      ProofStatement::setSemanticPrefilter(true);
+    else if(strcmp(args[arg_index], "-g") == 0)
+      Proof::setGoalPrecheck(true);
+    else if(strcmp(args[arg_index], "-r") == 0)
+      ProofRules::setExternalRules(true);
+    else if(strcmp(args[arg_index], "-b") == 0 || strcmp(args[arg_index], "-") == 0)
+      break;
+    else
+    {
+      printUsage(args[0]);
+      return 0;
+    }
+  }
+  
+  bool batch_mode = arg_index < nargs && strcmp(args[arg_index], "-b") == 0;
+  if((!batch_mode && (nargs != arg_index+1 || verbose)) || (batch_mode && low_memory))
+  {
+    //Input file not specified, or additional arguments are present
+    printUsage(args[0]);
+    return 0;
+  }
+  
+  //Without a usable cache directory, results are only kept for this run, so
+  //repeated steps are checked once. Not in low memory mode, where that would
+  //mean keeping something for every line.
+  VerificationCache cache;
+  VerificationCache* line_cache = low_memory ? NULL : &cache;
+  if(cache_dir != NULL)
+  {
+    if(cache.open(cache_dir))
+      line_cache = &cache;
+    else
+      cerr << "Warning: cache directory " << cache_dir << " could not be used\n";
+  }
+  
+  if(!batch_mode)
+  {
+    int result;
+    if(strcmp(args[arg_index], "-") == 0)
+      result = verifyStandardInput((thread_count == 0) ? 1 : thread_count, line_cache, low_memory);
+    else if(low_memory)
+      result = verifyFileLowMemory(args[arg_index], line_cache);
+    else
+      result = verifySingleFile(args[arg_index], (thread_count == 0) ? 1 : thread_count,
+        line_cache);
+    if(line_cache != NULL) line_cache->save();
+    return result;
+  }
+  
+  //Batch mode
+  BatchVerifier batch;
+  batch.setVerbose(verbose);
+  batch.setCache(line_cache);
+  for(arg_index++; arg_index < nargs; arg_index++)
+  {
+    if(!batch.addPath(args[arg_index], cerr))
+      return 1;
+  }
+  if(batch.fileCount() == 0)
+  {
+    printUsage(args[0]);
+    return 1;
+  }
+  
+  if(thread_count == 0)
+    thread_count = std::thread::hardware_concurrency();
+  WorkPool pool(thread_count);
+  bool all_passed = batch.run(pool, cout);
+  if(line_cache != NULL) line_cache->save();
+  return all_passed ? 0 : 1;
+}
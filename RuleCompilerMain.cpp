@@ -0,0 +1,45 @@
+#include "ProofRules.hpp"
+#include "RulePack.hpp"
+#include "MappedFile.hpp"
+#include <iostream>
+
+using std::cerr;
+using std::cout;
+
+/// <summary>
+/// Compiles a rules file to a rule pack (see RulePack), which the verifier
+/// loads instead of parsing the rules file as long as the rules file hasn't
+/// changed since. Optionally takes the name of the rules file and of the pack
+/// to write; these default to the files the verifier reads.
+/// </summary>
+int main(int nargs, char** args)
+{
+  if(nargs > 3)
+  {
+    cerr << "Usage: " << args[0] << " [<rules filename> [<rule pack filename>]]\n";
+    return 1;
+  }
+  const char* rules_filename = (nargs > 1) ? args[1] : DEFAULT_RULES_FILENAME;
+  const char* pack_filename = (nargs > 2) ? args[2] : DEFAULT_RULE_PACK_FILENAME;
+
+  MappedFile source;
+  if(!source.open(rules_filename))
+  {
+    cerr << "Error: rules file " << rules_filename << " could not be opened.\n";
+    return 1;
+  }
+  justification_map rules;
+  if(!ProofRules::parseRules(source.data(), source.size(), rules))
+    return 2;
+
+  bool written = RulePack::write(rules, RulePack::checksum(source.data(), source.size()),
+    pack_filename);
+  if(written)
+    cout << "Compiled " << rules.size() << " rules to " << pack_filename << "\n";
+  else
+    cerr << "Error: rule pack " << pack_filename << " could not be written.\n";
+
+  for(justification_map::iterator itr = rules.begin(); itr != rules.end(); itr++)
+    delete itr->second;
+  return written ? 0 : 1;
+}
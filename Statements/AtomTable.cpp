@@ -0,0 +1,96 @@
+#include "AtomTable.hpp"
+#include "StatementTree.hpp"
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+using std::cerr;
+using std::endl;
+using std::pair;
+using std::lock_guard;
+using std::mutex;
+
+atom_index AtomTable::ids;
+atom_entry* AtomTable::chunks[ATOM_MAX_CHUNKS];
+std::atomic<int> AtomTable::atom_count(0);
+mutex AtomTable::intern_lock;
+bool AtomTable::full_reported = false;
+
+//Returns the id for the given name, assigning the next free id if it hasn't
+//been seen before.
+int AtomTable::intern(const char* name, int length)
+{
+  unsigned long long hash = hashName(name, length);
+  lock_guard<mutex> guard(intern_lock);
+  pair<atom_index::iterator, atom_index::iterator> range = ids.equal_range(hash);
+  for(atom_index::iterator itr = range.first; itr != range.second; itr++)
+  {
+    char* existing = entry(itr->second).name;
+    if(strncmp(existing, name, length) == 0 && existing[length] == '\0')
+      return itr->second;
+  }
+  
+  //New name. There must be room for it in the last chunk or a new one.
+  int id = atom_count.load();
+  if(id >= ATOM_MAX_CHUNKS * ATOM_CHUNK_SIZE)
+  {
+    if(!full_reported)
+      cerr << "Error: more than " << ATOM_MAX_CHUNKS * ATOM_CHUNK_SIZE <<
+        " distinct propositions, sentences with new ones are treated as not well-formed." << endl;
+    full_reported = true;
+    return -1;
+  }
+  char* stored_name = new char[length+1];
+  memcpy(stored_name, name, length);
+  stored_name[length] = '\0';
+  
+  //Start a new chunk if the last one is full. The entry is filled in before
+  //the count is raised, so anyone who can see the id can see the entry.
+  if(id % ATOM_CHUNK_SIZE == 0)
+    chunks[id / ATOM_CHUNK_SIZE] = new atom_entry[ATOM_CHUNK_SIZE];
+  atom_entry& added = entry(id);
+  added.name = stored_name;
+  added.name_hash = hash;
+  added.is_valid = isValidName(name, length);
+  ids.insert(atom_index::value_type(hash, id));
+  atom_count.store(id+1);
+  return id;
+}
+
+//FNV-1a hash
+unsigned long long AtomTable::hashName(const char* name, int length)
+{
+  unsigned long long hash = 14695981039346656037ULL;
+  for(int i = 0; i < length; i++)
+  {
+    hash ^= (unsigned char)name[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+atom_entry& AtomTable::entry(int id)
+{ return chunks[id / ATOM_CHUNK_SIZE][id % ATOM_CHUNK_SIZE]; }
+
+const char* AtomTable::name(int id)
+{ return entry(id).name; }
+
+unsigned long long AtomTable::nameHash(int id)
+{ return entry(id).name_hash; }
+
+bool AtomTable::isValidName(int id)
+{ return entry(id).is_valid; }
+
+//Not empty, and no operator or parenthesis characters
+bool AtomTable::isValidName(const char* name, int length)
+{
+  if(length == 0) return false;
+  for(int i = 0; i < length; i++)
+    if(name[i] == '(' || name[i] == ')' ||
+      StatementTree::operatorType(name[i]) != StatementTree::ATOM)
+      return false;
+  return true;
+}
+
+int AtomTable::size()
+{ return atom_count.load(); }
@@ -0,0 +1,120 @@
+#ifndef __ATOM_TABLE_H_
+#define __ATOM_TABLE_H_
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#define ATOM_CHUNK_SIZE 1024
+#define ATOM_MAX_CHUNKS 65536 //Room for 64M distinct propositions
+
+/// <summary>
+/// Index from the hash of a proposition name to its id.
+/// </summary>
+typedef std::unordered_multimap<unsigned long long, int> atom_index;
+
+/// <summary>
+/// What the table stores about one proposition.
+/// </summary>
+struct atom_entry
+{
+  char* name;
+  unsigned long long name_hash;
+  bool is_valid;
+};
+
+/// <summary>
+/// Static class which interns the names of atomic propositions. Each distinct
+/// name is given a dense integer id (0, 1, 2...) the first time it's seen,
+/// and keeps that id for the rest of the process. Statement trees store the
+/// id rather than their own copy of the name, so comparing atoms is an
+/// integer comparison and passes over a sentence can index per-atom data
+/// by id.
+///
+/// Entries are stored in fixed-size chunks which are never moved, so looking
+/// up an id needs no lock even while other threads are adding names. Only
+/// intern locks the table.
+/// </summary>
+class AtomTable
+{
+  private:
+  static atom_index ids;
+  static atom_entry* chunks[ATOM_MAX_CHUNKS];
+  static std::atomic<int> atom_count;
+  static std::mutex intern_lock;
+  static bool full_reported; //Whether intern has said the table is full
+
+  /// <summary>
+  /// Gets the entry for an id.
+  /// </summary>
+  static atom_entry& entry(int id);
+
+  public:
+
+  /// <summary>
+  /// Gets the id for a proposition name, adding it to the table if it's new.
+  /// </summary>
+  /// <param name="name">
+  ///   Start of the name. Does not need to be null-terminated.
+  /// </param>
+  /// <param name="length">Number of characters in the name</param>
+  /// <returns>
+  ///   Id of the proposition, or -1 if it's new and the table already has
+  ///   ATOM_MAX_CHUNKS * ATOM_CHUNK_SIZE names. An error is printed the first
+  ///   time that happens.
+  /// </returns>
+  static int intern(const char* name, int length);
+
+  /// <summary>
+  /// The hash function used for names in the table (FNV-1a). Doesn't add
+  /// anything to the table.
+  /// </summary>
+  /// <param name="name">
+  ///   Start of the name. Does not need to be null-terminated.
+  /// </param>
+  /// <param name="length">Number of characters in the name</param>
+  /// <returns>Hash of the name</returns>
+  static unsigned long long hashName(const char* name, int length);
+
+  /// <summary>
+  /// Gets the name of a proposition.
+  /// </summary>
+  /// <param name="id">Id returned by intern</param>
+  /// <returns>Null-terminated name, owned by the table</returns>
+  static const char* name(int id);
+
+  /// <summary>
+  /// Hash of a proposition's name. Unlike the id, this doesn't depend on the
+  /// order names were seen in, so it's the same across runs.
+  /// </summary>
+  /// <param name="id">Id returned by intern</param>
+  /// <returns>Hash of the name</returns>
+  static unsigned long long nameHash(int id);
+
+  /// <summary>
+  /// Whether a name is allowed for an atomic proposition, i.e. it is not
+  /// empty and has no operator or parenthesis characters. Worked out once
+  /// when the name is added.
+  /// </summary>
+  /// <param name="id">Id returned by intern</param>
+  /// <returns>True if the name is well-formed</returns>
+  static bool isValidName(int id);
+
+  /// <summary>
+  /// Checks a name the way isValidName does, without adding it to the table.
+  /// </summary>
+  /// <param name="name">
+  ///   Start of the name. Does not need to be null-terminated.
+  /// </param>
+  /// <param name="length">Number of characters in the name</param>
+  /// <returns>True if the name is well-formed</returns>
+  static bool isValidName(const char* name, int length);
+
+  /// <summary>
+  /// Number of distinct propositions seen so far. Ids are below this.
+  /// </summary>
+  /// <returns>Number of propositions</returns>
+  static int size();
+};
+
+#endif
@@ -0,0 +1,164 @@
+#include "DecisionDiagram.hpp"
+#include <climits>
+#include <utility>
+
+using std::unordered_map;
+using std::vector;
+
+DecisionDiagram::DecisionDiagram(size_t max_nodes) : node_limit(max_nodes)
+{
+  decision_node terminal = { INT_MAX, 0, 0 };
+  nodes.push_back(terminal);
+  terminal.low = terminal.high = 1;
+  nodes.push_back(terminal);
+  decision_cache_entry empty = { -1, 0, 0, 0 };
+  operation_cache.assign(DECISION_DIAGRAM_MIN_CACHE, empty);
+}
+
+//Atoms already given levels keep them, so this only works before building.
+void DecisionDiagram::setVariableOrder(const vector<int>& atom_ids)
+{
+  for(size_t i = 0; i < atom_ids.size(); i++)
+    levelOf(atom_ids[i]);
+}
+
+int DecisionDiagram::levelOf(int atom_id)
+{
+  unordered_map<int, int>::iterator found = levels.find(atom_id);
+  if(found == levels.end())
+    found = levels.insert(std::make_pair(atom_id, (int)levels.size())).first;
+  return found->second;
+}
+
+//The cache grows along with the diagram, losing what's in it, since it only
+//saves work.
+int DecisionDiagram::makeNode(int level, int low, int high)
+{
+  if(low == high) return low;
+  decision_node node = { level, low, high };
+  unordered_map<decision_node, int, decision_node_hash, decision_node_equal>::iterator found =
+    unique_table.find(node);
+  if(found != unique_table.end()) return found->second;
+  if(nodes.size() >= node_limit) return DECISION_DIAGRAM_OVERFLOW;
+
+  int index = nodes.size();
+  nodes.push_back(node);
+  unique_table[node] = index;
+  if(nodes.size() > operation_cache.size() && operation_cache.size() < DECISION_DIAGRAM_MAX_CACHE)
+  {
+    decision_cache_entry empty = { -1, 0, 0, 0 };
+    operation_cache.assign(operation_cache.size() * 2, empty);
+  }
+  return index;
+}
+
+//Cases that don't need recursing are settled first. The terminals test no
+//variable, so their cofactors are themselves.
+int DecisionDiagram::apply(int op, int left, int right)
+{
+  switch(op)
+  {
+  case StatementTree::NOT:
+    if(left <= DECISION_DIAGRAM_TRUE) return DECISION_DIAGRAM_TRUE - left;
+    right = 0;
+    break;
+  case StatementTree::AND:
+    if(left == DECISION_DIAGRAM_FALSE || right == DECISION_DIAGRAM_FALSE) return DECISION_DIAGRAM_FALSE;
+    if(left == DECISION_DIAGRAM_TRUE || left == right) return right;
+    if(right == DECISION_DIAGRAM_TRUE) return left;
+    break;
+  case StatementTree::OR:
+    if(left == DECISION_DIAGRAM_TRUE || right == DECISION_DIAGRAM_TRUE) return DECISION_DIAGRAM_TRUE;
+    if(left == DECISION_DIAGRAM_FALSE || left == right) return right;
+    if(right == DECISION_DIAGRAM_FALSE) return left;
+    break;
+  case StatementTree::IMPLIES:
+    if(left == DECISION_DIAGRAM_FALSE || right == DECISION_DIAGRAM_TRUE || left == right)
+      return DECISION_DIAGRAM_TRUE;
+    if(left == DECISION_DIAGRAM_TRUE) return right;
+    if(right == DECISION_DIAGRAM_FALSE) return apply(StatementTree::NOT, left, 0);
+    break;
+  case StatementTree::IFF:
+    if(left == right) return DECISION_DIAGRAM_TRUE;
+    if(left == DECISION_DIAGRAM_TRUE) return right;
+    if(right == DECISION_DIAGRAM_TRUE) return left;
+    if(left == DECISION_DIAGRAM_FALSE) return apply(StatementTree::NOT, right, 0);
+    if(right == DECISION_DIAGRAM_FALSE) return apply(StatementTree::NOT, left, 0);
+    break;
+  }
+
+  //Operands of symmetric operators are ordered so both orders share an entry
+  if(op != StatementTree::IMPLIES && op != StatementTree::NOT && left > right)
+    std::swap(left, right);
+  size_t slot = (((size_t)op * 0x9E3779B1u + (size_t)left) * 0x85EBCA6Bu + (size_t)right) *
+    0xC2B2AE35u;
+  slot = (slot ^ (slot >> 15)) & (operation_cache.size() - 1);
+  decision_cache_entry& entry = operation_cache[slot];
+  if(entry.op == op && entry.left == left && entry.right == right) return entry.result;
+
+  decision_node left_node = nodes[left];
+  decision_node right_node = nodes[right];
+  int level = (left_node.level < right_node.level) ? left_node.level : right_node.level;
+  int left_low = (left_node.level == level) ? left_node.low : left;
+  int left_high = (left_node.level == level) ? left_node.high : left;
+  int right_low = (right_node.level == level) ? right_node.low : right;
+  int right_high = (right_node.level == level) ? right_node.high : right;
+
+  int low = apply(op, left_low, right_low);
+  if(low == DECISION_DIAGRAM_OVERFLOW) return low;
+  int high = apply(op, left_high, right_high);
+  if(high == DECISION_DIAGRAM_OVERFLOW) return high;
+  int result = makeNode(level, low, high);
+  if(result == DECISION_DIAGRAM_OVERFLOW) return result;
+
+  //The cache may have grown and moved while recursing
+  decision_cache_entry& stored = operation_cache[slot & (operation_cache.size() - 1)];
+  stored.op = op;
+  stored.left = left;
+  stored.right = right;
+  stored.result = result;
+  return result;
+}
+
+//Builds the tree's nodes children first. Iterative so that very deep trees
+//don't exhaust the stack.
+int DecisionDiagram::build(StatementTree* tree)
+{
+  vector<StatementTree*> pending(1, tree);
+  while(!pending.empty())
+  {
+    StatementTree* node = pending.back();
+    if(tree_nodes.find(node) != tree_nodes.end())
+    {
+      pending.pop_back();
+      continue;
+    }
+
+    bool children_built = true;
+    for(child_itr itr = node->begin(); itr != node->end(); itr++)
+    {
+      if(tree_nodes.find(*itr) == tree_nodes.end())
+      {
+        pending.push_back(*itr);
+        children_built = false;
+      }
+    }
+    if(!children_built) continue;
+    pending.pop_back();
+
+    int result;
+    if(node->nodeType() == StatementTree::ATOM)
+      result = makeNode(levelOf(node->atomId()), DECISION_DIAGRAM_FALSE, DECISION_DIAGRAM_TRUE);
+    else
+      result = apply(node->nodeType(), tree_nodes[node->begin()[StatementTree::LEFT]],
+        tree_nodes[node->begin()[StatementTree::RIGHT]]);
+    if(result != DECISION_DIAGRAM_OVERFLOW && !node->isAffirmed())
+      result = apply(StatementTree::NOT, result, 0);
+    if(result == DECISION_DIAGRAM_OVERFLOW) return result;
+    tree_nodes[node] = result;
+  }
+  return tree_nodes[tree];
+}
+
+size_t DecisionDiagram::nodeCount()
+{ return nodes.size(); }
@@ -0,0 +1,153 @@
+#ifndef __DECISION_DIAGRAM_H_
+#define __DECISION_DIAGRAM_H_
+
+#include "StatementTree.hpp"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#define DECISION_DIAGRAM_FALSE 0
+#define DECISION_DIAGRAM_TRUE 1
+#define DECISION_DIAGRAM_OVERFLOW -1 //Returned instead of a node once the limit is reached
+#define DECISION_DIAGRAM_NODE_LIMIT (1 << 18)
+#define DECISION_DIAGRAM_MIN_CACHE 1024
+#define DECISION_DIAGRAM_MAX_CACHE (1 << 18)
+
+/// <summary>
+/// One node of a DecisionDiagram: if the variable at this level is false,
+/// the function is that of the low node, otherwise that of the high node.
+/// The two terminal nodes have a level below every variable.
+/// </summary>
+struct decision_node
+{
+  int level;
+  int low;
+  int high;
+};
+
+/// <summary>
+/// Hash function for decision_node, for the unique table.
+/// </summary>
+struct decision_node_hash
+{
+  size_t operator()(const decision_node& node) const
+  {
+    size_t hash = ((size_t)node.level * 31 + (size_t)node.low) * 31 + (size_t)node.high;
+    return hash ^ (hash >> 17);
+  }
+};
+
+/// <summary>
+/// Compares nodes by contents, for the unique table.
+/// </summary>
+struct decision_node_equal
+{
+  bool operator()(const decision_node& first, const decision_node& second) const
+  {
+    return first.level == second.level && first.low == second.low &&
+      first.high == second.high;
+  }
+};
+
+/// <summary>
+/// A result kept in the operation cache. An op of -1 marks an empty slot.
+/// </summary>
+struct decision_cache_entry
+{
+  int op;
+  int left;
+  int right;
+  int result;
+};
+
+/// <summary>
+/// Reduced ordered binary decision diagrams, for working with sentences that
+/// have too many atoms for a TruthTable. Each sentence built is turned into
+/// a node standing for its truth function, with the atoms tested in a fixed
+/// order from the root down. No node is made twice (they're looked up in a
+/// hashed unique table) and no node has the same low and high nodes, so two
+/// sentences are logically equivalent exactly when they're built into the
+/// same node. Results of operations on nodes are kept in a cache, so each
+/// pair of nodes is only combined once.
+///
+/// Nodes are numbered, with DECISION_DIAGRAM_FALSE and DECISION_DIAGRAM_TRUE
+/// the two terminals. The trees built are kept with their nodes, so a
+/// subtree shared between sentences (which hash-consing makes common) is only
+/// built once. Atoms are told apart by their AtomTable id.
+///
+/// Some sentences have no small diagram in any order, so there's a limit on
+/// how many nodes can be made; past it, building gives
+/// DECISION_DIAGRAM_OVERFLOW.
+/// </summary>
+class DecisionDiagram
+{
+  private:
+  std::vector<decision_node> nodes;
+  std::unordered_map<decision_node, int, decision_node_hash, decision_node_equal> unique_table;
+  std::vector<decision_cache_entry> operation_cache;
+  std::unordered_map<int, int> levels; //Level by atom id
+  std::unordered_map<StatementTree*, int> tree_nodes;
+  size_t node_limit;
+
+  /// <summary>
+  /// Gets the node with a level and children, making it if there isn't one.
+  /// </summary>
+  /// <returns>The node, low if it's the same as high, or DECISION_DIAGRAM_OVERFLOW</returns>
+  int makeNode(int level, int low, int high);
+
+  /// <summary>
+  /// Combines two nodes with an operator, recursing on the variable tested
+  /// nearest the root of either.
+  /// </summary>
+  /// <param name="op">
+  ///   StatementTree node type of the operator. NOT negates left, and right is
+  ///   ignored.
+  /// </param>
+  /// <param name="left">Node for the left operand</param>
+  /// <param name="right">Node for the right operand</param>
+  /// <returns>The resulting node, or DECISION_DIAGRAM_OVERFLOW</returns>
+  int apply(int op, int left, int right);
+
+  /// <summary>
+  /// Level of an atom, giving it the next level down if it doesn't have one.
+  /// </summary>
+  /// <param name="atom_id">AtomTable id</param>
+  /// <returns>Level of the atom</returns>
+  int levelOf(int atom_id);
+
+  public:
+  /// <summary>
+  /// Starts a diagram with just the terminal nodes.
+  /// </summary>
+  /// <param name="max_nodes">Most nodes that can be made</param>
+  DecisionDiagram(size_t max_nodes = DECISION_DIAGRAM_NODE_LIMIT);
+
+  /// <summary>
+  /// Sets the order atoms are tested in, which can change the size of the
+  /// diagrams a great deal. Must be called before anything is built. Atoms
+  /// not listed are put after these, in the order they're first seen when
+  /// building; with no order set, that's the order for all of them.
+  /// </summary>
+  /// <param name="atom_ids">AtomTable ids of atoms, nearest the root first</param>
+  void setVariableOrder(const std::vector<int>& atom_ids);
+
+  /// <summary>
+  /// Builds the node for a sentence, including the negation flag of each of
+  /// its nodes.
+  /// </summary>
+  /// <param name="tree">Sentence to build</param>
+  /// <returns>
+  ///   The sentence's node, which is the same node as for any sentence built
+  ///   that's logically equivalent to it, or DECISION_DIAGRAM_OVERFLOW if
+  ///   there were too many nodes.
+  /// </returns>
+  int build(StatementTree* tree);
+
+  /// <summary>
+  /// Number of nodes made so far, including the terminals.
+  /// </summary>
+  /// <returns>Number of nodes</returns>
+  size_t nodeCount();
+};
+
+#endif
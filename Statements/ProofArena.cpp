@@ -0,0 +1,92 @@
+#include "ProofArena.hpp"
+#include "ProofStatement.hpp"
+#include <unordered_set>
+
+ProofArena::ProofArena() : block_used(ARENA_BLOCK_SIZE)
+{
+  //This space left intentionally blank
+}
+
+//Destroys all the proof lines made in the arena, then frees its blocks.
+//Recycled lines that weren't reused were destroyed already. Tree nodes only
+//the lines were using are free now, so the tree pool is trimmed.
+ProofArena::~ProofArena()
+{
+  std::unordered_set<void*> recycled;
+  for(std::map<size_t, std::vector<void*> >::iterator itr = free_statements.begin();
+    itr != free_statements.end(); itr++)
+    recycled.insert(itr->second.begin(), itr->second.end());
+  for(unsigned int i = 0; i < statements.size(); i++)
+  {
+    if(recycled.count(statements[i]) == 0)
+      statements[i]->~ProofStatement();
+  }
+  for(unsigned int i = 0; i < blocks.size(); i++)
+    delete [] blocks[i];
+  StatementTree::trimPool();
+}
+
+//Bumps the offset into the current block, starting a new block if there isn't
+//room left. Allocations bigger than a block get a block of their own.
+void* ProofArena::allocate(size_t size)
+{
+  size = alignedSize(size);
+  if(size > ARENA_BLOCK_SIZE)
+  {
+    char* block = new char[size];
+    if(blocks.empty())
+      blocks.push_back(block); //block_used is still full, so it's never bumped into
+    else
+      blocks.insert(blocks.end()-1, block); //Keep the current block last
+    return block;
+  }
+  
+  if(block_used + size > ARENA_BLOCK_SIZE)
+  {
+    blocks.push_back(new char[ARENA_BLOCK_SIZE]);
+    block_used = 0;
+  }
+  void* result = blocks.back() + block_used;
+  block_used += size;
+  return result;
+}
+
+//Recycled memory is still listed in statements, so reusing it doesn't list it
+//again.
+void* ProofArena::allocateStatement(size_t size)
+{
+  std::map<size_t, std::vector<void*> >::iterator found = free_statements.find(alignedSize(size));
+  if(found != free_statements.end() && !found->second.empty())
+  {
+    void* result = found->second.back();
+    found->second.pop_back();
+    return result;
+  }
+  
+  void* result = allocate(size);
+  statements.push_back((ProofStatement*)result);
+  return result;
+}
+
+//The constructor threw, so there's no object to destroy. The memory itself
+//stays with the arena.
+void ProofArena::abandonStatement(void* statement)
+{
+  for(unsigned int i = statements.size(); i > 0; i--)
+  {
+    if(statements[i-1] == statement)
+    {
+      statements.erase(statements.begin()+(i-1));
+      return;
+    }
+  }
+}
+
+void ProofArena::recycleStatement(ProofStatement* statement, size_t size)
+{
+  statement->~ProofStatement();
+  free_statements[alignedSize(size)].push_back(statement);
+}
+
+size_t ProofArena::alignedSize(size_t size)
+{ return (size + ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1); }
@@ -0,0 +1,77 @@
+#ifndef __PROOF_ARENA_H_
+#define __PROOF_ARENA_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#define ARENA_BLOCK_SIZE 65536
+#define ARENA_ALIGNMENT 16
+
+class ProofStatement;
+
+/// <summary>
+/// Allocator for the lines of one proof. Objects are carved out of large
+/// blocks by bumping an offset, rather than being allocated one at a time.
+/// When the arena is destroyed, every proof line made in it is destroyed and
+/// the blocks are freed together, along with any StatementTree pool blocks
+/// that were only holding the lines' trees (see StatementTree::trimPool).
+/// Each line still has its destructor run, to give back its references to
+/// its trees, so this takes time in proportion to the number of lines; only
+/// freeing the memory is done a block at a time.
+/// Lines which are no longer needed can also be recycled before then, so
+/// their memory is reused for new lines.
+///
+/// Proof lines are made with "new (arena) ProofStatement(...)"; see the
+/// allocation operators in ProofStatement.
+/// </summary>
+class ProofArena
+{
+  private:
+  std::vector<char*> blocks;
+  size_t block_used;
+  std::vector<ProofStatement*> statements;
+  std::map<size_t, std::vector<void*> > free_statements; //Recycled memory, by allocation size
+
+  /// <summary>
+  /// Rounds a size up to the alignment, which is what allocate actually uses.
+  /// </summary>
+  static size_t alignedSize(size_t size);
+
+  public:
+  ProofArena();
+  ~ProofArena();
+
+  /// <summary>
+  /// Allocates memory which will be freed along with the arena.
+  /// </summary>
+  /// <param name="size">Number of bytes needed</param>
+  /// <returns>Memory aligned to ARENA_ALIGNMENT</returns>
+  void* allocate(size_t size);
+
+  /// <summary>
+  /// Allocates memory for a proof line. The line constructed there will be
+  /// destroyed when the arena is.
+  /// </summary>
+  /// <param name="size">Size of the ProofStatement (sub)class</param>
+  /// <returns>Memory for the proof line</returns>
+  void* allocateStatement(size_t size);
+
+  /// <summary>
+  /// Stops tracking memory from allocateStatement, for when the proof line's
+  /// constructor didn't finish.
+  /// </summary>
+  /// <param name="statement">Memory returned by allocateStatement</param>
+  void abandonStatement(void* statement);
+
+  /// <summary>
+  /// Destroys a proof line before the arena is destroyed, and keeps its
+  /// memory to be used for the next line of the same size. Nothing may use
+  /// the line afterwards.
+  /// </summary>
+  /// <param name="statement">Proof line made in this arena</param>
+  /// <param name="size">Size of the line's class, as given to allocateStatement</param>
+  void recycleStatement(ProofStatement* statement, size_t size);
+};
+
+#endif
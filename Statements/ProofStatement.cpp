@@ -1,4 +1,6 @@
 #include "ProofStatement.hpp"
+#include "VerificationCache.hpp"
+#include "TruthTable.hpp"
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -8,17 +10,39 @@ using std::cerr;
 using std::endl;
 using std::stringstream;
 using std::string;
+using std::vector;
+
+#define PREFILTER_BLOCKS 16 //Exhaustive up to 12 atoms
+
+bool ProofStatement::semantic_prefilter = false;
 
 ProofStatement::ProofStatement(const char* input, bool is_assump) : parent(NULL),
-   reason(NULL), is_assumption(is_assump), fail_type(NO_FAILURE)
-{ data = new StatementTree(input); }
+   depth(0), scope_open(-1), scope_close(-1), reason(NULL), is_assumption(is_assump),
+   fail_type(NO_FAILURE)
+{ data = StatementTree::create(input); }
 
 ProofStatement::ProofStatement(StatementTree* input, bool is_assump) : parent(NULL),
-  reason(NULL), is_assumption(is_assump), fail_type(NO_FAILURE)
-{ data = new StatementTree(*input); }
+  depth(0), scope_open(-1), scope_close(-1), reason(NULL), is_assumption(is_assump),
+  fail_type(NO_FAILURE)
+{ data = StatementTree::create(*input); }
 
 ProofStatement::~ProofStatement()
-{ delete data; }
+{ StatementTree::release(data); }
+
+//Proof lines live in the arena of their proof
+void* ProofStatement::operator new(size_t size, ProofArena& arena)
+{ return arena.allocateStatement(size); }
+
+//Only called if a constructor throws, in which case the arena shouldn't
+//destroy the line later.
+void ProofStatement::operator delete(void* statement, ProofArena& arena)
+{ arena.abandonStatement(statement); }
+
+//Lines are destroyed by their arena, which frees the memory itself
+void ProofStatement::operator delete(void*)
+{
+  //This space left intentionally blank
+}
 
 //Returns the sentence tree if this is a normal statement, null if this is a subproof
 StatementTree* ProofStatement::getStatementData()
@@ -29,8 +53,9 @@ StatementTree* ProofStatement::getAssumption()
 { return NULL; }
 
 //Returns true if this statement is a consequence of its antecedents by the stored
-//rule. sets the fail_type flag if it is not justified.
-bool ProofStatement::isJustified()
+//rule. sets the fail_type flag if it is not justified. Premises and other lines
+//without antecedents are quick to check, so they aren't cached.
+bool ProofStatement::isJustified(VerificationCache* cache)
 {
   if(!data->isValid())
   {
@@ -43,11 +68,48 @@ bool ProofStatement::isJustified()
     return false;
   }
   
-  bool result = reason->isJustified(*data, antecedents);
+  bool result;
+  std::string line_key;
+  if(cache != NULL && !antecedents.empty() &&
+    cache->key(*data, *reason, antecedents, line_key))
+  {
+    if(!cache->lookup(line_key, result))
+    {
+      result = checkJustification();
+      cache->store(line_key, result, *data, antecedents);
+    }
+  }
+  else
+    result = checkJustification();
   fail_type = (result)?NO_FAILURE:JUSTIFICATION_FAILURE;
   return result;
 }
 
+//Rejects the line without the rule if the prefilter can. Lines without
+//antecedents are left to the rule, as they're cheap to check.
+bool ProofStatement::checkJustification()
+{
+  if(semantic_prefilter && !antecedents.empty() && reason->isSound() && isRefuted())
+    return false;
+  return reason->isJustified(*data, antecedents);
+}
+
+//Looks for a counterexample among a limited number of assignments.
+bool ProofStatement::isRefuted()
+{
+  TruthTable table;
+  vector<int> premises;
+  for(antecedent_list::iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+  {
+    if(*itr == NULL || (*itr)->getStatementData() == NULL) return false;
+    premises.push_back(table.addSentence((*itr)->getStatementData()));
+  }
+  return table.refutes(premises, table.addSentence(data), PREFILTER_BLOCKS);
+}
+
+void ProofStatement::setSemanticPrefilter(bool enabled)
+{ semantic_prefilter = enabled; }
+
 //Returns the reason this statement is not justified.
 ProofStatement::failure_type_t ProofStatement::getFailureType()
 { return fail_type; }
@@ -101,15 +163,23 @@ char* ProofStatement::createDisplayString()
 //Replaces this statement's sentence with the given input.
 void ProofStatement::rewrite(const char* input)
 {
-  delete data;
-  data = new StatementTree(input);
+  StatementTree::release(data);
+  data = StatementTree::create(input);
+}
+
+//Replaces this statement's sentence with the given length of input.
+void ProofStatement::rewrite(const char* input, int length)
+{
+  StatementTree::release(data);
+  data = StatementTree::create(input, length);
 }
 
 //Replaces this statement's sentence with the given input.
 void ProofStatement::rewrite(StatementTree* input)
 {
-  delete data;
-  data = new StatementTree(*input);
+  StatementTree* old_data = data;
+  data = StatementTree::create(*input);
+  StatementTree::release(old_data);
 }
 
 void ProofStatement::setJustification(Justification* new_reason)
@@ -137,6 +207,12 @@ bool ProofStatement::toggleAntecedent(ProofStatement* ant)
   return false;
 }
 
+const antecedent_list& ProofStatement::getAntecedents()
+{ return antecedents; }
+
+void ProofStatement::clearAntecedents()
+{ antecedents.clear(); }
+
 //Makes this statement a child of the given parent by updating the parent
 //pointer & updating the child sets of both new & old parents.
 void ProofStatement::setParent(ProofStatement* new_parent)
@@ -144,8 +220,34 @@ void ProofStatement::setParent(ProofStatement* new_parent)
   if(parent != NULL) parent->toggleChild(this);
   if(new_parent != NULL) new_parent->toggleChild(this);
   parent = new_parent;
+  updateDepth();
+}
+
+//Contents of a subproof are one deeper than it.
+void ProofStatement::updateDepth()
+{
+  depth = (parent == NULL)?0:(parent->depth+1);
+  statement_set* contents = getSubproofContents();
+  if(contents == NULL) return;
+  for(statement_set::iterator itr = contents->begin(); itr != contents->end(); itr++)
+    (*itr)->updateDepth();
+}
+
+int ProofStatement::getDepth()
+{ return depth; }
+
+void ProofStatement::setScope(int open, int close)
+{
+  scope_open = open;
+  scope_close = close;
 }
 
+int ProofStatement::getScopeOpen()
+{ return scope_open; }
+
+int ProofStatement::getScopeClose()
+{ return scope_close; }
+
 void ProofStatement::setLineIndex(int i)
 { line_index = i; }
 
@@ -172,16 +274,17 @@ bool ProofStatement::antecedentAllowable(ProofStatement* ant)
   //if((*itr)->line_index >= line_index) return false; //The line was after this line
   
   ProofStatement* target = ant->parent;
-  bool target_found = false;
-  for(ProofStatement* traveller = parent; ; traveller = traveller->parent)
-  {
-    if(traveller == target)
-    {
-      target_found = true;
-      break;
-    }
-    if(traveller == NULL) break;
-  }
-  if(!target_found) return false; //The line was in a subproof.
-  return true;
+  if(target == NULL) return true; //Not in a subproof
+  if(target == this) return false;
+  
+  //This is in the subproof iff its interval is inside the subproof's. Each
+  //bound is read once, as a subproof may be closed while this is checked.
+  int target_open = target->scope_open, line_open = scope_open;
+  if(target_open >= 0 && line_open >= 0)
+    return target_open <= line_open && scope_close <= target->scope_close;
+  
+  //No interval, so look for the subproof among this line's ancestors
+  for(ProofStatement* traveller = parent; traveller != NULL; traveller = traveller->parent)
+    if(traveller == target) return true;
+  return false;
 }
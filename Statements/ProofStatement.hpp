@@ -1,6 +1,7 @@
 #ifndef __PROOF_STATEMENT_H_
 #define __PROOF_STATEMENT_H_
 
+#include <atomic>
 #include <list>
 #include <set>
 
@@ -12,6 +13,7 @@
 /// based.
 /// </summary>
 class ProofStatement;
+class VerificationCache;
 
 /// <summary>
 /// Type for a list of other proof lines, for use as the antecedents on which
@@ -22,6 +24,7 @@ typedef std::set<ProofStatement*> statement_set;
 
 #include "StatementTree.hpp"
 #include "Justification.hpp"
+#include "ProofArena.hpp"
 
 //Represents one statement in the proof
 class ProofStatement
@@ -40,6 +43,8 @@ class ProofStatement
 
   ProofStatement* parent;
   int line_index;
+  int depth; //Number of subproofs this is in
+  std::atomic<int> scope_open, scope_close; //See setScope
   
   Justification* reason;
   StatementTree* data;
@@ -66,6 +71,15 @@ public:
     ProofStatement(StatementTree* input, bool is_assump = false);
     virtual ~ProofStatement();
 
+    /// <summary>
+    /// Proof lines are allocated from the ProofArena of the proof they're in,
+    /// as "new (arena) ProofStatement(...)", and are destroyed along with that
+    /// arena. They must not be deleted directly.
+    /// </summary>
+    static void* operator new(size_t size, ProofArena& arena);
+    static void operator delete(void* statement, ProofArena& arena);
+    static void operator delete(void* statement);
+
     /// <summary>
     /// Generates a string to print this line as text. Note that this doesn't
     /// include printing the line number or indenting for subproofs; those are
@@ -86,12 +100,16 @@ public:
     /// failure type flat to NO_FAILURE if it is, otherwise sets it to what issue
     /// prevents it from being justified.
     /// </summary>
+    /// <param name="cache">
+    ///   If given, the result of applying the justification rule is looked up
+    ///   here first, and stored here if it had to be worked out.
+    /// </param>
     /// <returns>
     ///   True if the line's statement is well-formed, has a justification rule,
     ///   and the specified antecedents support this statement by that rule.
     ///   False otherwise. 
     /// </returns>
-    virtual bool isJustified();
+    virtual bool isJustified(VerificationCache* cache = NULL);
 
     /// <summary>
     /// Is this is a premise line or the assumption of a subproof?
@@ -126,7 +144,38 @@ public:
     /// <param name="new_reason">Justification for this line</param>
     void setJustification(Justification* new_reason);
 
+    /// <summary>
+    /// Turns on the semantic prefilter for every proof line: before a line's
+    /// rule is applied, its antecedents and sentence are evaluated on a batch
+    /// of assignments of truth values (every assignment, if there are few
+    /// enough atoms), and if some assignment makes all the antecedents true
+    /// and the line false, it's rejected without applying the rule. This is
+    /// only done for sound rules (see Justification::isSound), which could
+    /// never justify such a line, so it doesn't change any result. It saves
+    /// the rule's search on wrong lines, at the cost of the evaluation on
+    /// right ones. Off by default; set before any lines are checked.
+    /// </summary>
+    /// <param name="enabled">Whether lines are prefiltered</param>
+    static void setSemanticPrefilter(bool enabled);
+
 protected:
+    static bool semantic_prefilter;
+
+    /// <summary>
+    /// The semantic prefilter (see setSemanticPrefilter), for a line with a
+    /// sound rule.
+    /// </summary>
+    /// <returns>
+    ///   True if some assignment makes every antecedent true and this line
+    ///   false. Always false if an antecedent is a subproof.
+    /// </returns>
+    bool isRefuted();
+
+    /// <summary>
+    /// Applies the line's rule, after the prefilter if it's on.
+    /// </summary>
+    /// <returns>True if the rule justifies the line</returns>
+    bool checkJustification();
 
 #pragma endregion
 
@@ -156,6 +205,43 @@ public:
     /// </param>
     void setParent(ProofStatement* new_parent);
 
+    /// <summary>
+    /// How many subproofs this line (or subproof) is in. Kept up to date by setParent, so this
+    /// doesn't need to walk the parent chain.
+    /// </summary>
+    /// <returns>0 if this isn't in a subproof</returns>
+    int getDepth();
+
+    /// <summary>
+    /// Sets the scope interval used to check which lines are in which subproofs. Lines of a
+    /// subproof are consecutive in the proof, so numbering the lines in order, a line's interval
+    /// is [n, n] for its own number n and a subproof's is from the number of its first line to
+    /// the number of its last. A line is then in a subproof iff its number is within the
+    /// subproof's interval. Numbering is up to the proof; see Proof::addScope.
+    ///
+    /// Editing in the middle of a subproof can leave its lines apart from each other, in which
+    /// case it has no interval and an open of -1. Checks involving it then walk the chain of
+    /// parents instead.
+    ///
+    /// A StreamVerifier sets intervals while reading, as subproofs close, at the same time as
+    /// lines already read are checked on other threads, so the interval is kept atomically.
+    /// </summary>
+    /// <param name="open">Number of the first line</param>
+    /// <param name="close">Number of the last line</param>
+    void setScope(int open, int close);
+
+    /// <summary>
+    /// Start of the scope interval set by setScope.
+    /// </summary>
+    /// <returns>Number of the first line</returns>
+    int getScopeOpen();
+
+    /// <summary>
+    /// End of the scope interval set by setScope.
+    /// </summary>
+    /// <returns>Number of the last line</returns>
+    int getScopeClose();
+
     /// <summary>
     /// Used by SubProof. Returns the contents of that subproof.
     /// </summary>
@@ -193,6 +279,14 @@ public:
     /// <param name="input">Logical sentence. Will be parsed into a syntax tree.</param>
     virtual void rewrite(const char* input);
 
+    /// <summary>
+    /// Changes the sentence at this line to a new one, given as the first length characters
+    /// of a string.
+    /// </summary>
+    /// <param name="input">Logical sentence. Doesn't need to be null terminated.</param>
+    /// <param name="length">Number of characters in the sentence</param>
+    virtual void rewrite(const char* input, int length);
+
     /// <summary>
     /// Changes the sentence at this line to a new one.
     /// </summary>
@@ -214,6 +308,18 @@ public:
     /// </returns>
     virtual bool toggleAntecedent(ProofStatement* ant);
 
+    /// <summary>
+    /// Gets the lines (or subproofs) this line's justification is based on.
+    /// </summary>
+    /// <returns>Antecedents, in the order they were added</returns>
+    const antecedent_list& getAntecedents();
+
+    /// <summary>
+    /// Empties the list of antecedents, for a line which has been checked and won't be again.
+    /// Frees the list without needing to know if the antecedents still exist.
+    /// </summary>
+    void clearAntecedents();
+
     /// <summary>
     /// What line number in the proof is this? Note that is is the internal
     /// line number, which will be different from the line number as written
@@ -251,7 +357,8 @@ protected:
     /// Helper function for getRelevantAncestor, which checks whether one given
     /// line would be acceptable. Operates by checking whether that line's
     /// immediate parent is also one of this line's ancestors, i.e. if that line
-    /// is not in any additional subproofs.
+    /// is not in any additional subproofs. This is a comparison of scope
+    /// intervals, which must be up to date.
     /// </summary>
     /// <param name="antecedent">Line to check</param>
     /// <returns>
@@ -260,6 +367,11 @@ protected:
     /// </returns>
     bool antecedentAllowable(ProofStatement* antecedent);
 
+    /// <summary>
+    /// Recomputes the depth of this line and anything in it, after its parent changes.
+    /// </summary>
+    void updateDepth();
+
 #pragma endregion
 };
 
@@ -0,0 +1,116 @@
+#include "SatEncoder.hpp"
+#include <utility>
+
+using std::unordered_map;
+using std::vector;
+
+void SatEncoder::addClause(int first, int second, int third)
+{
+  vector<int> literals;
+  literals.push_back(first);
+  literals.push_back(second);
+  if(third != -1) literals.push_back(third);
+  solver.addClause(literals);
+}
+
+//An implication is encoded as the disjunction it's equivalent to. Symmetric
+//operators have their operands ordered so both orders share a variable.
+int SatEncoder::encodeGate(int node_type, int left, int right)
+{
+  if(node_type == StatementTree::IMPLIES)
+  {
+    node_type = StatementTree::OR;
+    left ^= 1;
+  }
+  if(left > right) std::swap(left, right);
+  sat_gate gate = { node_type, left, right };
+  unordered_map<sat_gate, int, sat_gate_hash>::iterator found = gate_variables.find(gate);
+  if(found != gate_variables.end()) return found->second;
+
+  int output = solver.addVariable() * 2;
+  int negated = output ^ 1;
+  switch(node_type)
+  {
+  case StatementTree::AND:
+    addClause(negated, left);
+    addClause(negated, right);
+    addClause(output, left ^ 1, right ^ 1);
+    break;
+  case StatementTree::OR:
+    addClause(output, left ^ 1);
+    addClause(output, right ^ 1);
+    addClause(negated, left, right);
+    break;
+  case StatementTree::IFF:
+    addClause(negated, left ^ 1, right);
+    addClause(negated, left, right ^ 1);
+    addClause(output, left, right);
+    addClause(output, left ^ 1, right ^ 1);
+    break;
+  }
+  gate_variables[gate] = output;
+  return output;
+}
+
+//Encodes the tree's nodes children first. Iterative so that very deep trees
+//don't exhaust the stack.
+int SatEncoder::addSentence(StatementTree* tree)
+{
+  vector<StatementTree*> pending(1, tree);
+  while(!pending.empty())
+  {
+    StatementTree* node = pending.back();
+    if(tree_literals.find(node) != tree_literals.end())
+    {
+      pending.pop_back();
+      continue;
+    }
+
+    bool children_added = true;
+    for(child_itr itr = node->begin(); itr != node->end(); itr++)
+    {
+      if(tree_literals.find(*itr) == tree_literals.end())
+      {
+        pending.push_back(*itr);
+        children_added = false;
+      }
+    }
+    if(!children_added) continue;
+    pending.pop_back();
+
+    int literal;
+    if(node->nodeType() == StatementTree::ATOM)
+    {
+      unordered_map<int, int>::iterator found = atom_variables.find(node->atomId());
+      if(found == atom_variables.end())
+        found = atom_variables.insert(std::make_pair(node->atomId(), solver.addVariable())).first;
+      literal = found->second * 2;
+    }
+    else
+      literal = encodeGate(node->nodeType(), tree_literals[node->begin()[StatementTree::LEFT]],
+        tree_literals[node->begin()[StatementTree::RIGHT]]);
+    tree_literals[node] = node->isAffirmed() ? literal : literal ^ 1;
+  }
+  return tree_literals[tree];
+}
+
+int SatEncoder::atomCount()
+{ return atom_variables.size(); }
+
+//The premises and the negated conclusion are asserted as unit clauses.
+SatEncoder::entailment_t SatEncoder::entails(const vector<int>& premises, int conclusion,
+  long conflict_limit)
+{
+  vector<int> unit(1);
+  for(size_t i = 0; i < premises.size(); i++)
+  {
+    unit[0] = premises[i];
+    solver.addClause(unit);
+  }
+  unit[0] = conclusion ^ 1;
+  solver.addClause(unit);
+
+  SatSolver::result_t result = solver.solve(conflict_limit);
+  if(result == SatSolver::UNSATISFIABLE) return ENTAILED;
+  return (result == SatSolver::SATISFIABLE) ? NOT_ENTAILED : ENTAILMENT_UNDECIDED;
+}
@@ -0,0 +1,105 @@
+#ifndef __SAT_ENCODER_H_
+#define __SAT_ENCODER_H_
+
+#include "StatementTree.hpp"
+#include "SatSolver.hpp"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// An operator applied to two literals, to find the variable already made
+/// for it.
+/// </summary>
+struct sat_gate
+{
+  int node_type;
+  int left;
+  int right;
+
+  bool operator==(const sat_gate& other) const
+  {
+    return node_type == other.node_type && left == other.left && right == other.right;
+  }
+};
+
+/// <summary>
+/// Hash function for sat_gate
+/// </summary>
+struct sat_gate_hash
+{
+  size_t operator()(const sat_gate& gate) const
+  {
+    size_t hash = ((size_t)gate.node_type * 31 + (size_t)gate.left) * 31 + (size_t)gate.right;
+    return hash ^ (hash >> 17);
+  }
+};
+
+/// <summary>
+/// Turns sentences into clauses for a SatSolver, to decide entailment for
+/// sentences with too many atoms for a TruthTable.
+///
+/// This is the Tseitin encoding: each atom is a variable, and so is each
+/// operator node, with clauses saying it's equal to the operator applied to
+/// its children. That's a few clauses per node, rather than the exponential
+/// blowup of converting to conjunctive normal form directly. A negation flag
+/// only negates the node's literal. Operators applied to the same literals
+/// share a variable, so subtrees shared between sentences, or that differ
+/// only in negation at the root, are only encoded once. Atoms are told apart
+/// by their AtomTable id.
+/// </summary>
+class SatEncoder
+{
+  public:
+  enum entailment_t { ENTAILED, NOT_ENTAILED, ENTAILMENT_UNDECIDED };
+
+  private:
+  SatSolver solver;
+  std::unordered_map<StatementTree*, int> tree_literals;
+  std::unordered_map<int, int> atom_variables; //By atom id
+  std::unordered_map<sat_gate, int, sat_gate_hash> gate_variables;
+
+  /// <summary>
+  /// Gets the variable for an operator applied to two literals, adding it
+  /// and its clauses if there isn't one.
+  /// </summary>
+  /// <returns>Positive literal of the variable</returns>
+  int encodeGate(int node_type, int left, int right);
+
+  /// <summary>
+  /// Adds a clause of two or three literals.
+  /// </summary>
+  void addClause(int first, int second, int third = -1);
+
+  public:
+  /// <summary>
+  /// Encodes a sentence, along with any of its subtrees not encoded yet.
+  /// </summary>
+  /// <param name="tree">Sentence to add</param>
+  /// <returns>Literal that's true exactly when the sentence is</returns>
+  int addSentence(StatementTree* tree);
+
+  /// <summary>
+  /// Number of distinct atoms in the sentences added so far.
+  /// </summary>
+  /// <returns>Number of atoms</returns>
+  int atomCount();
+
+  /// <summary>
+  /// Checks whether some sentences together entail another, by asking the
+  /// solver for an assignment that makes the premises true and the
+  /// conclusion false. This adds them as clauses, so it can only be done
+  /// once per encoder.
+  /// </summary>
+  /// <param name="premises">Literals of the premise sentences from addSentence</param>
+  /// <param name="conclusion">Literal of the conclusion from addSentence</param>
+  /// <param name="conflict_limit">Most conflicts the solver may have</param>
+  /// <returns>
+  ///   ENTAILED or NOT_ENTAILED, or ENTAILMENT_UNDECIDED if the solver gave
+  ///   up.
+  /// </returns>
+  entailment_t entails(const std::vector<int>& premises, int conclusion,
+    long conflict_limit = SAT_CONFLICT_LIMIT);
+};
+
+#endif
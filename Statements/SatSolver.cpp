@@ -0,0 +1,436 @@
+#include "SatSolver.hpp"
+#include <algorithm>
+
+using std::vector;
+
+#define SAT_UNASSIGNED -1
+#define SAT_NO_REASON -1
+#define SAT_RESCALE_LIMIT 1e100
+
+//Orders learnt clauses with the least active first.
+class LessActive
+{
+  private:
+  const vector<sat_clause>& clauses;
+
+  public:
+  LessActive(const vector<sat_clause>& all_clauses) : clauses(all_clauses)
+  {}
+
+  bool operator()(int first, int second) const
+  { return clauses[first].activity < clauses[second].activity; }
+};
+
+SatSolver::SatSolver() : propagated(0), activity_increment(1), clause_increment(1),
+  contradiction(false), learnt_count(0)
+{
+  //This space left intentionally blank
+}
+
+int SatSolver::addVariable()
+{
+  int variable = values.size();
+  values.push_back(SAT_UNASSIGNED);
+  levels.push_back(0);
+  reasons.push_back(SAT_NO_REASON);
+  phases.push_back(0);
+  seen.push_back(0);
+  activities.push_back(0);
+  heap_positions.push_back(-1);
+  watches.resize(watches.size() + 2);
+  heapInsert(variable);
+  return variable;
+}
+
+int SatSolver::variableCount()
+{ return values.size(); }
+
+//1 if true, 0 if false, -1 if unassigned
+int SatSolver::literalValue(int literal)
+{
+  int value = values[literal >> 1];
+  return (value == SAT_UNASSIGNED) ? SAT_UNASSIGNED : value ^ (literal & 1);
+}
+
+void SatSolver::assign(int literal, int reason)
+{
+  int variable = literal >> 1;
+  values[variable] = (literal & 1) ? 0 : 1;
+  levels[variable] = trail_levels.size();
+  reasons[variable] = reason;
+  trail.push_back(literal);
+}
+
+//Clauses are only added before solving, so anything false is false for good.
+void SatSolver::addClause(const vector<int>& literals)
+{
+  if(contradiction) return;
+  vector<int> kept;
+  for(size_t i = 0; i < literals.size(); i++)
+  {
+    int value = literalValue(literals[i]);
+    if(value == 1 || std::find(kept.begin(), kept.end(), literals[i] ^ 1) != kept.end())
+      return; //Already satisfied
+    if(value == SAT_UNASSIGNED && std::find(kept.begin(), kept.end(), literals[i]) == kept.end())
+      kept.push_back(literals[i]);
+  }
+
+  if(kept.empty())
+    contradiction = true;
+  else if(kept.size() == 1)
+  {
+    assign(kept[0], SAT_NO_REASON);
+    contradiction = propagate() != SAT_NO_REASON;
+  }
+  else
+    attachClause(kept, false);
+}
+
+int SatSolver::attachClause(const vector<int>& literals, bool learnt)
+{
+  sat_clause clause;
+  clause.literals = literals;
+  clause.learnt = learnt;
+  clause.deleted = false;
+  clause.activity = 0;
+  int index = clauses.size();
+  clauses.push_back(clause);
+  sat_watcher first = { index, literals[1] };
+  sat_watcher second = { index, literals[0] };
+  watches[literals[0]].push_back(first);
+  watches[literals[1]].push_back(second);
+  if(learnt) learnt_count++;
+  return index;
+}
+
+//The two watched literals are kept at the front of each clause. When one
+//becomes false the clause looks for another literal to watch, and if there
+//isn't one the other watched literal is implied (or the clause is falsified).
+int SatSolver::propagate()
+{
+  while(propagated < trail.size())
+  {
+    int false_literal = trail[propagated++] ^ 1;
+    vector<sat_watcher>& watching = watches[false_literal];
+    size_t kept = 0;
+    size_t i = 0;
+    for(; i < watching.size(); i++)
+    {
+      sat_watcher watcher = watching[i];
+      if(clauses[watcher.clause].deleted) continue;
+      if(literalValue(watcher.blocker) == 1)
+      {
+        watching[kept++] = watcher;
+        continue;
+      }
+
+      vector<int>& literals = clauses[watcher.clause].literals;
+      if(literals[0] == false_literal) std::swap(literals[0], literals[1]);
+      watcher.blocker = literals[0];
+      if(literalValue(literals[0]) == 1)
+      {
+        watching[kept++] = watcher;
+        continue;
+      }
+
+      bool moved = false;
+      for(size_t j = 2; j < literals.size() && !moved; j++)
+      {
+        if(literalValue(literals[j]) != 0)
+        {
+          std::swap(literals[1], literals[j]);
+          sat_watcher moved_watcher = { watcher.clause, literals[0] };
+          watches[literals[1]].push_back(moved_watcher);
+          moved = true;
+        }
+      }
+      if(moved) continue;
+
+      watching[kept++] = watcher;
+      if(literalValue(literals[0]) == 0)
+      {
+        //Conflict; keep the rest of the watchers and stop
+        for(i++; i < watching.size(); i++)
+          watching[kept++] = watching[i];
+        watching.resize(kept);
+        propagated = trail.size();
+        return watcher.clause;
+      }
+      assign(literals[0], watcher.clause);
+    }
+    watching.resize(kept);
+  }
+  return SAT_NO_REASON;
+}
+
+//Resolves the conflict clause with the reasons of its literals at the
+//current level, latest first, until only one literal at this level is left.
+int SatSolver::analyze(int conflict, vector<int>& learnt)
+{
+  int current_level = trail_levels.size();
+  learnt.assign(1, 0); //Asserting literal goes first
+  int pending = 0;
+  int literal = -1;
+  size_t index = trail.size();
+  do
+  {
+    bumpClause(conflict);
+    const vector<int>& literals = clauses[conflict].literals;
+    for(size_t i = (literal == -1) ? 0 : 1; i < literals.size(); i++)
+    {
+      int variable = literals[i] >> 1;
+      if(seen[variable] || levels[variable] == 0) continue;
+      seen[variable] = 1;
+      bumpVariable(variable);
+      if(levels[variable] == current_level)
+        pending++;
+      else
+        learnt.push_back(literals[i]);
+    }
+
+    //Latest literal on the trail that's part of the conflict
+    while(!seen[trail[--index] >> 1]);
+    literal = trail[index];
+    conflict = reasons[literal >> 1];
+    seen[literal >> 1] = 0;
+    pending--;
+  } while(pending > 0);
+  learnt[0] = literal ^ 1;
+
+  //Drop literals implied by the rest, then clear the marks
+  vector<int> analyzed(learnt.begin() + 1, learnt.end());
+  size_t kept = 1;
+  for(size_t i = 1; i < learnt.size(); i++)
+    if(reasons[learnt[i] >> 1] == SAT_NO_REASON || !isRedundant(learnt[i]))
+      learnt[kept++] = learnt[i];
+  learnt.resize(kept);
+  for(size_t i = 0; i < analyzed.size(); i++)
+    seen[analyzed[i] >> 1] = 0;
+
+  //Back up to the highest level among the rest, which goes second so it's watched
+  int backtrack_level = 0;
+  for(size_t i = 1; i < learnt.size(); i++)
+  {
+    if(levels[learnt[i] >> 1] > backtrack_level)
+    {
+      backtrack_level = levels[learnt[i] >> 1];
+      std::swap(learnt[1], learnt[i]);
+    }
+  }
+  return backtrack_level;
+}
+
+//Only looks one step back: every other literal of the reason must already
+//be in the clause, or assigned at level 0.
+bool SatSolver::isRedundant(int literal)
+{
+  const vector<int>& literals = clauses[reasons[literal >> 1]].literals;
+  for(size_t i = 1; i < literals.size(); i++)
+  {
+    int variable = literals[i] >> 1;
+    if(!seen[variable] && levels[variable] > 0) return false;
+  }
+  return true;
+}
+
+//Phases are saved so a variable is tried with its last value again.
+void SatSolver::backtrack(int level)
+{
+  if((int)trail_levels.size() <= level) return;
+  for(size_t i = trail.size(); i > (size_t)trail_levels[level]; i--)
+  {
+    int variable = trail[i - 1] >> 1;
+    phases[variable] = values[variable];
+    values[variable] = SAT_UNASSIGNED;
+    reasons[variable] = SAT_NO_REASON;
+    heapInsert(variable);
+  }
+  trail.resize(trail_levels[level]);
+  trail_levels.resize(level);
+  propagated = trail.size();
+}
+
+//Watchers of deleted clauses are dropped as propagate comes across them.
+void SatSolver::reduceLearnt()
+{
+  vector<int> candidates;
+  for(size_t i = 0; i < clauses.size(); i++)
+  {
+    sat_clause& clause = clauses[i];
+    if(!clause.learnt || clause.deleted || clause.literals.size() <= 2) continue;
+    int first = clause.literals[0] >> 1;
+    if(reasons[first] == (int)i && values[first] != SAT_UNASSIGNED) continue; //Locked
+    candidates.push_back(i);
+  }
+  std::sort(candidates.begin(), candidates.end(), LessActive(clauses));
+  for(size_t i = 0; i < candidates.size() / 2; i++)
+  {
+    sat_clause& clause = clauses[candidates[i]];
+    clause.deleted = true;
+    vector<int>().swap(clause.literals);
+    learnt_count--;
+  }
+}
+
+void SatSolver::bumpVariable(int variable)
+{
+  activities[variable] += activity_increment;
+  if(activities[variable] > SAT_RESCALE_LIMIT)
+  {
+    for(size_t i = 0; i < activities.size(); i++)
+      activities[i] /= SAT_RESCALE_LIMIT;
+    activity_increment /= SAT_RESCALE_LIMIT;
+  }
+  if(heap_positions[variable] != -1) heapUp(heap_positions[variable]);
+}
+
+void SatSolver::bumpClause(int clause)
+{
+  if(!clauses[clause].learnt) return;
+  clauses[clause].activity += clause_increment;
+  if(clauses[clause].activity > SAT_RESCALE_LIMIT)
+  {
+    for(size_t i = 0; i < clauses.size(); i++)
+      clauses[i].activity /= SAT_RESCALE_LIMIT;
+    clause_increment /= SAT_RESCALE_LIMIT;
+  }
+}
+
+void SatSolver::heapInsert(int variable)
+{
+  if(heap_positions[variable] != -1) return;
+  heap_positions[variable] = heap.size();
+  heap.push_back(variable);
+  heapUp(heap.size() - 1);
+}
+
+void SatSolver::heapUp(int position)
+{
+  int variable = heap[position];
+  while(position > 0 && activities[heap[(position - 1) / 2]] < activities[variable])
+  {
+    heap[position] = heap[(position - 1) / 2];
+    heap_positions[heap[position]] = position;
+    position = (position - 1) / 2;
+  }
+  heap[position] = variable;
+  heap_positions[variable] = position;
+}
+
+void SatSolver::heapDown(int position)
+{
+  int variable = heap[position];
+  int size = heap.size();
+  while(position * 2 + 1 < size)
+  {
+    int child = position * 2 + 1;
+    if(child + 1 < size && activities[heap[child + 1]] > activities[heap[child]]) child++;
+    if(activities[heap[child]] <= activities[variable]) break;
+    heap[position] = heap[child];
+    heap_positions[heap[position]] = position;
+    position = child;
+  }
+  heap[position] = variable;
+  heap_positions[variable] = position;
+}
+
+int SatSolver::heapPop()
+{
+  int top = heap[0];
+  heap_positions[top] = -1;
+  int last = heap.back();
+  heap.pop_back();
+  if(!heap.empty())
+  {
+    heap[0] = last;
+    heap_positions[last] = 0;
+    heapDown(0);
+  }
+  return top;
+}
+
+double SatSolver::luby(int restart)
+{
+  //Find the finite subsequence that contains the restart, and its position in it
+  int size = 1, sequence = 0;
+  while(size < restart + 1)
+  {
+    sequence++;
+    size = 2 * size + 1;
+  }
+  while(size - 1 != restart)
+  {
+    size = (size - 1) >> 1;
+    sequence--;
+    restart = restart % size;
+  }
+  double units = 1;
+  for(int i = 0; i < sequence; i++)
+    units *= 2;
+  return units;
+}
+
+SatSolver::result_t SatSolver::solve(long conflict_limit)
+{
+  if(contradiction) return UNSATISFIABLE;
+  long conflicts = 0;
+  int restarts = 0;
+  long restart_conflicts = (long)(luby(0) * SAT_RESTART_BASE);
+  size_t max_learnt = clauses.size() / 3 + 1000;
+  vector<int> learnt;
+
+  while(true)
+  {
+    int conflict = propagate();
+    if(conflict != SAT_NO_REASON)
+    {
+      conflicts++;
+      restart_conflicts--;
+      if(trail_levels.empty()) return UNSATISFIABLE;
+      int level = analyze(conflict, learnt);
+      backtrack(level);
+      if(learnt.size() == 1)
+        assign(learnt[0], SAT_NO_REASON);
+      else
+      {
+        int clause = attachClause(learnt, true);
+        bumpClause(clause);
+        assign(learnt[0], clause);
+      }
+      activity_increment /= SAT_ACTIVITY_DECAY;
+      clause_increment /= SAT_CLAUSE_DECAY;
+      continue;
+    }
+
+    if(conflicts >= conflict_limit)
+    {
+      backtrack(0);
+      return UNDECIDED;
+    }
+    if(restart_conflicts <= 0)
+    {
+      backtrack(0);
+      restarts++;
+      restart_conflicts = (long)(luby(restarts) * SAT_RESTART_BASE);
+    }
+    if((size_t)learnt_count >= max_learnt + trail.size())
+    {
+      reduceLearnt();
+      max_learnt += max_learnt / 10;
+    }
+
+    //Decide on the most active unassigned variable
+    int variable = -1;
+    while(!heap.empty() && variable == -1)
+    {
+      variable = heapPop();
+      if(values[variable] != SAT_UNASSIGNED) variable = -1;
+    }
+    if(variable == -1) return SATISFIABLE;
+    trail_levels.push_back(trail.size());
+    assign(variable * 2 + (phases[variable] ? 0 : 1), SAT_NO_REASON);
+  }
+}
+
+bool SatSolver::modelValue(int variable)
+{ return values[variable] == 1; }
@@ -0,0 +1,169 @@
+#ifndef __SAT_SOLVER_H_
+#define __SAT_SOLVER_H_
+
+#include <cstddef>
+#include <vector>
+
+#define SAT_CONFLICT_LIMIT 100000 //Default for how many conflicts solve may have
+#define SAT_RESTART_BASE 100 //Conflicts per unit of the restart sequence
+#define SAT_ACTIVITY_DECAY 0.95
+#define SAT_CLAUSE_DECAY 0.999
+
+/// <summary>
+/// A clause of a SatSolver. Learnt clauses can be deleted again, which
+/// empties their literals.
+/// </summary>
+struct sat_clause
+{
+  std::vector<int> literals;
+  bool learnt;
+  bool deleted;
+  double activity;
+};
+
+/// <summary>
+/// A clause watching a literal, with another literal of the clause (the
+/// blocker) that, if it's true, means the clause needn't be looked at.
+/// </summary>
+struct sat_watcher
+{
+  int clause;
+  int blocker;
+};
+
+/// <summary>
+/// Decides whether a set of clauses can all be satisfied, by conflict driven
+/// clause learning. Variables are numbered from 0, and a literal is
+/// variable * 2, plus 1 if it's negated.
+///
+/// - Each clause watches two of its literals, and is only looked at when one
+///   of those becomes false.
+/// - When an assignment falsifies a clause, a clause explaining why (at the
+///   first unique implication point) is learnt and the search backs up.
+/// - Variables are decided in order of activity (VSIDS): those in recent
+///   conflicts first, with their last value.
+/// - The search restarts after a growing number of conflicts (the Luby
+///   sequence), keeping what it learnt, and half the learnt clauses are
+///   deleted when there get to be too many.
+/// </summary>
+class SatSolver
+{
+  public:
+  enum result_t { SATISFIABLE, UNSATISFIABLE, UNDECIDED };
+
+  private:
+  std::vector<sat_clause> clauses;
+  std::vector<std::vector<sat_watcher> > watches; //By literal; clauses to look at when it becomes false
+  std::vector<signed char> values; //By variable: 1 true, 0 false, -1 unassigned
+  std::vector<int> levels; //Decision level each variable was assigned at
+  std::vector<int> reasons; //Clause that implied each variable, or -1
+  std::vector<char> phases; //Value each variable last had
+  std::vector<char> seen; //For analyze
+  std::vector<int> trail; //Assigned literals, in order
+  std::vector<int> trail_levels; //Where each decision level starts on the trail
+  size_t propagated; //Trail position propagation has reached
+
+  std::vector<double> activities;
+  double activity_increment;
+  double clause_increment;
+  std::vector<int> heap; //Unassigned variables by activity, most active first
+  std::vector<int> heap_positions; //Position of each variable in the heap, or -1
+
+  bool contradiction; //Whether the clauses were found unsatisfiable while being added
+  int learnt_count;
+
+  int literalValue(int literal);
+  void assign(int literal, int reason);
+
+  /// <summary>
+  /// Adds a clause of at least two literals, watching its first two.
+  /// </summary>
+  /// <returns>Index of the clause</returns>
+  int attachClause(const std::vector<int>& literals, bool learnt);
+
+  /// <summary>
+  /// Assigns every literal implied by a clause with one literal left.
+  /// </summary>
+  /// <returns>Index of a clause with every literal false, or -1</returns>
+  int propagate();
+
+  /// <summary>
+  /// Works out the clause to learn from a conflict.
+  /// </summary>
+  /// <param name="conflict">Clause with every literal false</param>
+  /// <param name="learnt">Set to the clause, with the literal to assert first</param>
+  /// <returns>Decision level to back up to</returns>
+  int analyze(int conflict, std::vector<int>& learnt);
+
+  /// <summary>
+  /// Whether a literal of a learnt clause is implied by the others, through
+  /// the clause that implied it.
+  /// </summary>
+  bool isRedundant(int literal);
+
+  /// <summary>
+  /// Unassigns everything above a decision level.
+  /// </summary>
+  void backtrack(int level);
+
+  /// <summary>
+  /// Deletes the less active half of the learnt clauses that aren't the
+  /// reason for an assignment.
+  /// </summary>
+  void reduceLearnt();
+
+  void bumpVariable(int variable);
+  void bumpClause(int clause);
+  void heapInsert(int variable);
+  void heapUp(int position);
+  void heapDown(int position);
+  int heapPop();
+
+  /// <summary>
+  /// Number of restart units for a restart, from the Luby sequence
+  /// 1 1 2 1 1 2 4 1 1 2 ...
+  /// </summary>
+  static double luby(int restart);
+
+  public:
+  SatSolver();
+
+  /// <summary>
+  /// Adds a variable.
+  /// </summary>
+  /// <returns>Number of the variable</returns>
+  int addVariable();
+
+  /// <summary>
+  /// Number of variables added.
+  /// </summary>
+  /// <returns>Number of variables</returns>
+  int variableCount();
+
+  /// <summary>
+  /// Adds a clause: at least one of the literals must be true. Must not be
+  /// called once solve has been.
+  /// </summary>
+  /// <param name="literals">Literals of variables already added</param>
+  void addClause(const std::vector<int>& literals);
+
+  /// <summary>
+  /// Searches for an assignment satisfying every clause.
+  /// </summary>
+  /// <param name="conflict_limit">Most conflicts to have before giving up</param>
+  /// <returns>
+  ///   SATISFIABLE or UNSATISFIABLE, or UNDECIDED if the limit was reached
+  ///   first.
+  /// </returns>
+  result_t solve(long conflict_limit = SAT_CONFLICT_LIMIT);
+
+  /// <summary>
+  /// After solve returns SATISFIABLE, the value of a variable in the
+  /// assignment found.
+  /// </summary>
+  /// <param name="variable">Number of the variable</param>
+  /// <returns>Value of the variable</returns>
+  bool modelValue(int variable);
+};
+
+#endif
@@ -1,176 +1,357 @@
 #include "StatementTree.hpp"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <list>
+#include <new>
+#include <vector>
 
 using std::list;
+using std::lock_guard;
+using std::unique_lock;
+using std::mutex;
+using std::vector;
+using std::pair;
+
+tree_shard StatementTree::shards[TREE_SHARD_COUNT];
+std::atomic<unsigned int> StatementTree::malformed_count(0);
+
+//The splitmix64 finalizer: every bit of the input affects every bit of the
+//output, and no two inputs give the same output.
+static tree_hash avalanche(tree_hash value)
+{
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ULL;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebULL;
+  value ^= value >> 31;
+  return value;
+}
+
+//Mixes a value into a structural hash. Multiplying by an odd constant keeps
+//the two apart, so the order they're mixed in matters, and the finalizer
+//makes changing either one change the result unpredictably.
+tree_hash StatementTree::mixHash(tree_hash hash, tree_hash value)
+{ return avalanche((hash * 0x9e3779b97f4a7c15ULL) ^ value); }
 
 //Parses the given string into a tree
-StatementTree::StatementTree(const char* input) : is_affirmed(true), validity(VALIDITY_UNKNOWN)
+StatementTree* StatementTree::create(const char* input)
 {
-  //Copy the input to modify it during parsing
-  atom_name = new char[strlen(input)+1];
-  strcpy(atom_name, input);
-
-  //Remove any parentheses that enclose the entire string, then find the top-
-  //level operator.
-  stripParens(atom_name);
-  int operator_pos = findOperator(atom_name);
-  node_type = operatorType(atom_name[operator_pos]);
-  if(node_type == ATOM) return; //No operator found, this is an atomic proposition
-  
-  //Extract the substrings for the child nodes
-  char* left = new char[operator_pos+1];
-  char* right = new char[strlen(atom_name)-operator_pos];
-  strncpy(left, atom_name, operator_pos);
-  left[operator_pos] = '\0'; //strncpy doesn't guarantee null character
-  strcpy(right, atom_name+operator_pos+1);
-  delete [] atom_name;
-  atom_name = NULL; //This is not an atomic proposition
-  //Check valid?
-  
-  //Parse the child nodes
-  children.push_front(new StatementTree(right));
-  if(strlen(left) != 0 && node_type != NOT) children.push_front(new StatementTree(left));
-  
-  //If this is a negation node, consolidate that into a negation flag so the
-  //tree is binary.
-  consolidateNegation();
+  return create(input, strlen(input));
 }
 
-//Copies the given tree. If dontNegate is true or not given, it will be
-//a straight copy. Otherwise, it will add or remove a NOT node at the root.
-StatementTree::StatementTree(StatementTree& other, bool dontNegate) : is_affirmed(dontNegate == other.is_affirmed)
+//Parses only the given length, so the input can be a view into a larger
+//buffer (such as a line of a proof file) rather than its own string.
+StatementTree* StatementTree::create(const char* input, int length)
 {
-  node_type = other.node_type;
-  if(other.atom_name != NULL)
+  const char* pos = input;
+  const char* end = input + length;
+  StatementTree* root = parseExpression(pos, end, OP_START);
+  if(root == NULL || pos != end)
   {
-    atom_name = new char[strlen(other.atom_name)+1];
-    strcpy(atom_name, other.atom_name);
+    //Not well-formed. Keep the whole string, so that the sentence is
+    //displayed as written and isValid rejects it.
+    releaseTree(root);
+    return createMalformed(input, length, true);
   }
-  else atom_name = NULL;
-  for(list<StatementTree*>::iterator itr = other.children.begin(); itr != other.children.end(); itr++)
-    children.push_back(new StatementTree(**itr));
+  return root;
 }
 
-StatementTree::~StatementTree()
+StatementTree* StatementTree::create(StatementTree& other, bool dontNegate)
 {
-  if(atom_name != NULL)
-  {
-    delete [] atom_name;
-    atom_name = NULL;
-  }
-  for(child_itr itr = begin(); itr != end(); itr++)
-    delete *itr;
+  return copyTree(other, dontNegate);
 }
 
-//Incorporates negation into root
-void StatementTree::consolidateNegation()
+//Names that aren't allowed are kept out of the atom table, like any other
+//malformed sentence.
+StatementTree* StatementTree::createAtom(const char* name, int length, bool affirmed)
 {
-  if(node_type != NOT) return;
-  
-  //Should only have one child. Make that node's children our children.
-  StatementTree* old_child = children.front();
-  children.splice(children.end(), old_child->children);
-
-  //Acquire the old child's node type, and the inverse of its negation flag.
-  //Note that the child shouldn't also be a negation node, as it will have
-  //also called consolidateNegation during parsing.
-  node_type = old_child->node_type;
-  is_affirmed = !old_child->is_affirmed;
-  
-  if(old_child->atom_name != NULL)
+  int atom = AtomTable::isValidName(name, length) ? AtomTable::intern(name, length) : -1;
+  if(atom == -1) return createMalformed(name, length, affirmed);
+  return intern(ATOM, affirmed, atom, NULL, NULL);
+}
+
+//Ids count down from -2, wrapping back after about two billion, by which time
+//the ones given out first are long gone.
+StatementTree* StatementTree::createMalformed(const char* text, int length, bool affirmed)
+{
+  char* stored_text = new char[length+1];
+  memcpy(stored_text, text, length);
+  stored_text[length] = '\0';
+  int atom = -2 - (int)(malformed_count++ % 0x7ffffff0u);
+  tree_hash hash = mixHash(mixHash(ATOM, affirmed), AtomTable::hashName(text, length));
+  tree_shard& shard = shardFor(hash);
+  lock_guard<mutex> guard(shard.lock);
+  StatementTree* created = ::new(allocateNode(shard)) StatementTree(ATOM, affirmed, atom,
+    NULL, NULL, hash);
+  created->malformed_text = stored_text;
+  return created;
+}
+
+//For trees whose structure is already known, such as from a binary proof
+//file, so there's nothing to parse.
+StatementTree* StatementTree::createOperator(int type, bool affirmed, StatementTree* left,
+  StatementTree* right)
+{
+  return intern(type, affirmed, -1, left, right);
+}
+
+void StatementTree::release(StatementTree* tree)
+{ releaseTree(tree); }
+
+//Copies the given tree. If dontNegate is true or not given, it will be
+//a straight copy. Otherwise, it will add or remove a NOT node at the root.
+//The caller holds a reference, so the node can't be freed meanwhile and the
+//count can be raised without the lock.
+StatementTree* StatementTree::copyTree(StatementTree& other, bool dontNegate)
+{
+  if(dontNegate)
   {
-    //Old child was an atom, acquire its name.
-    atom_name = new char[strlen(old_child->atom_name)+1];
-    strcpy(atom_name, old_child->atom_name);
+    other.ref_count++;
+    return &other;
   }
   
-  //Remove the old child
-  children.pop_front();
+  //The negated node has the same children, so it needs its own references
+  //to them.
+  StatementTree* left = NULL;
+  StatementTree* right = NULL;
+  if(other.atom_id < -1)
+    return createMalformed(other.malformed_text, strlen(other.malformed_text), !other.is_affirmed);
+  if(other.node_type != ATOM)
+  {
+    left = copyTree(*other.children[LEFT]);
+    right = copyTree(*other.children[RIGHT]);
+  }
+  return intern(other.node_type, !other.is_affirmed, other.atom_id, left, right);
 }
 
-//Creates generalized conjunctions, disjunctions, and biconditionals when appropriate
-//by removing children & adopting those children's children.
-//Not currently used: generalized conjunction/disjunction would make application of
-//inference rules more difficult.
-void StatementTree::consolidateChildren()
-{  
-  if(!isAssociative()) return;
-  
-  for(list<StatementTree*>::iterator itr = children.begin(); itr != children.end();)
+//Gives back a reference to the tree, and frees any nodes no longer in use.
+void StatementTree::releaseTree(StatementTree* tree)
+{
+  //Iterative so that very deep trees don't exhaust the stack.
+  vector<StatementTree*> released;
+  if(tree != NULL) released.push_back(tree);
+  while(!released.empty())
   {
-    if(node_type == (*itr)->node_type)
+    StatementTree* node = released.back();
+    released.pop_back();
+    
+    //Any reference but the last is given back without the lock
+    int count = node->ref_count.load();
+    while(count > 1 && !node->ref_count.compare_exchange_weak(count, count-1));
+    if(count > 1) continue;
+    
+    //The last one takes the shard's lock, so intern can't find the node while
+    //it's removed. It may have been found again since it was counted.
+    tree_shard& shard = shardFor(node->structure_hash);
+    lock_guard<mutex> guard(shard.lock);
+    if(--node->ref_count > 0) continue;
+    pair<intern_table::iterator, intern_table::iterator> range =
+      shard.trees.equal_range(node->structure_hash);
+    for(intern_table::iterator itr = range.first; itr != range.second; itr++)
     {
-      list<StatementTree*>::iterator old_child = itr++;
-      children.splice(itr, (*old_child)->children);
-      delete *old_child;
-      itr = children.erase(old_child);
+      if(itr->second == node)
+      {
+        shard.trees.erase(itr);
+        break;
+      }
     }
-    else itr++;
+    for(child_itr itr = node->begin(); itr != node->end(); itr++)
+      released.push_back(*itr);
+    freeNode(node, shard);
   }
 }
 
-//Returns an iterator to the start of the list of children
-child_itr StatementTree::begin()
-{ return children.begin(); }
+//Creates a node. Takes over the given references to its children. Validity is
+//worked out here, since the node can't change afterwards.
+StatementTree::StatementTree(int type, bool affirmed, int atom, StatementTree* left,
+  StatementTree* right, tree_hash hash) : node_type(type), atom_id(atom),
+  is_affirmed(affirmed), structure_hash(hash), ref_count(1)
+{
+  children[LEFT] = left;
+  children[RIGHT] = right;
+  if(type == ATOM)
+    is_valid = atom >= 0 && AtomTable::isValidName(atom);
+  else
+    is_valid = left->is_valid && right->is_valid;
+}
 
-//Returns an iterator to the end of the list of children
-child_itr StatementTree::end()
-{ return children.end(); }
+StatementTree::~StatementTree()
+{
+  if(atom_id < -1) delete [] malformed_text;
+}
 
-//Returns true if there is no negation flag attached to this node
-bool StatementTree::isAffirmed()
-{ return is_affirmed; }
+//The low bits pick the bucket within the shard's table, so use high ones.
+tree_shard& StatementTree::shardFor(tree_hash hash)
+{ return shards[(hash >> 32) % TREE_SHARD_COUNT]; }
 
-//Returns true if this statement is syntactically acceptable/well
-//formed. Valid is a misnomer but is shorter.
-bool StatementTree::isValid()
+//Takes a node from the free list, carving a new block if it's empty.
+void* StatementTree::allocateNode(tree_shard& shard)
 {
-  //If this has already been checked, return the result.
-  if(validity == IS_VALID) return true;
-  else if(validity == IS_INVALID) return false;
+  if(shard.pool_free_list == NULL)
+  {
+    char* block = new char[TREE_POOL_BLOCK_NODES*sizeof(StatementTree)];
+    shard.pool_blocks.push_back(block);
+    for(int i = TREE_POOL_BLOCK_NODES-1; i >= 0; i--)
+    {
+      StatementTree* node = (StatementTree*)(block + i*sizeof(StatementTree));
+      *(StatementTree**)node = shard.pool_free_list;
+      shard.pool_free_list = node;
+    }
+    shard.pool_free_count += TREE_POOL_BLOCK_NODES;
+  }
   
-  //Is an atom, check for disallowed characters in name.
-  if(node_type == ATOM)
+  StatementTree* node = shard.pool_free_list;
+  shard.pool_free_list = *(StatementTree**)node;
+  shard.pool_free_count--;
+  return node;
+}
+
+//Destroys a node and puts it back on the free list.
+void StatementTree::freeNode(StatementTree* node, tree_shard& shard)
+{
+  node->~StatementTree();
+  *(StatementTree**)node = shard.pool_free_list;
+  shard.pool_free_list = node;
+  shard.pool_free_count++;
+}
+
+//For each shard, counts the free nodes in each block, finding a node's block
+//by binary search over the blocks sorted by address. Blocks with every node
+//free are deleted, and the free list is rebuilt from the nodes in the rest.
+void StatementTree::trimPool()
+{
+  for(int i = 0; i < TREE_SHARD_COUNT; i++)
   {
-    if(atom_name == NULL || strlen(atom_name) == 0)
+    tree_shard& shard = shards[i];
+    lock_guard<mutex> guard(shard.lock);
+    if(shard.pool_free_count < shard.pool_trim_at) continue;
+
+    vector<char*>& blocks = shard.pool_blocks;
+    std::sort(blocks.begin(), blocks.end());
+    vector<int> free_nodes(blocks.size(), 0);
+    for(StatementTree* node = shard.pool_free_list; node != NULL; node = *(StatementTree**)node)
     {
-      validity = IS_INVALID;
-      return false;
+      size_t block = std::upper_bound(blocks.begin(), blocks.end(), (char*)node) -
+        blocks.begin() - 1;
+      free_nodes[block]++;
     }
-    for(unsigned int i = 0; i < strlen(atom_name); i++)
-      if(atom_name[i] == '(' || atom_name[i] == ')' || operatorType(atom_name[i]) != ATOM)
+
+    StatementTree* node = shard.pool_free_list;
+    shard.pool_free_list = NULL;
+    shard.pool_free_count = 0;
+    while(node != NULL)
+    {
+      StatementTree* next = *(StatementTree**)node;
+      size_t block = std::upper_bound(blocks.begin(), blocks.end(), (char*)node) -
+        blocks.begin() - 1;
+      if(free_nodes[block] < TREE_POOL_BLOCK_NODES)
       {
-        validity = IS_INVALID;
-        return false;
+        *(StatementTree**)node = shard.pool_free_list;
+        shard.pool_free_list = node;
+        shard.pool_free_count++;
       }
-    validity = IS_VALID;
-    return true;
+      node = next;
+    }
+
+    size_t kept = 0;
+    for(size_t j = 0; j < blocks.size(); j++)
+    {
+      if(free_nodes[j] == TREE_POOL_BLOCK_NODES)
+        delete [] blocks[j];
+      else
+        blocks[kept++] = blocks[j];
+    }
+    blocks.resize(kept);
+    shard.pool_trim_at = std::max((size_t)TREE_POOL_TRIM_NODES, 2*shard.pool_free_count);
   }
-  
-  //Not an atom, check presence & validity of children
-  if(children.size() < 2)
+}
+
+//Returns the existing node with the given contents if there is one, otherwise
+//creates it. Either way the caller's references to the children are used up.
+StatementTree* StatementTree::intern(int type, bool affirmed, int atom,
+  StatementTree* left, StatementTree* right)
+{
+  //Hash the contents. Atoms and children contribute the hash of their name
+  //and structure rather than an id or address, so the hash is the same
+  //across runs. Each child's negation is also mixed in on its own, so moving
+  //a negation between a node and its child changes the hash.
+  tree_hash hash = mixHash(type, affirmed);
+  if(type == ATOM)
+    hash = mixHash(hash, AtomTable::nameHash(atom));
+  else
   {
-    //Negation is the only type with one child & negation
-    //nodes shouldn't exist after tree creation.
-    validity = IS_INVALID;
-    return false;
+    hash = mixHash(mixHash(hash, left->is_affirmed), left->structure_hash);
+    hash = mixHash(mixHash(hash, right->is_affirmed), right->structure_hash);
   }
-  for(child_itr itr = begin(); itr != end(); itr++)
-    if(!(*itr)->isValid())
+  
+  //Nodes in the table always have a reference, as the last release removes
+  //them with the lock held.
+  tree_shard& shard = shardFor(hash);
+  unique_lock<mutex> guard(shard.lock);
+  pair<intern_table::iterator, intern_table::iterator> range =
+    shard.trees.equal_range(hash);
+  for(intern_table::iterator itr = range.first; itr != range.second; itr++)
+  {
+    StatementTree* existing = itr->second;
+    if(existing->hasContents(type, affirmed, atom, left, right))
     {
-      validity = IS_INVALID;
-      return false;
+      //The existing node already holds its own references to the children.
+      //They're given back without the lock, as they may be in other shards.
+      existing->ref_count++;
+      guard.unlock();
+      releaseTree(left);
+      releaseTree(right);
+      return existing;
     }
-  validity = IS_VALID;
-  return true;
+  }
+  
+  StatementTree* created = ::new(allocateNode(shard)) StatementTree(type, affirmed, atom,
+    left, right, hash);
+  shard.trees.insert(intern_table::value_type(hash, created));
+  return created;
 }
 
+//Checks the contents of this node without looking further down the tree.
+bool StatementTree::hasContents(int type, bool affirmed, int atom,
+  StatementTree* left, StatementTree* right)
+{
+  if(node_type != type || is_affirmed != affirmed) return false;
+  if(type == ATOM) return atom_id == atom;
+  return children[LEFT] == left && children[RIGHT] == right;
+}
+
+//Returns an iterator to the start of the children
+child_itr StatementTree::begin()
+{ return children; }
+
+//Returns an iterator to the end of the children. Atoms have none.
+child_itr StatementTree::end()
+{ return (node_type == ATOM) ? children : children+2; }
+
+//Returns true if there is no negation flag attached to this node
+bool StatementTree::isAffirmed()
+{ return is_affirmed; }
+
+//Returns true if this statement is syntactically acceptable/well
+//formed. Valid is a misnomer but is shorter.
+bool StatementTree::isValid()
+{ return is_valid; }
+
 int StatementTree::nodeType()
 { return node_type; }
 
-char* StatementTree::atomName()
-{ return atom_name; }
+const char* StatementTree::atomName()
+{
+  if(atom_id == -1) return NULL;
+  return (atom_id < -1) ? malformed_text : AtomTable::name(atom_id);
+}
+
+int StatementTree::atomId()
+{ return atom_id; }
+
+tree_hash StatementTree::structureHash()
+{ return structure_hash; }
 
 bool StatementTree::isAssociative()
 {
@@ -198,22 +379,17 @@ bool StatementTree::isCommutative()
   }
 }
 
-//Returns whether or not the given tree is the same as this tree.
+//Returns whether or not the given tree is the same as this tree. Nodes are
+//unique per structure, so this is the case iff they're the same node.
 bool StatementTree::equals(StatementTree& other)
+{ return this == &other; }
+
+//Same node apart from the negation flag
+bool StatementTree::equalsNegated(StatementTree& other)
 {
-  //Node type and negation flag must match
-  if(node_type != other.node_type) return false;
-  if(is_affirmed != other.is_affirmed) return false;
-  
-  //If the nodes are atoms, they must have the same name.
-  if(node_type == ATOM) return strcmp(atom_name, other.atom_name) == 0;
-  
-  //Otherwise their corresponding children must be equal.
-  list<StatementTree*>::iterator itr1 = children.begin();
-  list<StatementTree*>::iterator itr2 = other.children.begin();
-  for(; itr1 != children.end() && itr2 != other.children.end(); itr1++, itr2++)
-    if(!(*itr1)->equals(**itr2)) return false;
-  return itr1 == children.end() && itr2 == other.children.end();
+  return node_type == other.node_type && atom_id == other.atom_id &&
+    is_affirmed != other.is_affirmed && children[LEFT] == other.children[LEFT] &&
+    children[RIGHT] == other.children[RIGHT];
 }
 
 //Allocates and returns the string form of this tree.
@@ -222,6 +398,7 @@ char* StatementTree::createDisplayString()
   char* result = NULL;
   if(node_type == ATOM) //Display the atom name
   {
+    const char* atom_name = atomName();
     result = new char[strlen(atom_name)+1];
     strcpy(result, atom_name);
   }
@@ -231,7 +408,7 @@ char* StatementTree::createDisplayString()
     int inner_len = 0;
 
     //Find the strings for all children
-    for(list<StatementTree*>::iterator itr = children.begin(); itr != children.end(); itr++)
+    for(child_itr itr = begin(); itr != end(); itr++)
     {
       inner.push_back((*itr)->createDisplayString());
       inner_len += strlen(inner.back());
@@ -279,61 +456,73 @@ char* StatementTree::createDisplayString()
   return result;
 }
 
-void StatementTree::negate()
-{ is_affirmed = !is_affirmed; }
-
-//Removes any parentheses which enclose the whole string (i.e. ((a)) -> a;
-//((a&c)|(b&c)) -> (a&c)|(b&c)
-void StatementTree::stripParens(char* input)
+//Parses the sentence starting at pos, consuming operators which bind at least
+//as tightly as min_type. The right operand of each operator only takes tighter
+//operators, so a run of the same operator groups to the left. Advances pos past
+//the parsed text and returns NULL if the sentence isn't well-formed.
+StatementTree* StatementTree::parseExpression(const char*& pos, const char* end, int min_type)
 {
-  //Check for empty/null string
-  if(input == NULL) return;
-  int len = strlen(input);
-  if(len == 0) return;
+  StatementTree* left = parseOperand(pos, end);
+  if(left == NULL) return NULL;
   
-  int strip_count = 0;
-  while(true)
+  //Non-operator characters are ATOM, which is below OP_START, so this stops at
+  //a closing paren or the end of the input. Negation is only a prefix.
+  int type;
+  while(pos != end && (type = operatorType(*pos)) >= min_type && type != NOT)
   {
-    if(input[0] != '(') break;
-    
-    int paren_depth = 1;
-    int close_index;
-    for(close_index = strip_count+1; close_index < len; close_index++)
+    pos++;
+    StatementTree* right = parseExpression(pos, end, type+1);
+    if(right == NULL)
     {
-      if(input[close_index] == '(') paren_depth++;
-      else if(input[close_index] == ')') paren_depth--;
-      
-      if(paren_depth == 0) break;
+      releaseTree(left);
+      return NULL;
     }
-    
-    if(close_index != len-strip_count-1) break;
-    else strip_count++;
+    left = intern(type, true, -1, left, right);
   }
-  
-  input[len-strip_count] = '\0';
-  for(int i = strip_count; i <= len-strip_count; i++)
-    input[i-strip_count] = input[i];
+  return left;
 }
 
-//Returns the position of the first instance of the lowest order-of-operations
-//operator that appears outside of any parentheses (a&b&c -> 1, a&b|c -> 3,
-//(a&b)&c -> 3), i.e. the breakpoint.
-int StatementTree::findOperator(char* input) //Maybe look from right to left.
+//Parses negations followed by a parenthesized sentence or an atom. Negations
+//are consolidated into the operand's negation flag as they're read.
+StatementTree* StatementTree::parseOperand(const char*& pos, const char* end)
 {
-  int len = strlen(input);
-  for(int type = OP_START; type <= OP_END; type++)
+  bool affirmed = true;
+  for(; pos != end && operatorType(*pos) == NOT; pos++)
+    affirmed = !affirmed;
+  
+  StatementTree* operand;
+  if(pos != end && *pos == '(')
   {
-    //Iterate through order of operations
-    int paren_depth = 0;
-    for(int i = len-1; i >= 0; i--)
+    pos++;
+    operand = parseExpression(pos, end, OP_START);
+    if(operand == NULL) return NULL;
+    if(pos == end || *pos != ')')
     {
-      //Operator can't be within parentheses
-      if(input[i] == ')') paren_depth++;
-      else if(input[i] == '(') paren_depth--;
-      else if(paren_depth == 0 && operatorType(input[i]) == type) return i;
+      //Unmatched parenthesis
+      releaseTree(operand);
+      return NULL;
+    }
+    pos++;
+    
+    if(!affirmed)
+    {
+      StatementTree* negated = copyTree(*operand, false);
+      releaseTree(operand);
+      operand = negated;
     }
   }
-  return strlen(input);
+  else
+  {
+    //Atom names run until the next operator or parenthesis
+    const char* start = pos;
+    while(pos != end && *pos != '\0' && *pos != '(' && *pos != ')' && operatorType(*pos) == ATOM)
+      pos++;
+    if(pos == start) return NULL; //Missing operand
+    int atom = AtomTable::intern(start, pos-start);
+    if(atom == -1) return NULL; //No room for the name
+    operand = intern(ATOM, affirmed, atom, NULL, NULL);
+  }
+  return operand;
 }
 
 //Returns the integer code for the operation represented by the given character.
@@ -389,7 +578,7 @@ void StatementTree::DrawDebugGraph(int depth)
   for(int i = 0; i < depth; i++) std::cout << ' ';
   if(!is_affirmed) std::cout << '!';
   if(node_type != ATOM) std::cout << typeOperator(node_type) << '\n';
-  else std::cout << atom_name << '\n';
-  for(list<StatementTree*>::iterator itr = children.begin(); itr != children.end(); itr++)
+  else std::cout << atomName() << '\n';
+  for(child_itr itr = begin(); itr != end(); itr++)
     (*itr)->DrawDebugGraph(depth+1);
 }
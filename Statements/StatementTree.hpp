@@ -1,23 +1,71 @@
 #ifndef __STATEMENT_TREE_H_
 #define __STATEMENT_TREE_H_
 
-#include <list>
+#include "AtomTable.hpp"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#define TREE_POOL_BLOCK_NODES 1024
+#define TREE_POOL_TRIM_NODES (4 * TREE_POOL_BLOCK_NODES) //Free nodes in a shard before trimPool does anything
+#define TREE_SHARD_COUNT 16 //Locked separately, so threads rarely wait on each other
 
 class StatementTree;
 
 /// <summary>
-/// Type for the child nodes of a StatementTree
+/// Iterator for the child nodes of a StatementTree. Children are stored
+/// inline in the node, so this is a pointer into that array.
+/// </summary>
+typedef StatementTree** child_itr;
+
+/// <summary>
+/// Structural hash of a statement tree. Depends only on the structure of the
+/// tree and its proposition names, so it's the same across runs.
+/// </summary>
+typedef unsigned long long tree_hash;
+
+/// <summary>
+/// Table of all existing statement tree nodes, keyed by structural hash.
 /// </summary>
-typedef std::list<StatementTree*> tree_list;
+typedef std::unordered_multimap<tree_hash, StatementTree*> intern_table;
+
 /// <summary>
-/// Iterator for tree_list
+/// One part of the table of nodes, holding the nodes whose hash falls in it
+/// and the pool they're allocated from. Everything in it is guarded by its
+/// lock.
 /// </summary>
-typedef std::list<StatementTree*>::iterator child_itr;
+struct tree_shard
+{
+  intern_table trees;
+  std::vector<char*> pool_blocks;
+  StatementTree* pool_free_list;
+  size_t pool_free_count; //Nodes on the free list
+  size_t pool_trim_at; //Free nodes needed for trimPool to look for empty blocks
+  std::mutex lock;
+
+  tree_shard() : pool_free_list(NULL), pool_free_count(0), pool_trim_at(TREE_POOL_TRIM_NODES)
+  {}
+};
 
 /// <summary>
 /// Abstract syntax tree for a logical statement. Negation is consolidated as
 /// a boolean flag on nodes, rather than a separate node. Thus all non-leaf
 /// nodes are binary.
+///
+/// Nodes are hash-consed: there is only ever one node for a given structure
+/// (including negation flags), and it's shared by every tree containing that
+/// subsentence. Nodes are therefore immutable and reference counted. They are
+/// obtained with create and given back with release rather than new/delete,
+/// and two trees are equal iff they are the same node.
+///
+/// create and release may be called from any thread. The table is split into
+/// TREE_SHARD_COUNT shards by hash, each with its own lock, so threads
+/// parsing or matching at the same time seldom wait for each other.
+/// Reference counts are atomic, and only the last release of a node takes
+/// its shard's lock. Everything else only reads nodes, which never change
+/// while a reference to them is held.
 /// </summary>
 class StatementTree
 {
@@ -26,37 +74,192 @@ class StatementTree
   const static int ATOM = 0, IFF = 1, IMPLIES = 2, OR = 3, AND = 4, NOT = 5;
   const static int OP_START = 1, OP_END = 5;
   const static int ONLY = 0, LEFT = 0, RIGHT = 1;
-  const static int IS_INVALID = 0, IS_VALID = 1, VALIDITY_UNKNOWN = 2;
-  
+
   private:
+  static tree_shard shards[TREE_SHARD_COUNT];
+  static std::atomic<unsigned int> malformed_count; //For the ids of malformed sentences
+
   int node_type;
-  std::list<StatementTree*> children;
-  char* atom_name;
+  union
+  {
+    StatementTree* children[2];
+    char* malformed_text; //For a malformed sentence, which has no children
+  };
+  int atom_id; //Id in AtomTable for an atom, below -1 for a malformed sentence, -1 otherwise
   bool is_affirmed;
-  int validity; //Caches well-formedness
-  
-  void consolidateNegation();
-  void consolidateChildren();
-  
+  bool is_valid; //Well-formedness, worked out when the node is created
+  tree_hash structure_hash;
+  std::atomic<int> ref_count;
+
+  StatementTree(int type, bool affirmed, int atom, StatementTree* left,
+    StatementTree* right, tree_hash hash);
+  ~StatementTree();
+
+  /// <summary>
+  /// Finds the shard a node with the given hash belongs to.
+  /// </summary>
+  static tree_shard& shardFor(tree_hash hash);
+
+  /// <summary>
+  /// Nodes are carved out of large blocks rather than allocated one by one,
+  /// from the pool of the shard they belong to. Freed nodes go on the
+  /// shard's free list (linked through their first word) to be reused by the
+  /// next node created there. Blocks stay allocated until trimPool finds
+  /// every node in them free. The shard's lock must be held.
+  /// </summary>
+  static void* allocateNode(tree_shard& shard);
+  static void freeNode(StatementTree* node, tree_shard& shard);
+
+  /// <summary>
+  /// Finds the node with the given contents, creating it if there isn't one
+  /// yet. Takes over the caller's references to left and right.
+  /// </summary>
+  /// <param name="type">Node type</param>
+  /// <param name="affirmed">Negation flag</param>
+  /// <param name="atom">For an atom, the proposition id. Otherwise -1.</param>
+  /// <param name="left">For an operator, the left child. Otherwise null.</param>
+  /// <param name="right">For an operator, the right child. Otherwise null.</param>
+  /// <returns>Referenced node</returns>
+  static StatementTree* intern(int type, bool affirmed, int atom,
+    StatementTree* left, StatementTree* right);
+
+  /// <summary>
+  /// Makes the node for a sentence that isn't well-formed: an atom holding
+  /// the text as written, which isValid rejects. The text isn't added to
+  /// AtomTable, and the node isn't interned, so it's freed along with the
+  /// text once released. Each one gets its own negative atom id, so passes
+  /// that index atoms by id take it as a proposition of its own.
+  /// </summary>
+  /// <param name="text">Sentence as written. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the sentence</param>
+  /// <param name="affirmed">Negation flag</param>
+  /// <returns>Referenced node</returns>
+  static StatementTree* createMalformed(const char* text, int length, bool affirmed);
+
+  /// <summary>
+  /// Whether this node has the given contents. Children are compared by
+  /// address, since they're interned already.
+  /// </summary>
+  bool hasContents(int type, bool affirmed, int atom, StatementTree* left,
+    StatementTree* right);
+
+  /// <summary>
+  /// Does the work of create for an existing tree.
+  /// </summary>
+  static StatementTree* copyTree(StatementTree& other, bool dontNegate=true);
+
+  /// <summary>
+  /// Does the work of release.
+  /// </summary>
+  static void releaseTree(StatementTree* tree);
+
+#pragma region ParsingHelpers
+  /// <summary>
+  /// Parses a sentence by precedence climbing, in a single left to right pass
+  /// over the input. Parses an operand, then keeps extending it to the right
+  /// for as long as the next operator binds at least as tightly as min_type.
+  /// Operators of the same type group to the left (a&b&c -> (a&b)&c), and
+  /// any negation is folded into the negation flag of its operand.
+  /// </summary>
+  /// <param name="pos">
+  ///	Position in the input string. Will be advanced past the parsed text.
+  /// </param>
+  /// <param name="end">End of the input, one past the last character</param>
+  /// <param name="min_type">
+  ///	Loosest-binding operator type to consume; OP_START for a whole sentence.
+  /// </param>
+  /// <returns>
+  ///	Referenced tree, or null if the input is not well-formed.
+  /// </returns>
+  static StatementTree* parseExpression(const char*& pos, const char* end, int min_type);
+
+  /// <summary>
+  /// Helper for parseExpression. Parses any leading negations followed by
+  /// either a parenthesized sentence or an atom.
+  /// </summary>
+  /// <param name="pos">
+  ///	Position in the input string. Will be advanced past the parsed text.
+  /// </param>
+  /// <param name="end">End of the input, one past the last character</param>
+  /// <returns>
+  ///	Referenced tree, or null if the input is not well-formed.
+  /// </returns>
+  static StatementTree* parseOperand(const char*& pos, const char* end);
+#pragma endregion
+
   public:
 
   /// <summary>
-  /// Construct a syntax tree by parsing an infix notation string.
+  /// Get the syntax tree for an infix notation string. If the string is not a
+  /// well-formed sentence, the tree will be a single atom holding the whole
+  /// string, which isValid will reject. That atom isn't shared with any other
+  /// tree, or kept once released.
+  /// </summary>
+  /// <param name="input">Logical sentence to parse into a tree</param>
+  /// <returns>Tree, which must be given back with release</returns>
+  static StatementTree* create(const char* input);
+
+  /// <summary>
+  /// Get the syntax tree for the first length characters of a string, which
+  /// doesn't need to be null terminated.
   /// </summary>
   /// <param name="input">Logical sentence to parse into a tree</param>
-  StatementTree(const char* input);
-  
+  /// <param name="length">Number of characters in the sentence</param>
+  /// <returns>Tree, which must be given back with release</returns>
+  static StatementTree* create(const char* input, int length);
+
   /// <summary>
-  /// Copy constructor
+  /// Get a copy of a tree. As trees are shared this takes another reference
+  /// to the same node, unless the negation at the root is inverted.
   /// </summary>
   /// <param name="other">Syntax tree to copy</param>
   /// <param name="dontNegate">
   ///	If false, the negation flag at the root of the new tree will be
   ///	inverted compared to the original tree.
   /// </param>
-  StatementTree(StatementTree& other, bool dontNegate=true);
-  ~StatementTree();
-  
+  /// <returns>Tree, which must be given back with release</returns>
+  static StatementTree* create(StatementTree& other, bool dontNegate=true);
+
+  /// <summary>
+  /// Get the node for an atom directly, without parsing. The name is used as
+  /// is, so one that isn't a valid atom name gives a tree that isValid
+  /// rejects, like the one create gives for a sentence that isn't well-formed.
+  /// </summary>
+  /// <param name="name">Proposition name. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the name</param>
+  /// <param name="affirmed">Negation flag</param>
+  /// <returns>Tree, which must be given back with release</returns>
+  static StatementTree* createAtom(const char* name, int length, bool affirmed=true);
+
+  /// <summary>
+  /// Get the node for an operator directly, without parsing. Takes over the
+  /// caller's references to left and right.
+  /// </summary>
+  /// <param name="type">Operator type, from IFF to AND</param>
+  /// <param name="affirmed">Negation flag</param>
+  /// <param name="left">Left child</param>
+  /// <param name="right">Right child</param>
+  /// <returns>Tree, which must be given back with release</returns>
+  static StatementTree* createOperator(int type, bool affirmed, StatementTree* left,
+    StatementTree* right);
+
+  /// <summary>
+  /// Give back a reference obtained from create. The tree is freed once no
+  /// references to it are left. Does nothing for null.
+  /// </summary>
+  /// <param name="tree">Tree to release</param>
+  static void release(StatementTree* tree);
+
+  /// <summary>
+  /// Gives pool blocks whose nodes are all free back to the system. Nodes
+  /// are shared between proofs, so this can't be done when a single proof
+  /// is freed; instead it's called after, and frees whatever blocks no tree
+  /// is using any more. Looking costs time in the number of free nodes, so
+  /// nothing is done to a shard until it has at least TREE_POOL_TRIM_NODES of
+  /// them, and twice as many as were left after its last trim.
+  /// </summary>
+  static void trimPool();
+
 #pragma region Iteration
   child_itr begin();
   child_itr end();
@@ -101,7 +304,34 @@ class StatementTree
   /// For an atomic statement, the string for this particular proposition.
   /// </summary>
   /// <returns>Proposition</returns>
-  char* atomName();
+  const char* atomName();
+
+  /// <summary>
+  /// For an atomic statement, the AtomTable id of the proposition. Atoms
+  /// with the same name have the same id.
+  /// </summary>
+  /// <returns>
+  ///   Proposition id, -1 if this is not an atom, or a unique id below -1 for
+  ///   a sentence that isn't well-formed
+  /// </returns>
+  int atomId();
+
+  /// <summary>
+  /// Hash of the structure of this tree, including negation flags and
+  /// proposition names. Equal trees have equal hashes.
+  /// </summary>
+  /// <returns>Structural hash</returns>
+  tree_hash structureHash();
+
+  /// <summary>
+  /// Combines a value into a hash. This is how structural hashes are built
+  /// from the hashes of children, and can be used to build other hashes from
+  /// them in the same way.
+  /// </summary>
+  /// <param name="hash">Hash so far</param>
+  /// <param name="value">Value to mix in</param>
+  /// <returns>Combined hash</returns>
+  static tree_hash mixHash(tree_hash hash, tree_hash value);
 
   /// <summary>
   /// Does this node represent an associative operator?
@@ -120,42 +350,29 @@ class StatementTree
   bool isCommutative();
 #pragma endregion
 
-  /// <summary>
-  /// Flip the negation flag on this node
-  /// </summary>
-  void negate();
-
   /// <summary>
   /// Is this statement tree equivalent to another one? For an atom, this is
   /// true if the other also is and the proposition is the same. For other
   /// nodes, the operator and negation flag must be the same, and the
-  /// corresponding child nodes must be equivalent.
+  /// corresponding child nodes must be equivalent. As nodes are hash-consed
+  /// this is just an address comparison.
   /// </summary>
   /// <param name="other">Statement tree to compare with</param>
   /// <returns>True if the trees are equivalent</returns>
   bool equals(StatementTree& other);
-  
-#pragma region ParsingHelpers
-  /// <summary>
-  /// Removes matching parentheses from the start and end of a string, until
-  /// there are no sets of parentheses that enclose the whole string.
-  /// </summary>
-  /// <param name="input">String to remove parens from</param>
-  static void stripParens(char* input);
 
   /// <summary>
-  /// Returns the position of an operator which is not enclosed by any
-  /// parentheses in a string. If there are multiple such operators, the one
-  /// returned will be the earliest one in the order of operations. If there's
-  /// still multiple, will return the first (leftmost) one.
+  /// Is the other tree the same as this one, except with the negation flag at
+  /// the root inverted? Used to compare views of trees with an inverted root
+  /// without creating the inverted tree. Children are interned, so this only
+  /// needs to look at the root nodes.
   /// </summary>
-  /// <param name="input">String to check for operators</param>
-  /// <returns>
-  ///	Position of the relevant operator in the string. If none is found,
-  ///	returns the end of the string.
-  /// </returns>
-  static int findOperator(char* input);
+  /// <param name="other">Statement tree to compare with</param>
+  /// <returns>True if other is the negation of this tree</returns>
+  bool equalsNegated(StatementTree& other);
 
+
+#pragma region Operators
   /// <summary>
   /// Returns which operation a character represents
   /// </summary>
@@ -177,7 +394,7 @@ class StatementTree
   /// <returns>=, >, |, &, or !. Returns space for an ATOM</returns>
   static char typeOperator(int input);
 #pragma endregion
-  
+
 #pragma region Display
   /// <summary>
   /// Constructs a string representing this syntax tree in infix notation.
@@ -6,22 +6,25 @@ using std::pair;
 Assumption SubProof::subproof_assumption;
 //Static justification for all subproof assumptions.
 
-SubProof::SubProof(const char* input) : ProofStatement(input)
+SubProof::SubProof(const char* input, ProofArena& arena) : ProofStatement(input)
 {
-  assumption = new ProofStatement(input, true);
+  assumption = new (arena) ProofStatement(input, true);
   assumption->setParent(this);
   assumption->setJustification(&subproof_assumption);
 }
 
-SubProof::SubProof(StatementTree* input) : ProofStatement(input)
+SubProof::SubProof(StatementTree* input, ProofArena& arena) : ProofStatement(input)
 {
-  assumption = new ProofStatement(input, true);
+  assumption = new (arena) ProofStatement(input, true);
   assumption->setParent(this);
   assumption->setJustification(&subproof_assumption);
 }
 
+//The assumption line is in the same arena, and is destroyed along with it
 SubProof::~SubProof()
-{ delete assumption; }
+{
+  //This space left intentionally blank
+}
 
 StatementTree* SubProof::getStatementData()
 { return NULL; }
@@ -33,7 +36,7 @@ ProofStatement* SubProof::getAssumptionStatement()
 { return assumption; }
 
 //Subproofs are justified iff their assumption is well-formed
-bool SubProof::isJustified()
+bool SubProof::isJustified(VerificationCache*)
 {
   bool result = assumption->getStatementData()->isValid();
   fail_type = (result)?NO_FAILURE:INVALID_STATEMENT;
@@ -55,6 +58,9 @@ char* SubProof::createDisplayString()
 void SubProof::rewrite(const char* input)
 { assumption->rewrite(input); }
 
+void SubProof::rewrite(const char* input, int length)
+{ assumption->rewrite(input, length); }
+
 void SubProof::rewrite(StatementTree* input)
 { assumption->rewrite(input); }
 
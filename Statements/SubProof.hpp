@@ -28,14 +28,16 @@ class SubProof : public ProofStatement
   /// tree for the subproof's assumption statement.
   /// </summary>
   /// <param name="input">Logical sentence assumed by the subproof</param>
-  SubProof(const char* input);
+  /// <param name="arena">Arena of the proof, for the assumption line</param>
+  SubProof(const char* input, ProofArena& arena);
 
   /// <summary>
   /// Construct a subproof. The input syntax tree will be copied into the
   /// assumption statement
   /// </summary>
   /// <param name="input">Subproof assumption</param>
-  SubProof(StatementTree* input);
+  /// <param name="arena">Arena of the proof, for the assumption line</param>
+  SubProof(StatementTree* input, ProofArena& arena);
   virtual ~SubProof();
   
   /// <summary>
@@ -68,7 +70,7 @@ class SubProof : public ProofStatement
   /// <returns>
   ///   True if the subproof's assumption is well formed, false othewise.
   /// </returns>
-  bool isJustified();
+  bool isJustified(VerificationCache* cache = NULL);
   
   /// <summary>
   /// Gets the derived lines in this subproof, for checking whether it's a
@@ -106,6 +108,14 @@ class SubProof : public ProofStatement
   /// </param>
   void rewrite(const char* input);
 
+  /// <summary>
+  /// Change the sentence in the assumption line, given as the first length
+  /// characters of a string.
+  /// </summary>
+  /// <param name="input">Logical sentence. Doesn't need to be null terminated.</param>
+  /// <param name="length">Number of characters in the sentence</param>
+  void rewrite(const char* input, int length);
+
   /// <summary>
   /// Change the sentence in a proof line to a new one. For a subproof this
   /// changes the sentence in the assumption line.
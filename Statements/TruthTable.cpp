@@ -0,0 +1,170 @@
+#include "TruthTable.hpp"
+
+using std::unordered_map;
+using std::vector;
+
+//Bit patterns for the atoms that vary within a word: bit i of the word is
+//assignment i, and atom v is true in it when bit v of i is set.
+static const unsigned long long word_patterns[TRUTH_TABLE_WORD_ATOMS] = {
+  0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+  0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL };
+
+//Adds the tree's nodes children first. Iterative so that very deep trees don't
+//exhaust the stack.
+int TruthTable::addSentence(StatementTree* tree)
+{
+  vector<StatementTree*> pending(1, tree);
+  while(!pending.empty())
+  {
+    StatementTree* node = pending.back();
+    if(tree_steps.find(node) != tree_steps.end())
+    {
+      pending.pop_back();
+      continue;
+    }
+
+    bool children_added = true;
+    for(child_itr itr = node->begin(); itr != node->end(); itr++)
+    {
+      if(tree_steps.find(*itr) == tree_steps.end())
+      {
+        pending.push_back(*itr);
+        children_added = false;
+      }
+    }
+    if(!children_added) continue;
+    pending.pop_back();
+
+    truth_table_step step;
+    step.node_type = node->nodeType();
+    step.affirmed = node->isAffirmed();
+    step.left = step.right = 0;
+    if(step.node_type == StatementTree::ATOM)
+    {
+      unordered_map<int, int>::iterator found = variables.find(node->atomId());
+      if(found == variables.end())
+        found = variables.insert(std::make_pair(node->atomId(), (int)variables.size())).first;
+      step.left = found->second;
+    }
+    else
+    {
+      step.left = tree_steps[node->begin()[StatementTree::LEFT]];
+      step.right = tree_steps[node->begin()[StatementTree::RIGHT]];
+    }
+    int index = steps.size();
+    steps.push_back(step);
+    tree_steps[node] = index;
+  }
+  return tree_steps[tree];
+}
+
+int TruthTable::atomCount()
+{ return variables.size(); }
+
+//Pseudo-random word for a sampled atom, from the assignment's word number and
+//the atom's variable number (the finalizer of splitmix64), so that the same
+//assignments are tried every time.
+static unsigned long long sampleWord(unsigned long long word, int variable)
+{
+  unsigned long long value = word * 0x9E3779B97F4A7C15ULL + (unsigned long long)(variable + 1);
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+//Word w of block b holds assignments (b*LANES + w)*64 onwards, so atoms past
+//the ones that vary within a word are constant across it, set by the bits of
+//b*LANES + w.
+void TruthTable::evaluateBlock(unsigned long long block, unsigned long long* values, bool sampled)
+{
+  for(size_t i = 0; i < steps.size(); i++)
+  {
+    const truth_table_step& step = steps[i];
+    unsigned long long* out = values + i * TRUTH_TABLE_LANES;
+    const unsigned long long* left = values + step.left * TRUTH_TABLE_LANES;
+    const unsigned long long* right = values + step.right * TRUTH_TABLE_LANES;
+    switch(step.node_type)
+    {
+    case StatementTree::ATOM:
+      for(int lane = 0; lane < TRUTH_TABLE_LANES; lane++)
+      {
+        if(step.left < TRUTH_TABLE_WORD_ATOMS)
+          out[lane] = word_patterns[step.left];
+        else if(sampled)
+          out[lane] = sampleWord(block * TRUTH_TABLE_LANES + lane, step.left);
+        else
+          out[lane] = (((block * TRUTH_TABLE_LANES + lane) >> (step.left - TRUTH_TABLE_WORD_ATOMS)) & 1) ?
+            ~0ULL : 0;
+      }
+      break;
+    case StatementTree::AND:
+      for(int lane = 0; lane < TRUTH_TABLE_LANES; lane++)
+        out[lane] = left[lane] & right[lane];
+      break;
+    case StatementTree::OR:
+      for(int lane = 0; lane < TRUTH_TABLE_LANES; lane++)
+        out[lane] = left[lane] | right[lane];
+      break;
+    case StatementTree::IMPLIES:
+      for(int lane = 0; lane < TRUTH_TABLE_LANES; lane++)
+        out[lane] = ~left[lane] | right[lane];
+      break;
+    case StatementTree::IFF:
+      for(int lane = 0; lane < TRUTH_TABLE_LANES; lane++)
+        out[lane] = ~(left[lane] ^ right[lane]);
+      break;
+    }
+    if(!step.affirmed)
+    {
+      for(int lane = 0; lane < TRUTH_TABLE_LANES; lane++)
+        out[lane] = ~out[lane];
+    }
+  }
+}
+
+bool TruthTable::findCounterexample(const vector<int>& premises, int conclusion,
+  unsigned long long blocks, bool sampled)
+{
+  vector<unsigned long long> values(steps.size() * TRUTH_TABLE_LANES);
+  for(unsigned long long block = 0; block < blocks; block++)
+  {
+    evaluateBlock(block, &values[0], sampled);
+    unsigned long long counterexamples = 0;
+    for(int lane = 0; lane < TRUTH_TABLE_LANES; lane++)
+    {
+      //Assignments where every premise holds but the conclusion doesn't
+      unsigned long long word = ~values[conclusion * TRUTH_TABLE_LANES + lane];
+      for(size_t i = 0; i < premises.size(); i++)
+        word &= values[premises[i] * TRUTH_TABLE_LANES + lane];
+      counterexamples |= word;
+    }
+    if(counterexamples != 0) return true;
+  }
+  return false;
+}
+
+//With few atoms the block covers every assignment several times over, which
+//doesn't change the answer.
+bool TruthTable::entails(const vector<int>& premises, int conclusion)
+{
+  int extra_atoms = atomCount() - TRUTH_TABLE_WORD_ATOMS;
+  unsigned long long words = (extra_atoms > 0) ? (1ULL << extra_atoms) : 1;
+  unsigned long long blocks = (words + TRUTH_TABLE_LANES - 1) / TRUTH_TABLE_LANES;
+  return !findCounterexample(premises, conclusion, blocks, false);
+}
+
+//Whether max_blocks covers every assignment is worked out without shifting
+//past the width of a word.
+bool TruthTable::refutes(const vector<int>& premises, int conclusion,
+  unsigned long long max_blocks)
+{
+  int extra_atoms = atomCount() - TRUTH_TABLE_WORD_ATOMS;
+  if(extra_atoms < TRUTH_TABLE_WORD_BITS - 2)
+  {
+    unsigned long long words = (extra_atoms > 0) ? (1ULL << extra_atoms) : 1;
+    unsigned long long blocks = (words + TRUTH_TABLE_LANES - 1) / TRUTH_TABLE_LANES;
+    if(blocks <= max_blocks)
+      return findCounterexample(premises, conclusion, blocks, false);
+  }
+  return findCounterexample(premises, conclusion, max_blocks, true);
+}
@@ -0,0 +1,112 @@
+#ifndef __TRUTH_TABLE_H_
+#define __TRUTH_TABLE_H_
+
+#include "StatementTree.hpp"
+#include <unordered_map>
+#include <vector>
+
+#define TRUTH_TABLE_MAX_ATOMS 24
+#define TRUTH_TABLE_WORD_BITS 64
+#define TRUTH_TABLE_WORD_ATOMS 6 //Atoms that vary within one word
+#define TRUTH_TABLE_LANES 4 //Words evaluated together
+
+/// <summary>
+/// One node of the sentences in a TruthTable, evaluated after its children.
+/// For an atom, left is its variable number and right is unused; otherwise
+/// they're the steps of the children.
+/// </summary>
+struct truth_table_step
+{
+  int node_type;
+  bool affirmed;
+  int left;
+  int right;
+};
+
+/// <summary>
+/// Evaluates sentences on every assignment of truth values to their atoms,
+/// by brute force but many assignments at once. Each word of a result holds
+/// the sentence's value under 64 assignments, one per bit, so an operator is
+/// evaluated on all 64 with a single bitwise instruction. Several words
+/// (TRUTH_TABLE_LANES) are evaluated side by side in plain loops, which the
+/// compiler can turn into SIMD instructions where the machine has them.
+///
+/// Sentences are added first, and compiled to a list of steps with each
+/// distinct subtree evaluated once. Atoms are told apart by their AtomTable
+/// id, so the same atom in different sentences is the same variable.
+/// </summary>
+class TruthTable
+{
+  private:
+  std::vector<truth_table_step> steps;
+  std::unordered_map<StatementTree*, int> tree_steps;
+  std::unordered_map<int, int> variables; //Variable number by atom id
+
+  /// <summary>
+  /// Evaluates every step on one block of assignments.
+  /// </summary>
+  /// <param name="block">Which block of TRUTH_TABLE_LANES words</param>
+  /// <param name="values">TRUTH_TABLE_LANES words for each step, set to the results</param>
+  /// <param name="sampled">
+  ///   If true, atoms past the ones that vary within a word take pseudo-random
+  ///   values instead, which differ from bit to bit.
+  /// </param>
+  void evaluateBlock(unsigned long long block, unsigned long long* values, bool sampled);
+
+  /// <summary>
+  /// Looks for an assignment that makes all the premises true and the
+  /// conclusion false, on a number of blocks from the first.
+  /// </summary>
+  /// <param name="premises">Indices of the premise sentences</param>
+  /// <param name="conclusion">Index of the conclusion</param>
+  /// <param name="blocks">Number of blocks to evaluate</param>
+  /// <param name="sampled">Whether the blocks are sampled, as for evaluateBlock</param>
+  /// <returns>True if such an assignment was found</returns>
+  bool findCounterexample(const std::vector<int>& premises, int conclusion,
+    unsigned long long blocks, bool sampled);
+
+  public:
+  /// <summary>
+  /// Adds a sentence to be evaluated, along with any of its subtrees not
+  /// added yet.
+  /// </summary>
+  /// <param name="tree">Sentence to add</param>
+  /// <returns>Index of the sentence, to refer to it in entails</returns>
+  int addSentence(StatementTree* tree);
+
+  /// <summary>
+  /// Number of distinct atoms in the sentences added so far. A table has
+  /// 2^atomCount assignments.
+  /// </summary>
+  /// <returns>Number of atoms</returns>
+  int atomCount();
+
+  /// <summary>
+  /// Checks whether some sentences together entail another: every
+  /// assignment that makes all the premises true makes the conclusion true.
+  /// Stops at the first assignment that doesn't.
+  /// </summary>
+  /// <param name="premises">Indices of the premise sentences from addSentence</param>
+  /// <param name="conclusion">Index of the conclusion from addSentence</param>
+  /// <returns>True if the premises entail the conclusion</returns>
+  bool entails(const std::vector<int>& premises, int conclusion);
+
+  /// <summary>
+  /// A quick check that can only show some sentences don't entail another.
+  /// At most max_blocks blocks of TRUTH_TABLE_LANES * 64 assignments are
+  /// evaluated: if that covers every assignment this is the same as entails,
+  /// otherwise the atoms that don't vary within a word are given pseudo-random
+  /// values. Not limited to TRUTH_TABLE_MAX_ATOMS atoms.
+  /// </summary>
+  /// <param name="premises">Indices of the premise sentences from addSentence</param>
+  /// <param name="conclusion">Index of the conclusion from addSentence</param>
+  /// <param name="max_blocks">Most blocks of assignments to evaluate</param>
+  /// <returns>
+  ///   True if some assignment makes all the premises true and the conclusion
+  ///   false. False doesn't mean the premises entail the conclusion unless
+  ///   every assignment was covered.
+  /// </returns>
+  bool refutes(const std::vector<int>& premises, int conclusion, unsigned long long max_blocks);
+};
+
+#endif
@@ -0,0 +1,383 @@
+#include "VerificationCache.hpp"
+#include "Justification.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+using std::lock_guard;
+using std::mutex;
+using std::pair;
+using std::string;
+using std::vector;
+
+#define CACHE_HEADER_SIZE 8
+#define CACHE_LENGTH_SIZE 4
+
+//Magic bytes, then the format version. Changing how keys are computed means
+//changing the version, so old results are thrown out.
+static const unsigned char cache_header[CACHE_HEADER_SIZE] =
+  { 'L', 'O', 'G', 'I', 'C', 'V', 'C', CACHE_FORMAT_VERSION };
+
+VerificationCache::VerificationCache() : file_valid(false)
+{
+  //This space left intentionally blank
+}
+
+//Gives back the references held for node keys.
+VerificationCache::~VerificationCache()
+{
+  for(int i = 0; i < CACHE_SHARD_COUNT; i++)
+    clearShard(shards[i]);
+}
+
+//Any results already in the cache are replaced by the file's. The path is set
+//with the shards locked, as store reads it.
+bool VerificationCache::open(const char* directory)
+{
+  lock_guard<mutex> guard(file_lock);
+  string dir = directory;
+  lockShards();
+#if defined(_WIN32)
+  _mkdir(dir.c_str());
+  file_path = dir + "\\" + CACHE_FILE_NAME;
+#else
+  mkdir(dir.c_str(), 0777);
+  file_path = dir + "/" + CACHE_FILE_NAME;
+#endif
+  for(int i = 0; i < CACHE_SHARD_COUNT; i++)
+    clearShard(shards[i]);
+  file_valid = false;
+  bool opened = readFile();
+  if(!opened) file_path.clear();
+  unlockShards();
+  return opened;
+}
+
+//Reads every whole record in the file. A partial record at the end (from a
+//run that stopped while saving) is ignored.
+bool VerificationCache::readFile()
+{
+  FILE* file = fopen(file_path.c_str(), "rb");
+  if(file == NULL)
+  {
+    //Nothing cached yet. Make sure the file can be made before relying on it.
+    file = fopen(file_path.c_str(), "ab");
+    if(file == NULL) return false;
+    fclose(file);
+    return true;
+  }
+
+  unsigned char header[CACHE_HEADER_SIZE];
+  if(fread(header, 1, CACHE_HEADER_SIZE, file) != CACHE_HEADER_SIZE ||
+    memcmp(header, cache_header, CACHE_HEADER_SIZE) != 0)
+  {
+    fclose(file);
+    return true;
+  }
+  file_valid = true;
+
+  unsigned char length_bytes[CACHE_LENGTH_SIZE];
+  string line_key;
+  while(fread(length_bytes, 1, CACHE_LENGTH_SIZE, file) == CACHE_LENGTH_SIZE)
+  {
+    //Lengths are stored little-endian so the file doesn't depend on the machine
+    unsigned long length = 0;
+    for(int i = CACHE_LENGTH_SIZE - 1; i >= 0; i--)
+      length = (length << 8) | length_bytes[i];
+    if(length > CACHE_KEY_LIMIT) break;
+
+    //The key, then its result
+    line_key.resize(length + 1);
+    if(fread(&line_key[0], 1, length + 1, file) != length + 1) break;
+    bool result = (line_key[length] != 0);
+    line_key.resize(length);
+    shardFor(line_key).results[line_key] = result;
+  }
+  fclose(file);
+  return true;
+}
+
+//Appends to the file if it already has a valid header, otherwise rewrites it
+//with everything in the cache.
+bool VerificationCache::save()
+{
+  lock_guard<mutex> guard(file_lock);
+  if(file_path.empty()) return false;
+  lockShards();
+  bool written = writeFile();
+  unlockShards();
+  return written;
+}
+
+//Called with every shard locked.
+bool VerificationCache::writeFile()
+{
+  vector<pair<string, bool> > new_results;
+  for(int i = 0; i < CACHE_SHARD_COUNT; i++)
+  {
+    if(file_valid)
+      new_results.insert(new_results.end(), shards[i].new_results.begin(), shards[i].new_results.end());
+    else
+      new_results.insert(new_results.end(), shards[i].results.begin(), shards[i].results.end());
+  }
+  if(file_valid && new_results.empty()) return true;
+
+  FILE* file;
+  if(file_valid)
+  {
+    file = fopen(file_path.c_str(), "ab");
+    if(file == NULL) return false;
+  }
+  else
+  {
+    file = fopen(file_path.c_str(), "wb");
+    if(file == NULL) return false;
+    fwrite(cache_header, 1, CACHE_HEADER_SIZE, file);
+  }
+
+  unsigned char length_bytes[CACHE_LENGTH_SIZE];
+  for(unsigned int i = 0; i < new_results.size(); i++)
+  {
+    string& line_key = new_results[i].first;
+    unsigned long length = line_key.size();
+    for(int j = 0; j < CACHE_LENGTH_SIZE; j++)
+    {
+      length_bytes[j] = (unsigned char)(length & 0xFF);
+      length >>= 8;
+    }
+    unsigned char result = new_results[i].second ? 1 : 0;
+    fwrite(length_bytes, 1, CACHE_LENGTH_SIZE, file);
+    fwrite(line_key.data(), 1, line_key.size(), file);
+    fwrite(&result, 1, 1, file);
+  }
+
+  bool written = (fclose(file) == 0);
+  if(written)
+  {
+    file_valid = true;
+    for(int i = 0; i < CACHE_SHARD_COUNT; i++)
+      shards[i].new_results.clear();
+  }
+  return written;
+}
+
+bool VerificationCache::lookup(const string& line_key, bool& result)
+{
+  cache_shard& shard = shardFor(line_key);
+  lock_guard<mutex> guard(shard.lock);
+  std::unordered_map<string, bool>::iterator found = shard.results.find(line_key);
+  if(found == shard.results.end()) return false;
+  result = found->second;
+  return true;
+}
+
+//Lines are checked the same way every time, so a result that's already
+//stored is never different and doesn't need writing again. Without a file,
+//there's nothing to write it to, and the key's nodes are held instead.
+void VerificationCache::store(const string& line_key, bool result,
+  StatementTree& consequent, antecedent_list& antecedents)
+{
+  cache_shard& shard = shardFor(line_key);
+  lock_guard<mutex> guard(shard.lock);
+  if(!file_path.empty())
+  {
+    if(shard.results.insert(pair<string, bool>(line_key, result)).second)
+      shard.new_results.push_back(pair<string, bool>(line_key, result));
+    return;
+  }
+
+  if(shard.results.size() >= CACHE_MEMORY_ENTRIES) clearShard(shard);
+  if(!shard.results.insert(pair<string, bool>(line_key, result)).second) return;
+  shard.held.push_back(StatementTree::create(consequent));
+  for(antecedent_list::iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+    holdAntecedent(*itr, shard.held);
+}
+
+int VerificationCache::size()
+{
+  int total = 0;
+  for(int i = 0; i < CACHE_SHARD_COUNT; i++)
+  {
+    lock_guard<mutex> guard(shards[i].lock);
+    total += shards[i].results.size();
+  }
+  return total;
+}
+
+//The low bits pick the bucket within the shard's map, so use the high ones.
+cache_shard& VerificationCache::shardFor(const string& line_key)
+{ return shards[(std::hash<string>()(line_key) >> 16) % CACHE_SHARD_COUNT]; }
+
+void VerificationCache::lockShards()
+{
+  for(int i = 0; i < CACHE_SHARD_COUNT; i++)
+    shards[i].lock.lock();
+}
+
+void VerificationCache::unlockShards()
+{
+  for(int i = 0; i < CACHE_SHARD_COUNT; i++)
+    shards[i].lock.unlock();
+}
+
+void VerificationCache::clearShard(cache_shard& shard)
+{
+  shard.results.clear();
+  shard.new_results.clear();
+  for(unsigned int i = 0; i < shard.held.size(); i++)
+    StatementTree::release(shard.held[i]);
+  shard.held.clear();
+}
+
+//Writes a little-endian number of bytes from a value.
+static void appendNumber(unsigned long long value, int bytes, string& line_key)
+{
+  for(int i = 0; i < bytes; i++)
+  {
+    line_key += (char)(value & 0xFF);
+    value >>= 8;
+  }
+}
+
+//The rule, then the consequent, then the number of antecedents and each one
+//in order. Every part is either a fixed size or ends in a marker, so no two
+//lines that differ have the same key.
+bool VerificationCache::key(StatementTree& consequent, Justification& rule,
+  antecedent_list& antecedents, string& line_key)
+{
+  line_key.clear();
+  if(file_path.empty())
+  {
+    //Equal trees are the same node, so addresses are enough while held
+    appendNumber(rule.getId(), 8, line_key);
+    appendNumber((uintptr_t)&consequent, sizeof(uintptr_t), line_key);
+    appendNumber(antecedents.size(), 4, line_key);
+    for(antecedent_list::iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+      appendAntecedentNodes(*itr, line_key);
+    return true;
+  }
+
+  appendNumber(rule.fingerprint(), 8, line_key);
+  if(rule.getName() != NULL) line_key += rule.getName();
+  line_key += '\0';
+  if(!appendTree(&consequent, line_key)) return false;
+  appendNumber(antecedents.size(), 4, line_key);
+  for(antecedent_list::iterator itr = antecedents.begin(); itr != antecedents.end(); itr++)
+    if(!appendAntecedent(*itr, line_key)) return false;
+  return true;
+}
+
+//Each node is one byte, and atom names can't contain '\0', so the preorder
+//sequence only reads back one way.
+bool VerificationCache::appendTree(StatementTree* tree, string& line_key)
+{
+  vector<StatementTree*> pending(1, tree);
+  while(!pending.empty())
+  {
+    StatementTree* node = pending.back();
+    pending.pop_back();
+    line_key += (char)(node->nodeType() * 2 + (node->isAffirmed() ? 1 : 0));
+    if(node->nodeType() == StatementTree::ATOM)
+    {
+      line_key += node->atomName();
+      line_key += '\0';
+    }
+    else
+    {
+      pending.push_back(node->begin()[StatementTree::RIGHT]);
+      pending.push_back(node->begin()[StatementTree::LEFT]);
+    }
+    if(line_key.size() > CACHE_KEY_LIMIT) return false;
+  }
+  return true;
+}
+
+//Lines are tagged 'L', subproofs 'S' and missing antecedents 'N', so one
+//can't be mistaken for another.
+bool VerificationCache::appendAntecedent(ProofStatement* antecedent, string& line_key)
+{
+  if(antecedent == NULL)
+  {
+    line_key += 'N';
+    return true;
+  }
+  statement_set* contents = antecedent->getSubproofContents();
+  if(contents == NULL)
+  {
+    line_key += 'L';
+    return appendTree(antecedent->getStatementData(), line_key);
+  }
+
+  line_key += 'S';
+  if(!appendTree(antecedent->getAssumption(), line_key)) return false;
+  vector<string> content_keys;
+  for(statement_set::iterator itr = contents->begin(); itr != contents->end(); itr++)
+  {
+    content_keys.push_back(string());
+    if(!appendAntecedent(*itr, content_keys.back())) return false;
+    if(line_key.size() + content_keys.back().size() > CACHE_KEY_LIMIT) return false;
+  }
+  std::sort(content_keys.begin(), content_keys.end());
+  appendNumber(content_keys.size(), 4, line_key);
+  for(unsigned int i = 0; i < content_keys.size(); i++)
+  {
+    line_key += content_keys[i];
+    if(line_key.size() > CACHE_KEY_LIMIT) return false;
+  }
+  return true;
+}
+
+//Tagged the same way as appendAntecedent.
+void VerificationCache::appendAntecedentNodes(ProofStatement* antecedent, string& line_key)
+{
+  if(antecedent == NULL)
+  {
+    line_key += 'N';
+    return;
+  }
+  statement_set* contents = antecedent->getSubproofContents();
+  if(contents == NULL)
+  {
+    line_key += 'L';
+    appendNumber((uintptr_t)antecedent->getStatementData(), sizeof(uintptr_t), line_key);
+    return;
+  }
+
+  line_key += 'S';
+  appendNumber((uintptr_t)antecedent->getAssumption(), sizeof(uintptr_t), line_key);
+  vector<string> content_keys;
+  for(statement_set::iterator itr = contents->begin(); itr != contents->end(); itr++)
+  {
+    content_keys.push_back(string());
+    appendAntecedentNodes(*itr, content_keys.back());
+  }
+  std::sort(content_keys.begin(), content_keys.end());
+  appendNumber(content_keys.size(), 4, line_key);
+  for(unsigned int i = 0; i < content_keys.size(); i++)
+    line_key += content_keys[i];
+}
+
+//Every node whose address appendAntecedentNodes writes.
+void VerificationCache::holdAntecedent(ProofStatement* antecedent, vector<StatementTree*>& held)
+{
+  if(antecedent == NULL) return;
+  statement_set* contents = antecedent->getSubproofContents();
+  if(contents == NULL)
+  {
+    held.push_back(StatementTree::create(*antecedent->getStatementData()));
+    return;
+  }
+
+  held.push_back(StatementTree::create(*antecedent->getAssumption()));
+  for(statement_set::iterator itr = contents->begin(); itr != contents->end(); itr++)
+    holdAntecedent(*itr, held);
+}
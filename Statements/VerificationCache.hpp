@@ -0,0 +1,188 @@
+#ifndef __VERIFICATION_CACHE_H_
+#define __VERIFICATION_CACHE_H_
+
+#include "StatementTree.hpp"
+#include "ProofStatement.hpp"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define CACHE_FILE_NAME "verification.cache"
+#define CACHE_FORMAT_VERSION 2
+#define CACHE_SHARD_COUNT 16 //Locked separately, so threads rarely wait on each other
+#define CACHE_KEY_LIMIT 65536 //Lines with longer keys aren't cached
+#define CACHE_MEMORY_ENTRIES 65536 //Per shard, for a cache that isn't opened
+
+/// <summary>
+/// One part of a VerificationCache, holding the keys that hash to it.
+/// </summary>
+struct cache_shard
+{
+  std::unordered_map<std::string, bool> results;
+  std::vector<std::pair<std::string, bool> > new_results; //Not saved yet
+  std::vector<StatementTree*> held; //References to the trees in node keys
+  std::mutex lock;
+};
+
+/// <summary>
+/// Results of checking proof lines, kept in a directory between runs. A proof
+/// that's checked again after a small edit (or a batch that's mostly the same
+/// as last time) then only has to work out the lines that changed.
+///
+/// Each result is stored under a key written out from everything the check
+/// depends on: the line's sentence, the name and fingerprint of its
+/// justification rule, and its antecedents in order, with subproof
+/// antecedents written as their assumption and contents. Sentences are
+/// written in full, so a result is only used for a line that's the same in
+/// every respect; a key is never trusted on a hash alone. Lines whose key
+/// would be longer than CACHE_KEY_LIMIT bytes aren't cached.
+///
+/// The file is a header followed by records of a key and its result, and new
+/// results are appended when the cache is saved.
+///
+/// A cache that isn't opened is kept in memory only, to skip lines repeated
+/// within one run. Trees are shared, so its keys are written from the
+/// addresses of the nodes instead, with the rule's id: the same line gives
+/// the same key without walking its sentences. The cache holds a reference
+/// to every node in its keys, so none of them can be freed and the address
+/// given to a different sentence while the key is in use. Each shard is
+/// emptied when it has CACHE_MEMORY_ENTRIES results, letting go of the
+/// nodes, so a long batch doesn't keep every proof's sentences.
+///
+/// Lookups and stores may be made from any thread, once the cache is opened
+/// (if it's going to be). Keys are split between
+/// CACHE_SHARD_COUNT shards with a lock each, so threads checking lines in
+/// parallel seldom wait for each other.
+/// </summary>
+class VerificationCache
+{
+  private:
+  cache_shard shards[CACHE_SHARD_COUNT];
+  std::string file_path;
+  bool file_valid; //The file exists with a matching header, so can be appended to
+  std::mutex file_lock; //Held while opening or saving, along with every shard's lock
+
+  /// <summary>
+  /// Finds the shard a key belongs to, by its hash.
+  /// </summary>
+  cache_shard& shardFor(const std::string& line_key);
+
+  /// <summary>
+  /// Locks (or unlocks) every shard, in order, for the whole cache to be
+  /// read or replaced.
+  /// </summary>
+  void lockShards();
+  void unlockShards();
+
+  /// <summary>
+  /// Empties a shard, giving back the references it holds. The shard's lock
+  /// must be held.
+  /// </summary>
+  /// <param name="shard">Shard to empty</param>
+  static void clearShard(cache_shard& shard);
+
+  /// <summary>
+  /// Helpers for open and save, which read or write the file with every
+  /// shard locked.
+  /// </summary>
+  bool readFile();
+  bool writeFile();
+
+  /// <summary>
+  /// Helper for key, writes out a sentence: each node in preorder as its
+  /// type and negation flag, with atoms followed by their name.
+  /// </summary>
+  /// <param name="tree">Sentence to write</param>
+  /// <param name="line_key">Key to append to</param>
+  /// <returns>False if the key got longer than CACHE_KEY_LIMIT</returns>
+  static bool appendTree(StatementTree* tree, std::string& line_key);
+
+  /// <summary>
+  /// Helper for key, writes out one antecedent. A subproof is written as its
+  /// assumption and its contents, with nested subproofs written the same
+  /// way. Contents are sorted, as they're stored unordered.
+  /// </summary>
+  /// <param name="antecedent">Antecedent line or subproof</param>
+  /// <param name="line_key">Key to append to</param>
+  /// <returns>False if the key got longer than CACHE_KEY_LIMIT</returns>
+  static bool appendAntecedent(ProofStatement* antecedent, std::string& line_key);
+
+  /// <summary>
+  /// Helper for key, writes out one antecedent for a node key: its node's
+  /// address, or for a subproof the assumption's address and its sorted
+  /// contents.
+  /// </summary>
+  /// <param name="antecedent">Antecedent line or subproof</param>
+  /// <param name="line_key">Key to append to</param>
+  static void appendAntecedentNodes(ProofStatement* antecedent, std::string& line_key);
+
+  /// <summary>
+  /// Helper for store, takes a reference to the trees of an antecedent, and
+  /// of a subproof's contents.
+  /// </summary>
+  /// <param name="antecedent">Antecedent line or subproof</param>
+  /// <param name="held">Trees held by the shard</param>
+  static void holdAntecedent(ProofStatement* antecedent, std::vector<StatementTree*>& held);
+
+  public:
+  VerificationCache();
+  ~VerificationCache();
+
+  /// <summary>
+  /// Uses the cache file in a directory, loading any results already in it.
+  /// The directory is created if it doesn't exist. A file that's missing or
+  /// from a different version of the format is treated as empty, and will be
+  /// replaced when saved.
+  /// </summary>
+  /// <param name="directory">Cache directory</param>
+  /// <returns>False if the directory can't be used</returns>
+  bool open(const char* directory);
+
+  /// <summary>
+  /// Writes results stored since the cache was opened or last saved.
+  /// </summary>
+  /// <returns>False if the file couldn't be written, or the cache was never opened</returns>
+  bool save();
+
+  /// <summary>
+  /// Finds a stored result.
+  /// </summary>
+  /// <param name="line_key">Key from key()</param>
+  /// <param name="result">Set to the stored result, if there is one</param>
+  /// <returns>True if there was a stored result</returns>
+  bool lookup(const std::string& line_key, bool& result);
+
+  /// <summary>
+  /// Stores a result, to be written out by the next save. If the cache isn't
+  /// opened, references are taken to the line's trees for as long as the
+  /// result is kept.
+  /// </summary>
+  /// <param name="line_key">Key from key()</param>
+  /// <param name="result">Whether the line was justified</param>
+  /// <param name="consequent">Sentence of the line</param>
+  /// <param name="antecedents">Antecedents of the line</param>
+  void store(const std::string& line_key, bool result, StatementTree& consequent,
+    antecedent_list& antecedents);
+
+  /// <summary>
+  /// Number of results in the cache, including ones not saved yet.
+  /// </summary>
+  /// <returns>Number of results</returns>
+  int size();
+
+  /// <summary>
+  /// Computes the key for checking a line: written out in full if the cache
+  /// is opened, otherwise from node addresses.
+  /// </summary>
+  /// <param name="consequent">Sentence of the line</param>
+  /// <param name="rule">Justification rule of the line</param>
+  /// <param name="antecedents">Antecedents of the line, in order</param>
+  /// <param name="line_key">Set to the key for the result</param>
+  /// <returns>False if the key is too long for the line to be cached</returns>
+  bool key(StatementTree& consequent, Justification& rule,
+    antecedent_list& antecedents, std::string& line_key);
+};
+
+#endif
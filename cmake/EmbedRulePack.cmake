@@ -0,0 +1,20 @@
+# Writes a rule pack (see RulePack) into a C++ source file as a byte array, so
+# the rules can be built into the program (see DefaultRules.hpp).
+# Run with cmake -DPACK_FILE=<rule pack> -DOUTPUT_FILE=<source to write> -P
+file(READ "${PACK_FILE}" pack_hex HEX)
+string(LENGTH "${pack_hex}" pack_hex_length)
+math(EXPR pack_size "${pack_hex_length} / 2")
+
+# 16 bytes to a line
+string(REGEX REPLACE "([0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f][0-9a-f])" "\\1\n  " pack_lines "${pack_hex}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," pack_bytes "${pack_lines}")
+
+file(WRITE "${OUTPUT_FILE}"
+"//Generated from ${PACK_FILE} when building; don't edit.
+#include \"DefaultRules.hpp\"
+
+const unsigned char default_rule_pack[] = {
+  ${pack_bytes}
+};
+const size_t default_rule_pack_size = ${pack_size};
+")